@@ -3,16 +3,29 @@
 #include <utility>
 #include <memory>
 #include <algorithm>
+#include <list>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
 #include <vector>
 #include <imgui_internal.h>
 #include <rosidl_typesupport_cpp/identifier.hpp>
 #include <rosidl_typesupport_introspection_cpp/identifier.hpp>
 #include "quickplot/config.hpp"
+#include "quickplot/domain.hpp"
 #include "quickplot/node.hpp"
+#include "quickplot/latency_view.hpp"
+#include "quickplot/memory_view.hpp"
+#include "quickplot/overload.hpp"
 #include "quickplot/plot_view.hpp"
 #include "quickplot/topic_list.hpp"
 #include "quickplot/resources.hpp"
+#include "quickplot/scheduler.hpp"
+#include "quickplot/shared_memory.hpp"
+#include "quickplot/socket_source.hpp"
+#include "quickplot/snapshot.hpp"
 #include <rcpputils/asserts.hpp>
 
 namespace fs = std::filesystem;
@@ -27,6 +40,14 @@ private:
   rclcpp::Event::SharedPtr graph_event_;
   rclcpp::JumpHandler::SharedPtr jump_handler_;
 
+  // runs background work of all nodes and of the application, instead of a thread per component
+  std::shared_ptr<TaskScheduler> scheduler_;
+
+  // nodes of other ROS domains referenced by sources, created on first use; declared before the
+  // plots, so subscriptions are released before their node
+  mutable std::mutex domain_nodes_mutex_;
+  std::map<size_t, std::unique_ptr<DomainNode>> domain_nodes_;
+
   // maps already-resolved full topic names to a single ROS type
   // assumes that all publishers on this topic publish the same message type
   TopicTypeMap available_topics_to_types_;
@@ -39,7 +60,62 @@ private:
   // list of plots to display
   std::vector<Plot> plots_;
 
-  void on_time_jump(const rcl_time_jump_t & time_jump)
+  SharedMemoryMode shared_memory_mode_;
+
+  // series exported to shared memory, only set in export mode
+  std::unique_ptr<SharedSeriesStore> shared_store_;
+
+  // reused across frames to copy samples imported from shared memory
+  std::vector<Sample> shared_samples_;
+  std::vector<ImPlotPoint> shared_points_;
+
+  // reused across frames to move pushed samples into the plot buffers
+  std::vector<Sample> push_samples_;
+  std::vector<ImPlotPoint> push_points_;
+  // one buffer per pushed series, shared by all series plotting it, since draining moves the
+  // samples out of the pushed series; expires when no series plots it anymore
+  std::unordered_map<std::string, std::weak_ptr<PlotDataBuffer>> push_buffers_;
+
+  // receives samples of processes which are not ROS nodes, only set if a socket is configured
+  std::unique_ptr<SocketSource> socket_source_;
+
+  bool show_latency_view_;
+  LatencyViewOptions latency_view_options_;
+
+  bool show_memory_view_;
+  size_t memory_budget_;
+  // collecting the report reads /proc, so it is refreshed at most once per second
+  MemoryReport memory_report_;
+  std::chrono::steady_clock::time_point memory_report_time_;
+
+  // history of the previous run, restored into the buffers of series with the same id
+  std::unique_ptr<Snapshot> snapshot_;
+  // seconds between snapshots of the history, zero to only save it at exit
+  double snapshot_period_;
+  std::chrono::steady_clock::time_point snapshot_time_;
+
+  // shared with the export tasks writing snapshots, which may outlive the application
+  struct SnapshotWriter
+  {
+    // serializes writes to the snapshot file
+    std::mutex mutex;
+    // a periodic snapshot is queued or being written
+    std::atomic<bool> pending{false};
+    // sequence number of the last collected snapshot
+    std::atomic<uint64_t> collected{0};
+    // sequence number of the last written snapshot, guarded by mutex; a periodic snapshot which
+    // is still queued when the exit snapshot is saved must not overwrite it
+    uint64_t written = 0;
+  };
+  std::shared_ptr<SnapshotWriter> snapshot_writer_;
+
+  double reorder_window_;
+
+  // thins low priority topics while ingestion is over budget, unset if shedding is disabled
+  std::unique_ptr<OverloadController> overload_controller_;
+  std::chrono::steady_clock::time_point shedding_time_;
+
+  static void on_time_jump(QuickPlotNode & node, const rcl_time_jump_t & time_jump)
   {
     if (time_jump.clock_change == RCL_ROS_TIME_ACTIVATED ||
       time_jump.clock_change == RCL_ROS_TIME_DEACTIVATED)
@@ -50,15 +126,131 @@ private:
       // fix merged with https://github.com/ros2/rcl/pull/948 and should be in ROS Humble
       std::cerr << "time jump by a delta of " << time_jump.delta.nanoseconds << "ns";
     }
-    std::cerr << ", clearing all data" << std::endl;
-    clear();
+    std::cerr << ", clearing data of " << node.get_fully_qualified_name();
+    auto domain_id = node.domain_id();
+    if (domain_id.has_value()) {
+      std::cerr << " in domain " << domain_id.value();
+    }
+    std::cerr << std::endl;
+    node.clear();
+  }
+
+  // clear the data received by the node when its clock jumps, e.g. when a simulation restarts;
+  // nodes of other domains keep their data, since their clocks are independent
+  static rclcpp::JumpHandler::SharedPtr create_jump_handler(QuickPlotNode & node)
+  {
+    return node.get_clock()->create_jump_callback(
+      [] {}, [&node](const rcl_time_jump_t & time_jump) {on_time_jump(node, time_jump);},
+      rcl_jump_threshold_t {
+        .on_clock_change = true,
+        .min_forward = {
+          .nanoseconds = RCUTILS_S_TO_NS(10),
+        },
+        .min_backward = {
+          .nanoseconds = -1,
+        },
+      });
+  }
+
+  // node subscribing in the domain, nullopt for the domain of this process
+  std::shared_ptr<QuickPlotNode> node_for(std::optional<size_t> domain_id)
+  {
+    if (!domain_id.has_value()) {
+      return node_;
+    }
+    std::unique_lock<std::mutex> lock(domain_nodes_mutex_);
+    auto & domain_node = domain_nodes_[domain_id.value()];
+    if (!domain_node) {
+      domain_node = std::make_unique<DomainNode>(
+        domain_id.value(), domain_node_parameters(*node_), scheduler_);
+      domain_node->set_jump_handler(create_jump_handler(*domain_node->node()));
+    }
+    return domain_node->node();
+  }
+
+  // domains referenced by the sources and patterns of the configuration
+  static std::set<size_t> referenced_domains(const ApplicationConfig & config)
+  {
+    std::set<size_t> domains;
+    auto add = [&domains](std::optional<size_t> domain_id) {
+        if (domain_id.has_value()) {
+          domains.insert(domain_id.value());
+        }
+      };
+    for (const auto & plot_config : config.plots) {
+      for (const auto & series_config : plot_config.series) {
+        add(series_config.source.domain_id);
+        if (series_config.stddev_source.has_value()) {
+          add(series_config.stddev_source->domain_id);
+        }
+      }
+      for (const auto & pattern_config : plot_config.patterns) {
+        add(pattern_config.domain_id);
+      }
+    }
+    return domains;
+  }
+
+  // destroy the nodes of domains which are not referenced anymore, and forget their topics;
+  // their series must be released already
+  void release_domain_nodes(const std::set<size_t> & referenced)
+  {
+    std::vector<std::unique_ptr<DomainNode>> released;
+    {
+      std::unique_lock<std::mutex> lock(domain_nodes_mutex_);
+      for (auto it = domain_nodes_.begin(); it != domain_nodes_.end(); ) {
+        if (referenced.count(it->first) == 0) {
+          released.push_back(std::move(it->second));
+          it = domain_nodes_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    if (released.empty()) {
+      return;
+    }
+    for (auto it = available_topics_to_types_.begin(); it != available_topics_to_types_.end(); ) {
+      auto domain_id = split_qualified_topic_name(it->first).first;
+      if (domain_id.has_value() && referenced.count(domain_id.value()) == 0) {
+        it = available_topics_to_types_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    // joining their threads happens without holding domain_nodes_mutex_
+    released.clear();
+  }
+
+  std::vector<std::shared_ptr<QuickPlotNode>> domain_nodes() const
+  {
+    std::unique_lock<std::mutex> lock(domain_nodes_mutex_);
+    std::vector<std::shared_ptr<QuickPlotNode>> nodes;
+    for (const auto & [_, domain_node] : domain_nodes_) {
+      nodes.push_back(domain_node->node());
+    }
+    return nodes;
+  }
+
+  // whether a node subscribes to the qualified topic name
+  bool is_subscribed_to(const std::string & qualified_topic)
+  {
+    auto [domain_id, topic] = split_qualified_topic_name(qualified_topic);
+    if (!domain_id.has_value()) {
+      return node_->is_subscribed_to(topic);
+    }
+    std::unique_lock<std::mutex> lock(domain_nodes_mutex_);
+    auto it = domain_nodes_.find(domain_id.value());
+    return it != domain_nodes_.end() && it->second->node()->is_subscribed_to(topic);
   }
 
   SourceInfo source_from_config(const DataSourceConfig & config) const
   {
     DataSourceConfig config_cpy = config;
-    config_cpy.topic_name =
-      node_->get_node_topics_interface()->resolve_topic_name(config.topic_name);
+    if (config.kind == DataSourceKind::Topic) {
+      config_cpy.topic_name =
+        node_->get_node_topics_interface()->resolve_topic_name(config.topic_name);
+    }
     return SourceInfo {
       .config = config_cpy,
       .error = DataSourceError::None,
@@ -74,6 +266,7 @@ private:
     if (config.stddev_source.has_value()) {
       series.stddev_source = source_from_config(config.stddev_source.value());
     }
+    series.priority = config.priority;
     return {series, config.axis};
   }
 
@@ -84,6 +277,34 @@ private:
       config.series.begin(), config.series.end(), std::back_inserter(
         plot.series), std::bind(&Application::series_from_config, this, std::placeholders::_1));
     plot.axes = config.axes;
+    for (const auto & pattern : config.patterns) {
+      plot.patterns.push_back(TopicPattern {
+          .config = pattern,
+          .regex = std::regex(pattern.topic_pattern),
+        });
+      if (pattern.aggregate.has_value()) {
+        auto id = aggregate_series_id(pattern);
+        auto aggregate = std::make_shared<AggregateSeries>(id, pattern.aggregate.value());
+        TimeSeries series;
+        series.id = id;
+        series.source = ActiveDataSource {
+          .warning = DataWarning::None,
+          .subscription = nullptr,
+          .accessor = MessageAccessor {
+            .member = {},
+            .op = pattern.op,
+          },
+          .data = aggregate->data(),
+          .shared = nullptr,
+          .aggregate = aggregate,
+          .pushed = nullptr,
+          .channel = "",
+        };
+        series.from_pattern = true;
+        series.priority = pattern.priority;
+        plot.series.emplace_back(std::move(series), pattern.axis);
+      }
+    }
 
     int max_axis = 0;
     for (const auto & [_, axis] : plot.series) {
@@ -91,6 +312,11 @@ private:
         max_axis = axis;
       }
     }
+    for (const auto & pattern : config.patterns) {
+      if (pattern.axis > max_axis) {
+        max_axis = pattern.axis;
+      }
+    }
     plot.axes.resize(
       static_cast<size_t>(max_axis + 1), AxisConfig {
         .y_min = -1.0,
@@ -103,29 +329,155 @@ public:
   explicit Application(std::shared_ptr<QuickPlotNode> _node)
   : node_(_node), history_length_(1.0), plots_()
   {
+    scheduler_ = std::make_shared<TaskScheduler>(
+      static_cast<size_t>(node_->get_parameter("scheduler_threads").as_int()));
+    node_->set_scheduler(scheduler_);
+
+    shared_memory_mode_ = parse_shared_memory_mode(
+      node_->get_parameter("shared_memory").as_string());
+    if (shared_memory_mode_ == SharedMemoryMode::Export) {
+      shared_store_ = std::make_unique<SharedSeriesStore>(
+        static_cast<size_t>(node_->get_parameter("shared_memory_capacity").as_int()));
+    }
+
+    show_latency_view_ = node_->get_parameter("latency_view").as_bool();
+    latency_view_options_.plot_stamp_to_draw = false;
+    show_memory_view_ = node_->get_parameter("memory_view").as_bool();
+    memory_budget_ = static_cast<size_t>(node_->get_parameter("memory_budget_mb").as_int()) *
+      1000000;
+
+    if (node_->get_parameter("snapshot").as_bool()) {
+      snapshot_ = Snapshot::open(get_default_snapshot_path());
+    }
+    snapshot_period_ = node_->get_parameter("snapshot_period").as_double();
+    snapshot_time_ = std::chrono::steady_clock::now();
+    snapshot_writer_ = std::make_shared<SnapshotWriter>();
+    reorder_window_ = node_->get_parameter("reorder_window").as_double();
+
+    auto ingest_budget = node_->get_parameter("ingest_budget").as_double();
+    if (ingest_budget > 0.0) {
+      overload_controller_ = std::make_unique<OverloadController>(
+        ingest_budget, static_cast<size_t>(node_->get_parameter("shedding_backlog").as_int()));
+    }
+    shedding_time_ = std::chrono::steady_clock::now();
+
+    auto socket_endpoint = node_->get_parameter("socket").as_string();
+    if (!socket_endpoint.empty()) {
+      try {
+        socket_source_ = std::make_unique<SocketSource>(
+          socket_endpoint,
+          static_cast<size_t>(node_->get_parameter("socket_batch_size").as_int()),
+          std::make_shared<NodeIngestClock>(node_->get_clock()));
+      } catch (const socket_error & e) {
+        std::cerr << "failed to open socket source: " << e.what() << std::endl;
+      }
+    }
+
     graph_event_ = node_->get_graph_event();
     graph_event_->set(); // set manually to trigger initial topics query
 
-    jump_handler_ = node_->get_clock()->create_jump_callback(
-      [] {}, std::bind(&Application::on_time_jump, this, _1), rcl_jump_threshold_t {
-        .on_clock_change = true,
-        .min_forward = {
-          .nanoseconds = RCUTILS_S_TO_NS(10),
-        },
-        .min_backward = {
-          .nanoseconds = -1,
-        },
-      });
+    jump_handler_ = create_jump_handler(*node_);
+  }
+
+  // config of a running source, nullopt if it failed to initialize and should be retried
+  static std::optional<DataSourceConfig> running_source_config(const DataSource & source)
+  {
+    auto active = std::get_if<ActiveDataSource>(&source);
+    if (active) {
+      return source_to_config(*active);
+    }
+    const auto & info = std::get<SourceInfo>(source);
+    if (info.error != DataSourceError::None) {
+      return std::nullopt;
+    }
+    return info.config;
+  }
+
+  // sources of a running series on axis 0, to find it in a new configuration
+  static std::optional<TimeSeriesConfig> running_series_key(const TimeSeries & series)
+  {
+    auto source = running_source_config(series.source);
+    auto stddev_source = running_source_config(series.stddev_source);
+    if (!source.has_value() || !stddev_source.has_value()) {
+      return std::nullopt;
+    }
+    TimeSeriesConfig key {
+      .source = source.value(),
+      .stddev_source = std::nullopt,
+      .axis = 0,
+      .priority = SeriesPriority::Normal,
+    };
+    // series without standard deviation have an empty stddev source
+    if (!stddev_source->topic_name.empty()) {
+      key.stddev_source = stddev_source;
+    }
+    return key;
   }
 
-  void apply_config(ApplicationConfig config)
+  /**
+   * Apply the configuration to the running plots. Series with unchanged sources are moved to
+   * their new plot and axis, keeping their buffers and subscriptions, so reloading a
+   * configuration does not lose their data.
+   */
+  void apply_config(const ApplicationConfig & config)
   {
-    plots_.clear();
+    // discover the topics of referenced domains; their series initialize on the next update
+    auto domains = referenced_domains(config);
+    for (auto domain_id : domains) {
+      node_for(domain_id);
+    }
+    std::list<TimeSeries> running;
+    std::unordered_multimap<TimeSeriesConfig, std::list<TimeSeries>::iterator> running_index;
+    for (auto & plot : plots_) {
+      for (auto & [series, _] : plot.series) {
+        auto key = running_series_key(series);
+        running.push_back(std::move(series));
+        if (key.has_value()) {
+          running_index.emplace(key.value(), std::prev(running.end()));
+        }
+      }
+    }
+    std::vector<Plot> plots;
+    plots.reserve(config.plots.size());
     std::transform(
-      config.plots.begin(), config.plots.end(), std::back_inserter(plots_),
+      config.plots.begin(), config.plots.end(), std::back_inserter(plots),
       std::bind(&Application::plot_from_config, this, std::placeholders::_1));
+    for (auto & plot : plots) {
+      // series of matching topics are added before matching, to keep their buffers as well
+      expand_patterns(plot);
+      for (auto & [series, _] : plot.series) {
+        auto key = running_series_key(series);
+        if (!key.has_value()) {
+          continue;
+        }
+        auto it = running_index.find(key.value());
+        if (it != running_index.end()) {
+          auto from_pattern = series.from_pattern;
+          auto priority = series.priority;
+          series = std::move(*it->second);
+          series.from_pattern = from_pattern;
+          series.priority = priority;
+          running.erase(it->second);
+          running_index.erase(it);
+        } else {
+          initialize_aggregate_output(series);
+        }
+      }
+    }
+    // series which are not in the configuration anymore release their subscriptions here
+    plots_ = std::move(plots);
+    running.clear();
+    release_domain_nodes(domains);
     history_length_ = config.history_length;
     initialize_pending_sources();
+    for (auto & plot : plots_) {
+      expand_aggregates(plot);
+    }
+  }
+
+  const std::vector<Plot> & plots() const
+  {
+    return plots_;
   }
 
   ApplicationConfig get_config() const
@@ -138,9 +490,116 @@ public:
     return config;
   }
 
-  std::optional<ActiveDataSource> try_initialize_source(SourceInfo & source_info)
+  // mirror the buffer to shared memory, if this process exports its series
+  void export_buffer(const std::string & id, const std::string & topic, PlotDataBuffer & buffer)
+  {
+    if (!shared_store_) {
+      return;
+    }
+    try {
+      auto writer = shared_store_->export_series(id, topic);
+      if (writer) {
+        buffer.export_to(writer);
+      }
+    } catch (const shared_memory_error & e) {
+      std::cerr << "failed to export " << id << ": " << e.what() << std::endl;
+    }
+  }
+
+  // prepend the history of the previous run, if the snapshot contains this series
+  void restore_buffer(const std::string & id, PlotDataBuffer & buffer)
+  {
+    if (!snapshot_) {
+      return;
+    }
+    auto [samples, count] = snapshot_->find(id);
+    if (count != 0) {
+      buffer.restore(samples, count);
+    }
+  }
+
+  /**
+   * Import the output of a new aggregate series from the process exporting it, or else restore
+   * its history and export it. Its members are aggregated by this process in either case, unless
+   * the output is imported.
+   */
+  void initialize_aggregate_output(TimeSeries & series)
+  {
+    auto active = std::get_if<ActiveDataSource>(&series.source);
+    if (!active || !active->aggregate) {
+      return;
+    }
+    if (shared_memory_mode_ == SharedMemoryMode::Import) {
+      active->shared = SharedSeriesReader::open(series.id);
+      if (active->shared) {
+        return;
+      }
+    }
+    if (snapshot_) {
+      auto [samples, count] = snapshot_->find(series.id);
+      active->aggregate->restore(samples, count);
+    }
+    export_buffer(series.id, series.id, *active->data);
+  }
+
+  // series of a socket channel or pushed series; socket channels are pending until a socket
+  // source is configured
+  std::optional<ActiveDataSource> try_initialize_channel_source(const SourceInfo & source_info)
   {
-    auto type_it = available_topics_to_types_.find(source_info.config.topic_name);
+    const auto & name = source_info.config.topic_name;
+    ActiveDataSource active {
+      .warning = DataWarning::None,
+      .subscription = nullptr,
+      .accessor = MessageAccessor {
+        .member = {},
+        .op = DataSourceOperator::Identity,
+      },
+      .data = nullptr,
+      .shared = nullptr,
+      .aggregate = nullptr,
+      .pushed = nullptr,
+      .channel = name,
+    };
+    if (source_info.config.kind == DataSourceKind::Socket) {
+      if (!socket_source_) {
+        return std::nullopt;
+      }
+      active.data = socket_source_->channel(name);
+      active.data->set_reorder_window(reorder_window_);
+      return active;
+    }
+    auto id = series_id(source_info.config);
+    if (shared_memory_mode_ == SharedMemoryMode::Import) {
+      active.shared = SharedSeriesReader::open(id);
+      if (active.shared) {
+        active.data = std::make_shared<PlotDataBuffer>(1);
+        active.data->set_reorder_window(reorder_window_);
+        return active;
+      }
+    }
+    active.pushed = read_push_series(name);
+    auto & push_buffer = push_buffers_[name];
+    active.data = push_buffer.lock();
+    if (!active.data) {
+      active.data = std::make_shared<PlotDataBuffer>(1);
+      active.data->set_reorder_window(reorder_window_);
+      push_buffer = active.data;
+      export_buffer(id, name, *active.data);
+    }
+    return active;
+  }
+
+  // members of an aggregate forward their samples to it, so their buffers are neither restored
+  // nor exported
+  std::optional<ActiveDataSource> try_initialize_source(
+    SourceInfo & source_info,
+    bool aggregate_member = false)
+  {
+    if (source_info.config.kind != DataSourceKind::Topic) {
+      return try_initialize_channel_source(source_info);
+    }
+    auto type_it = available_topics_to_types_.find(
+      qualified_topic_name(source_info.config.domain_id, source_info.config.topic_name));
     if (type_it != available_topics_to_types_.end()) {
       // if type is known, initialize and set ready state
       const auto & [topic, type_info] = *type_it;
@@ -148,20 +607,51 @@ public:
       if (introspection_opt) {
         auto introspection = *introspection_opt;
         try {
-          auto member_opt = introspection->get_member_sequence_path(source_info.config.member_path);
+          auto member_opt = introspection_cache_.member_path(
+            introspection, source_info.config.member_path);
           if (member_opt.has_value()) {
-            auto subscription = node_->get_or_create_subscription(topic, introspection);
             auto member = member_opt.value();
             MessageAccessor accessor {
               .member = member,
               .op = source_info.config.op,
+              .key = introspection->get_sequence_key(source_info.config.member_path, member),
             };
+            if (shared_memory_mode_ == SharedMemoryMode::Import) {
+              auto reader = SharedSeriesReader::open(series_id(topic, accessor));
+              if (reader) {
+                auto buffer = std::make_shared<PlotDataBuffer>(1);
+                buffer->set_run_length(is_state(accessor));
+                buffer->set_reorder_window(reorder_window_);
+                return ActiveDataSource {
+                  .warning = DataWarning::None,
+                  .subscription = nullptr,
+                  .accessor = accessor,
+                  .data = buffer,
+                  .shared = reader,
+                  .aggregate = nullptr,
+                  .pushed = nullptr,
+                  .channel = "",
+                };
+              }
+              // no other process exports the series, so fall back to subscribing
+            }
+            auto subscription = node_for(source_info.config.domain_id)->get_or_create_subscription(
+              source_info.config.topic_name, introspection, source_info.config.qos);
             auto buffer = subscription->add_source(accessor);
+            buffer->set_reorder_window(reorder_window_);
+            if (!aggregate_member) {
+              restore_buffer(series_id(topic, accessor), *buffer);
+              export_buffer(series_id(topic, accessor), topic, *buffer);
+            }
             return ActiveDataSource {
               .warning = DataWarning::None,
               .subscription = subscription,
               .accessor = accessor,
               .data = buffer,
+              .shared = nullptr,
+              .aggregate = nullptr,
+              .pushed = nullptr,
+              .channel = "",
             };
           } else {
             source_info.error = DataSourceError::InvalidMember;
@@ -198,6 +688,101 @@ public:
     }
   }
 
+  // add a series for each available topic which matches a pattern of the plot, and whose type
+  // has the member of the pattern; series removed by the user are not added again
+  void expand_patterns(Plot & plot)
+  {
+    if (plot.patterns.empty()) {
+      return;
+    }
+    std::unordered_set<std::string> ids(plot.removed_series);
+    for (const auto & [series, _] : plot.series) {
+      ids.insert(series.id);
+    }
+    for (const auto & pattern : plot.patterns) {
+      if (pattern.config.aggregate.has_value()) {
+        continue;
+      }
+      for (const auto & [qualified_topic, type_info] : available_topics_to_types_) {
+        auto [domain_id, topic] = split_qualified_topic_name(qualified_topic);
+        if (domain_id != pattern.config.domain_id || !std::regex_match(topic, pattern.regex)) {
+          continue;
+        }
+        auto introspection = std::get_if<MessageIntrospectionPtr>(&type_info);
+        if (!introspection ||
+          !introspection_cache_.member_path(*introspection, pattern.config.member_path))
+        {
+          continue;
+        }
+        auto [series, axis] = series_from_config(
+          TimeSeriesConfig {
+            .source = DataSourceConfig {
+              .topic_name = topic,
+              .member_path = pattern.config.member_path,
+              .op = pattern.config.op,
+              .qos = pattern.config.qos,
+              .domain_id = domain_id,
+              .kind = DataSourceKind::Topic,
+            },
+            .stddev_source = std::nullopt,
+            .axis = pattern.config.axis,
+            .priority = pattern.config.priority,
+          });
+        if (ids.insert(series.id).second) {
+          series.from_pattern = true;
+          plot.series.emplace_back(std::move(series), axis);
+        }
+      }
+    }
+  }
+
+  // subscribe the aggregate series of the plot to the available topics matching their pattern
+  void expand_aggregates(Plot & plot)
+  {
+    for (const auto & pattern : plot.patterns) {
+      if (!pattern.config.aggregate.has_value()) {
+        continue;
+      }
+      auto id = aggregate_series_id(pattern.config);
+      auto series_it = std::find_if(
+        plot.series.begin(), plot.series.end(), [&id](const auto & item) {
+          return item.first.id == id;
+        });
+      if (series_it == plot.series.end()) {
+        // removed by the user
+        continue;
+      }
+      const auto & active = std::get<ActiveDataSource>(series_it->first.source);
+      if (active.shared) {
+        // the output is imported from the process aggregating the topics
+        continue;
+      }
+      auto aggregate = active.aggregate;
+      for (const auto & [qualified_topic, _] : available_topics_to_types_) {
+        auto [domain_id, topic] = split_qualified_topic_name(qualified_topic);
+        if (domain_id != pattern.config.domain_id || aggregate->has_member(qualified_topic) ||
+          !std::regex_match(topic, pattern.regex))
+        {
+          continue;
+        }
+        auto source_info = source_from_config(
+          DataSourceConfig {
+            .topic_name = topic,
+            .member_path = pattern.config.member_path,
+            .op = pattern.config.op,
+            .qos = pattern.config.qos,
+            .domain_id = domain_id,
+            .kind = DataSourceKind::Topic,
+          });
+        auto member = try_initialize_source(source_info, true);
+        if (member.has_value()) {
+          aggregate->add_member(
+            qualified_topic, member->subscription, member->data, member->shared);
+        }
+      }
+    }
+  }
+
   void initialize_pending_sources()
   {
     for (auto & plot : plots_) {
@@ -207,40 +792,67 @@ public:
     }
   }
 
+  // add topics discovered by the node of a domain, keyed by their qualified name
+  void add_available_topics(
+    const std::map<std::string, std::vector<std::string>> & topics_and_types,
+    std::optional<size_t> domain_id)
+  {
+    for (const auto & [unqualified_topic, types] : topics_and_types) {
+      auto topic = qualified_topic_name(domain_id, unqualified_topic);
+      if (types.size() != 1) {
+        std::cerr << "topic " << topic << " has multiple types and will be ignored" <<
+          std::endl;
+        continue;
+      }
+      auto new_type = types[0];
+      auto it = available_topics_to_types_.find(topic);
+      if (it != available_topics_to_types_.end()) {
+        const auto & [_, type_info] = *it;
+        // the topic was already in the map, so we possibly have active listeners
+        // parsing a message type that may have changed
+        if (new_type.compare(get_message_type(type_info)) != 0) {
+          std::invalid_argument("type of topic " + topic + " changed");
+        }
+      } else {
+        // for new topics, load their introspection support
+        try {
+          auto introspection = introspection_cache_.load(new_type);
+          available_topics_to_types_.emplace(topic, introspection);
+        } catch (const introspection_error & e) {
+          available_topics_to_types_.emplace(
+            topic, MessageTypeError {
+              .message_type = new_type,
+              .error_message = e.what(),
+            });
+        }
+      }
+    }
+  }
+
   void update_topics()
   {
+    bool changed = false;
     if (graph_event_->check_and_clear()) {
-      auto topics_and_types = node_->get_topic_names_and_types();
-      for (const auto & [topic, types] : topics_and_types) {
-        if (types.size() != 1) {
-          std::cerr << "topic " << topic << " has multiple types and will be ignored" <<
-            std::endl;
-          continue;
-        }
-        auto new_type = types[0];
-        auto it = available_topics_to_types_.find(topic);
-        if (it != available_topics_to_types_.end()) {
-          const auto & [_, type_info] = *it;
-          // the topic was already in the map, so we possibly have active listeners
-          // parsing a message type that may have changed
-          if (new_type.compare(get_message_type(type_info)) != 0) {
-            std::invalid_argument("type of topic " + topic + " changed");
-          }
-        } else {
-          // for new topics, load their introspection support
-          try {
-            auto introspection = introspection_cache_.load(new_type);
-            available_topics_to_types_.emplace(topic, introspection);
-          } catch (const introspection_error & e) {
-            available_topics_to_types_.emplace(
-              topic, MessageTypeError {
-                .message_type = new_type,
-                .error_message = e.what(),
-              });
-          }
+      add_available_topics(node_->get_topic_names_and_types(), std::nullopt);
+      changed = true;
+    }
+    {
+      std::lock_guard<std::mutex> lock(domain_nodes_mutex_);
+      for (auto & [domain_id, domain_node] : domain_nodes_) {
+        if (domain_node->graph_event()->check_and_clear()) {
+          add_available_topics(domain_node->node()->get_topic_names_and_types(), domain_id);
+          changed = true;
         }
       }
+    }
+    if (changed) {
+      for (auto & plot : plots_) {
+        expand_patterns(plot);
+      }
       initialize_pending_sources();
+      for (auto & plot : plots_) {
+        expand_aggregates(plot);
+      }
     }
   }
 
@@ -271,7 +883,11 @@ public:
     //    In this case all data would be outside the view window, with much larger timestamps, and slowly accumulate
     if (!clock_issue_likely) {
       auto data = buffer.data();
-      clock_issue_likely = std::all_of(
+      // a state which started before the window is still shown if it lasted into the window
+      auto run_end = data->run_end();
+      bool run_in_window = run_end.has_value() && run_end.value() >= start_sec &&
+        run_end.value() <= end_sec;
+      clock_issue_likely = !run_in_window && std::all_of(
         data->begin(), data->end(),
         [start_sec, end_sec](const ImPlotPoint & item) {
           return item.x < start_sec || item.x > end_sec;
@@ -285,10 +901,47 @@ public:
     return std::nullopt;
   }
 
+  void import_shared_samples(SharedSeriesReader & reader, PlotDataBuffer & buffer)
+  {
+    if (reader.cleared()) {
+      buffer.clear();
+    }
+    shared_samples_.clear();
+    if (reader.read(shared_samples_) == 0) {
+      return;
+    }
+    const auto * begin = reinterpret_cast<const ImPlotPoint *>(shared_samples_.data());
+    shared_points_.assign(begin, begin + shared_samples_.size());
+    buffer.push_batch(shared_points_);
+  }
+
+  void drain_pushed_samples(ActiveDataSource & active)
+  {
+    push_samples_.clear();
+    if (active.pushed->drain(push_samples_) == 0) {
+      return;
+    }
+    const auto * begin = reinterpret_cast<const ImPlotPoint *>(push_samples_.data());
+    push_points_.assign(begin, begin + push_samples_.size());
+    active.data->push_batch(push_points_);
+  }
+
   void update_data_source(DataSource & source, const PlotViewOptions & plot_opts)
   {
     auto active = std::get_if<ActiveDataSource>(&source);
     if (active) {
+      if (active->shared) {
+        import_shared_samples(*active->shared, *active->data);
+      }
+      if (active->aggregate) {
+        // imported members forward the samples to the aggregate
+        for (const auto & [reader, buffer] : active->aggregate->imported_members()) {
+          import_shared_samples(*reader, *buffer);
+        }
+      }
+      if (active->pushed) {
+        drain_pushed_samples(*active);
+      }
       auto new_warning = prune_and_detect_clock_issues(*active->data, plot_opts);
       if (new_warning.has_value()) {
         active->warning = new_warning.value();
@@ -296,31 +949,264 @@ public:
     }
   }
 
-  void update()
+  PlotViewOptions plot_options() const
   {
-    update_topics();
-    auto payload = TopicList(available_topics_to_types_, plots_, node_);
-    if (payload.has_value()) {
-      add_topic_field_to_plot(payload.value());
-    }
-
     auto t = node_->now();
     auto history_dur = rclcpp::Duration::from_seconds(history_length_);
 
-    auto plot_opts = PlotViewOptions {
+    return PlotViewOptions {
       .use_sim_time = node_->get_parameter("use_sim_time").as_bool(),
       .t_start = t - history_dur,
       .t_end = t,
     };
+  }
 
-    // prune all data to time window of plot
+  // prune all data to time window of plot
+  void update_data_sources(const PlotViewOptions & plot_opts)
+  {
     for (auto & plot : plots_) {
       for (auto & [series, _] : plot.series) {
         update_data_source(series.source, plot_opts);
         update_data_source(series.stddev_source, plot_opts);
       }
     }
+  }
+
+  // update topics and data without rendering, for headless ingest
+  void update_headless()
+  {
+    update_topics();
+    update_data_sources(plot_options());
+    update_snapshot();
+    update_load_shedding();
+  }
+
+  /**
+   * Measure the ingest load of all subscriptions once per SHEDDING_PERIOD, and apply the
+   * decimation of the overload controller to them. A subscription takes the highest priority of
+   * the series it feeds, so a topic is only thinned if all of its series may be.
+   */
+  void update_load_shedding()
+  {
+    static constexpr std::chrono::milliseconds SHEDDING_PERIOD {500};
+    auto now = std::chrono::steady_clock::now();
+    if (!overload_controller_ || now - shedding_time_ < SHEDDING_PERIOD) {
+      return;
+    }
+    auto period = std::chrono::duration<double>(now - shedding_time_).count();
+    shedding_time_ = now;
+    std::unordered_map<std::shared_ptr<PlotSubscription>, SeriesPriority> priorities;
+    auto raise = [&priorities](const auto & subscription, SeriesPriority priority) {
+        auto [it, inserted] = priorities.emplace(subscription, priority);
+        if (!inserted && priority > it->second) {
+          it->second = priority;
+        }
+      };
+    for (const auto & plot : plots_) {
+      for (const auto & [series, _] : plot.series) {
+        for (const auto * source : {&series.source, &series.stddev_source}) {
+          auto active = std::get_if<ActiveDataSource>(source);
+          if (!active) {
+            continue;
+          }
+          if (active->subscription) {
+            raise(active->subscription, series.priority);
+          }
+          if (active->aggregate) {
+            for (const auto & subscription : active->aggregate->member_subscriptions()) {
+              raise(subscription, series.priority);
+            }
+          }
+        }
+      }
+    }
+    std::vector<std::shared_ptr<PlotSubscription>> subscriptions;
+    std::vector<IngestLoad> loads;
+    for (const auto & [subscription, priority] : priorities) {
+      subscriptions.push_back(subscription);
+      loads.push_back(
+        IngestLoad {
+          .priority = priority,
+          .busy = std::chrono::duration<double>(subscription->take_busy_time()).count(),
+          .backlog = subscription->backlog(),
+        });
+    }
+    overload_controller_->update(loads, period);
+    for (size_t i = 0; i < subscriptions.size(); i++) {
+      subscriptions[i]->set_shedding(
+        loads[i].priority, loads[i].busy / period,
+        overload_controller_->decimation(loads[i].priority));
+    }
+  }
+
+  // save the snapshot if the snapshot period elapsed
+  void update_snapshot()
+  {
+    if (!node_->get_parameter("snapshot").as_bool() || snapshot_period_ <= 0.0) {
+      return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - snapshot_time_ < std::chrono::duration<double>(snapshot_period_)) {
+      return;
+    }
+    snapshot_time_ = now;
+    // skip this period if the previous snapshot is still being written
+    if (snapshot_writer_->pending.exchange(true)) {
+      return;
+    }
+    // the samples are copied on this thread, the file is written by an export task
+    auto series_list = collect_snapshot();
+    auto sequence = ++snapshot_writer_->collected;
+    scheduler_->submit(
+      TaskPriority::Export,
+      [writer = snapshot_writer_, series_list = std::move(series_list), sequence] {
+        write_snapshot_file(*writer, series_list, sequence);
+        writer->pending = false;
+      });
+  }
+
+  // skips the write if a snapshot collected later was written already
+  static void write_snapshot_file(
+    SnapshotWriter & writer, const std::vector<SnapshotSeries> & series_list, uint64_t sequence)
+  {
+    std::unique_lock<std::mutex> lock(writer.mutex);
+    if (sequence <= writer.written) {
+      return;
+    }
+    writer.written = sequence;
+    auto path = get_default_snapshot_path();
+    try {
+      fs::create_directories(path.parent_path());
+      write_snapshot(path, series_list);
+    } catch (const std::exception & e) {
+      std::cerr << "failed to save snapshot to " << path << ": " << e.what() << std::endl;
+    }
+  }
+
+  // history of all series received by this process
+  std::vector<SnapshotSeries> collect_snapshot() const
+  {
+    auto t_start = node_->now().seconds() - history_length_;
+    std::vector<SnapshotSeries> series_list;
+    std::set<std::string> ids;
+    auto add = [&](const DataSource & source) {
+        auto active = std::get_if<ActiveDataSource>(&source);
+        // imported series are saved by the process which exports them
+        if (!active || active->shared || (!active->subscription && !active->aggregate)) {
+          return;
+        }
+        auto id = active->aggregate ? active->aggregate->name() :
+          series_id(active->subscription->topic_name(), active->accessor);
+        if (ids.insert(id).second) {
+          series_list.push_back({id, active->data->snapshot(t_start)});
+        }
+      };
+    for (const auto & plot : plots_) {
+      for (const auto & [series, _] : plot.series) {
+        add(series.source);
+        add(series.stddev_source);
+      }
+    }
+    return series_list;
+  }
+
+  /**
+   * Write the history of all series received by this process to the snapshot file, to be
+   * restored by the next run.
+   */
+  void save_snapshot() const
+  {
+    auto series_list = collect_snapshot();
+    write_snapshot_file(*snapshot_writer_, series_list, ++snapshot_writer_->collected);
+  }
+
+  void update()
+  {
+    update_topics();
+    auto payload = TopicList(
+      available_topics_to_types_, plots_,
+      std::bind(&Application::is_subscribed_to, this, std::placeholders::_1));
+    if (payload.has_value()) {
+      add_topic_field_to_plot(payload.value());
+    }
+    if (socket_source_) {
+      auto channel = ChannelList("socket channels", socket_source_->channel_names());
+      if (channel.has_value()) {
+        add_channel_to_plot(DataSourceKind::Socket, channel.value());
+      }
+    }
+    auto pushed_names = push_series_names();
+    if (!pushed_names.empty()) {
+      auto name = ChannelList("pushed series", pushed_names);
+      if (name.has_value()) {
+        add_channel_to_plot(DataSourceKind::Push, name.value());
+      }
+    }
+
+    auto plot_opts = plot_options();
+    update_data_sources(plot_opts);
+    update_snapshot();
+    update_load_shedding();
+    if (overload_controller_) {
+      OverloadStatus(*overload_controller_);
+    }
     PlotDock(plot_opts);
+    if (show_latency_view_) {
+      LatencyView(
+        plots_, plot_opts, scheduler_->stats(), latency_view_options_, &show_latency_view_);
+    }
+    if (show_memory_view_) {
+      auto now = std::chrono::steady_clock::now();
+      if (now - memory_report_time_ > std::chrono::seconds(1)) {
+        memory_report_ = memory_report();
+        memory_report_time_ = now;
+      }
+      MemoryView(memory_report_, &show_memory_view_);
+    }
+  }
+
+  MemoryReport memory_report() const
+  {
+    MemoryReport report {
+      .series = {},
+      .subscriptions = {},
+      .libraries = {},
+      .gui = MemoryUsage {
+        .used = tracked_gui_bytes(),
+        .reserved = tracked_gui_bytes(),
+      },
+      .resident = resident_set_size(),
+      .budget = memory_budget_,
+    };
+    for (const auto & plot : plots_) {
+      for (const auto & [series, _] : plot.series) {
+        auto active = std::get_if<ActiveDataSource>(&series.source);
+        if (active) {
+          report.series.push_back({series.id, active->data->memory_usage()});
+        }
+        auto stddev_active = std::get_if<ActiveDataSource>(&series.stddev_source);
+        if (stddev_active) {
+          report.series.push_back({series.id + "/stddev", stddev_active->data->memory_usage()});
+        }
+      }
+    }
+    auto nodes = domain_nodes();
+    nodes.push_back(node_);
+    for (const auto & node : nodes) {
+      for (const auto & subscription : node->get_subscriptions()) {
+        report.subscriptions.push_back({subscription->topic_name(), subscription->memory_usage()});
+      }
+    }
+    // message types of a package share their introspection library
+    std::set<std::string> library_paths;
+    for (const auto & [_, introspection] : introspection_cache_.loaded()) {
+      library_paths.insert(introspection->library_path());
+    }
+    for (const auto & path : library_paths) {
+      auto size = mapped_library_size(path);
+      report.libraries.push_back({path, MemoryUsage {.used = size, .reserved = size}});
+    }
+    return report;
   }
 
   void PlotDock(const PlotViewOptions & plot_opts)
@@ -357,7 +1243,8 @@ public:
     }
   }
 
-  void add_topic_field_to_plot(MemberPayload payload)
+  // first plot with at least one axis, added if there is none
+  Plot & ensure_first_plot()
   {
     if (plots_.empty()) {
       auto & new_plot = plots_.emplace_back();
@@ -367,7 +1254,41 @@ public:
       new_axis.y_min = -1.0;
       new_axis.y_max = 1.0;
     }
-    accept_member_payload(plots_[0], ImPlotYAxis_1, &payload);
+    return plots_[0];
+  }
+
+  void add_topic_field_to_plot(MemberPayload payload)
+  {
+    accept_member_payload(ensure_first_plot(), ImPlotYAxis_1, &payload);
+  }
+
+  void add_channel_to_plot(DataSourceKind kind, const std::string & channel)
+  {
+    auto & plot = ensure_first_plot();
+    auto id = channel_series_id(kind, channel);
+    auto it = std::find_if(
+      plot.series.begin(), plot.series.end(), [&id](const auto & item) {
+        return item.first.id == id;
+      });
+    if (it != plot.series.end()) {
+      return;
+    }
+    auto [series, axis] = series_from_config(
+      TimeSeriesConfig {
+        .source = DataSourceConfig {
+          .topic_name = channel,
+          .member_path = {},
+          .op = DataSourceOperator::Identity,
+          .qos = std::nullopt,
+          .domain_id = std::nullopt,
+          .kind = kind,
+        },
+        .stddev_source = std::nullopt,
+        .axis = ImPlotYAxis_1,
+        .priority = SeriesPriority::Normal,
+      });
+    ensure_series_initialized(series);
+    plot.series.emplace_back(std::move(series), axis);
   }
 
   void accept_member_payload(Plot & plot, ImPlotYAxis axis, MemberPayload * payload)
@@ -377,18 +1298,23 @@ public:
     rcpputils::assert_true(
       static_cast<bool>(introspection_opt),
       "message type must be available when accept_member_payload is triggered");
-    auto subscription = node_->get_or_create_subscription(payload->topic_name, *introspection_opt);
-    auto buffer = subscription->add_source(payload->accessor);
-
+    auto [domain_id, topic_name] = split_qualified_topic_name(payload->topic_name);
+    auto subscription = node_for(domain_id)->get_or_create_subscription(
+      topic_name, *introspection_opt);
     auto id = series_id(payload->topic_name, payload->accessor);
     auto it = std::find_if(
       plot.series.begin(), plot.series.end(), [&id](const auto & item) {
         return item.first.id == id;
       });
     if (it != plot.series.end()) {
-      // ensure the same source config is not added twice
+      // ensure the same source config is not added twice, nor restored and exported again
       return;
     }
+    auto buffer = subscription->add_source(payload->accessor);
+    buffer->set_reorder_window(reorder_window_);
+    restore_buffer(id, *buffer);
+    export_buffer(id, payload->topic_name, *buffer);
+
     auto & [new_series, new_axis] = plot.series.emplace_back();
     new_axis = axis;
     // assume the state is Ok, since the topic was drag-dropped from the available list
@@ -397,6 +1323,10 @@ public:
       .subscription = subscription,
       .accessor = payload->accessor,
       .data = buffer,
+      .shared = nullptr,
+      .aggregate = nullptr,
+      .pushed = nullptr,
+      .channel = "",
     };
     new_series.id = id;
 
@@ -410,6 +1340,9 @@ public:
   void clear()
   {
     node_->clear();
+    for (const auto & node : domain_nodes()) {
+      node->clear();
+    }
   }
 };
 
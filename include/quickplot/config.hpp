@@ -1,7 +1,10 @@
 #pragma once
+#include <chrono>
 #include <string>
 #include <vector>
-#include <unordered_set>
+#include <optional>
+#include <utility>
+#include <functional>
 #include <filesystem>
 #include <rclcpp/duration.hpp>
 #include <quickplot/introspection.hpp>
@@ -19,18 +22,80 @@ struct config_error : public std::exception
   }
 };
 
+enum class QosHistory
+{
+  KeepLast,
+  KeepAll,
+};
+
+enum class QosReliability
+{
+  BestEffort,
+  Reliable,
+};
+
+// subscription QoS of a data source
+struct QosConfig
+{
+  QosHistory history;
+  // queue depth, ignored for KeepAll history
+  size_t depth;
+  QosReliability reliability;
+
+  inline bool operator==(const QosConfig & other) const
+  {
+    return history == other.history && depth == other.depth && reliability == other.reliability;
+  }
+};
+
+enum class DataSourceKind
+{
+  // subscribed ROS topic
+  Topic,
+  // channel received by the socket source
+  Socket,
+  // series pushed by the process embedding the quickplot library
+  Push,
+};
+
 struct DataSourceConfig
 {
   std::string topic_name;
   MemberSequencePathDescriptor member_path;
   DataSourceOperator op;
+  // sources without QoS are subscribed with the sensor data profile
+  std::optional<QosConfig> qos;
+  // ROS domain to subscribe in, nullopt for the domain of this process
+  std::optional<size_t> domain_id;
+  // sources other than topics use topic_name as the name of their channel or series
+  DataSourceKind kind = DataSourceKind::Topic;
 
   inline bool operator==(const DataSourceConfig & other) const
   {
-    return topic_name == other.topic_name && member_path == other.member_path && op == other.op;
+    return topic_name == other.topic_name && member_path == other.member_path && op == other.op &&
+           qos == other.qos && domain_id == other.domain_id && kind == other.kind;
   }
 };
 
+// topic name prefixed with its domain, if it is not in the domain of this process
+std::string qualified_topic_name(std::optional<size_t> domain_id, const std::string & topic_name);
+
+// domain and topic name of a qualified topic name
+std::pair<std::optional<size_t>, std::string> split_qualified_topic_name(
+  const std::string & qualified);
+
+// importance of a series when ingestion is overloaded; topics which only feed series of lower
+// priority are thinned first
+enum class SeriesPriority
+{
+  Low,
+  Normal,
+  // never thinned
+  High,
+};
+
+constexpr size_t SERIES_PRIORITY_COUNT = 3;
+
 struct TimeSeriesConfig
 {
   // source of the time series data
@@ -42,9 +107,12 @@ struct TimeSeriesConfig
   // axis 0, 1 or 2
   int axis;
 
+  SeriesPriority priority = SeriesPriority::Normal;
+
   inline bool operator==(const TimeSeriesConfig & other) const
   {
-    return source == other.source && stddev_source == other.stddev_source && axis == other.axis;
+    return source == other.source && stddev_source == other.stddev_source &&
+           axis == other.axis && priority == other.priority;
   }
 };
 
@@ -52,12 +120,54 @@ struct TimeSeriesConfig
 
 namespace std
 {
+// hashes cover all members compared by operator==, so sets of thousands of series with the same
+// topic do not collide
+template<>
+struct hash<quickplot::DataSourceConfig>
+{
+  static void combine(size_t & seed, size_t value)
+  {
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+  }
+
+  inline size_t operator()(const quickplot::DataSourceConfig & config) const
+  {
+    size_t seed = hash<std::string>()(config.topic_name);
+    for (const auto & item : config.member_path) {
+      combine(seed, hash<std::string>()(item.member_name));
+      combine(seed, item.sequence_idx.has_value() ? item.sequence_idx.value() + 1 : 0);
+      if (item.sequence_key.has_value()) {
+        combine(seed, hash<std::string>()(item.sequence_key->member_name));
+        combine(seed, hash<std::string>()(item.sequence_key->value));
+      }
+    }
+    combine(seed, static_cast<size_t>(config.op));
+    if (config.qos.has_value()) {
+      combine(seed, static_cast<size_t>(config.qos->history));
+      combine(seed, config.qos->depth);
+      combine(seed, static_cast<size_t>(config.qos->reliability));
+    }
+    if (config.domain_id.has_value()) {
+      combine(seed, config.domain_id.value() + 1);
+    }
+    combine(seed, static_cast<size_t>(config.kind));
+    return seed;
+  }
+};
+
 template<>
 struct hash<quickplot::TimeSeriesConfig>
 {
   inline size_t operator()(const quickplot::TimeSeriesConfig & config) const
   {
-    return hash<std::string>().operator()(config.source.topic_name);
+    size_t seed = hash<quickplot::DataSourceConfig>()(config.source);
+    if (config.stddev_source.has_value()) {
+      hash<quickplot::DataSourceConfig>::combine(
+        seed, hash<quickplot::DataSourceConfig>()(config.stddev_source.value()));
+    }
+    hash<quickplot::DataSourceConfig>::combine(seed, static_cast<size_t>(config.axis));
+    hash<quickplot::DataSourceConfig>::combine(seed, static_cast<size_t>(config.priority));
+    return seed;
   }
 };
 } // namespace std
@@ -71,9 +181,55 @@ struct AxisConfig
   double y_max;
 };
 
+enum class AggregateOperator
+{
+  Min,
+  Max,
+  Mean,
+};
+
+// reduces the samples of all topics of a pattern to one series
+struct AggregateConfig
+{
+  AggregateOperator op;
+  // seconds of samples reduced to one point
+  double bucket;
+
+  inline bool operator==(const AggregateConfig & other) const
+  {
+    return op == other.op && bucket == other.bucket;
+  }
+};
+
+// adds a series for each topic whose full name matches the pattern, as the topics appear
+struct TopicPatternConfig
+{
+  // ECMAScript regular expression matching the whole resolved topic name
+  std::string topic_pattern;
+  // ROS domain of the matched topics, nullopt for the domain of this process
+  std::optional<size_t> domain_id;
+  MemberSequencePathDescriptor member_path;
+  DataSourceOperator op;
+  std::optional<QosConfig> qos;
+  int axis;
+  // plot a single series aggregating all matching topics instead of one series per topic
+  std::optional<AggregateConfig> aggregate;
+  SeriesPriority priority = SeriesPriority::Normal;
+
+  inline bool operator==(const TopicPatternConfig & other) const
+  {
+    return topic_pattern == other.topic_pattern && domain_id == other.domain_id &&
+           member_path == other.member_path &&
+           op == other.op && qos == other.qos && axis == other.axis &&
+           aggregate == other.aggregate && priority == other.priority;
+  }
+};
+
 struct PlotConfig
 {
-  std::unordered_set<TimeSeriesConfig> series;
+  // in the order of the config file, without duplicates
+  std::vector<TimeSeriesConfig> series;
+  std::vector<TopicPatternConfig> patterns;
   std::vector<AxisConfig> axes;
 };
 
@@ -87,10 +243,36 @@ fs::path get_default_config_directory();
 
 fs::path get_default_config_path();
 
+const char * aggregate_operator_name(AggregateOperator);
+
+const char * series_priority_name(SeriesPriority);
+
 ApplicationConfig default_config();
 
-void save_config(ApplicationConfig, fs::path);
+void save_config(const ApplicationConfig &, fs::path);
 
 ApplicationConfig load_config(fs::path);
 
+/**
+ * Polls the modification time of a configuration file, to reload the configuration while it is
+ * edited.
+ */
+class ConfigWatcher
+{
+private:
+  fs::path path_;
+  std::chrono::steady_clock::duration poll_period_;
+  std::chrono::steady_clock::time_point last_poll_;
+  std::optional<fs::file_time_type> last_write_time_;
+
+public:
+  explicit ConfigWatcher(
+    fs::path path,
+    std::chrono::steady_clock::duration poll_period = std::chrono::milliseconds(500));
+
+  // configuration if the file was written since the last change, nullopt if it was not or
+  // failed to load; checks the file at most once per poll period
+  std::optional<ApplicationConfig> poll();
+};
+
 } // namespace quickplot
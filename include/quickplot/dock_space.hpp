@@ -0,0 +1,73 @@
+#pragma once
+
+#include "implot.h" // NOLINT
+#include <imgui_internal.h>
+#include <string>
+#include "quickplot/topic_list.hpp"
+
+namespace quickplot
+{
+
+/**
+ * Full screen parent window with dock spaces for the topic list and the plot windows.
+ * If reset_layout is set, the plot windows are docked below each other, right of the topic list.
+ */
+void ParentDockSpace(size_t plot_count, bool reset_layout)
+{
+  static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_PassthruCentralNode;
+  // build parent window with dock spaces
+  ImGuiWindowFlags parent_window_flags = ImGuiWindowFlags_NoSavedSettings;
+  parent_window_flags |= ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoCollapse |
+    ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove;
+  parent_window_flags |= ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoNavFocus;
+  if (dockspace_flags & ImGuiDockNodeFlags_PassthruCentralNode) {
+    parent_window_flags |= ImGuiWindowFlags_NoBackground;
+  }
+
+  ImGuiViewport * viewport = ImGui::GetMainViewport();
+  ImGui::SetNextWindowPos(viewport->Pos);
+  ImGui::SetNextWindowSize(viewport->Size);
+  ImGui::SetNextWindowViewport(viewport->ID);
+
+  // remove redundant padding from outer window
+  ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0, 0.0));
+  ImGui::Begin("ParentDock", nullptr, parent_window_flags);
+  ImGui::PopStyleVar();
+
+  ImGuiID dockspace_id = ImGui::GetID("ParentDockSpace");
+  ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), dockspace_flags);
+
+  if (reset_layout) {
+    ImGui::DockBuilderRemoveNode(dockspace_id); // clear any previous layout
+    ImGui::DockBuilderAddNode(dockspace_id, dockspace_flags | ImGuiDockNodeFlags_DockSpace);
+    ImGui::DockBuilderSetNodeSize(dockspace_id, viewport->Size);
+
+    float default_list_width = (1 - (1.0 / 1.61803398875)) / 2.0;
+    ImGuiID dock_id_plot;
+    ImGuiID dock_id_list = ImGui::DockBuilderSplitNode(
+      dockspace_id, ImGuiDir_Left,
+      default_list_width, nullptr, &dock_id_plot);
+    // disable docking and bar in list window
+    ImGui::DockBuilderGetNode(dock_id_list)->SetLocalFlags(
+      ImGuiDockNodeFlags_NoDocking | ImGuiDockNodeFlags_NoTabBar);
+
+    // we now dock our windows into the docking node we made above
+    ImGui::DockBuilderDockWindow(TOPIC_LIST_WINDOW_ID, dock_id_list);
+
+    if (plot_count >= 1) {
+      ImGui::DockBuilderDockWindow("plot0", dock_id_plot);
+      float equal_ratio = 1.0 / plot_count;
+      for (size_t i = 1; i < plot_count; i++) {
+        ImGui::DockBuilderSplitNode(
+          dock_id_plot, ImGuiDir_Down,
+          equal_ratio, &dock_id_plot, nullptr);
+        std::string win_id = "plot" + std::to_string(i);
+        ImGui::DockBuilderDockWindow(win_id.c_str(), dock_id_plot);
+      }
+    }
+    ImGui::DockBuilderFinish(dockspace_id);
+  }
+  ImGui::End();
+}
+
+} // namespace quickplot
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <rclcpp/rclcpp.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "quickplot/ingest_loop.hpp"
+#include "quickplot/node.hpp"
+#include "quickplot/scheduler.hpp"
+
+namespace quickplot
+{
+
+/**
+ * Node subscribing to topics of another ROS domain, with its own context, executor thread and,
+ * in 'wait_set' ingest mode, ingest thread, so domains receive in parallel.
+ */
+class DomainNode
+{
+private:
+  rclcpp::Context::SharedPtr context_;
+  std::shared_ptr<QuickPlotNode> node_;
+  rclcpp::Event::SharedPtr graph_event_;
+  std::unique_ptr<rclcpp::executors::SingleThreadedExecutor> executor_;
+  std::thread spin_thread_;
+  std::unique_ptr<IngestLoop> ingest_loop_;
+  std::thread ingest_thread_;
+  // released before the node, whose clock calls it
+  rclcpp::JumpHandler::SharedPtr jump_handler_;
+
+public:
+  // parameters are copied from the node of the own domain
+  DomainNode(
+    size_t domain_id, const std::vector<rclcpp::Parameter> & parameters,
+    std::shared_ptr<TaskScheduler> scheduler)
+  {
+    context_ = std::make_shared<rclcpp::Context>();
+    rclcpp::InitOptions init_options;
+    init_options.set_domain_id(domain_id);
+    // logging is initialized by the context of the own domain
+    init_options.auto_initialize_logging(false);
+    context_->init(0, nullptr, init_options);
+
+    node_ = std::make_shared<QuickPlotNode>(
+      "quickplot", rclcpp::NodeOptions().context(context_).parameter_overrides(parameters));
+    node_->set_domain_id(domain_id);
+    node_->set_scheduler(scheduler);
+    graph_event_ = node_->get_graph_event();
+    // set manually to trigger the initial topics query
+    graph_event_->set();
+    rclcpp::ExecutorOptions executor_options;
+    executor_options.context = context_;
+    executor_ = std::make_unique<rclcpp::executors::SingleThreadedExecutor>(executor_options);
+    executor_->add_node(node_);
+    spin_thread_ = std::thread([this] {executor_->spin();});
+    if (node_->uses_ingest_loop()) {
+      ingest_loop_ = std::make_unique<IngestLoop>(node_);
+      ingest_thread_ = std::thread([this] {ingest_loop_->run();});
+    }
+  }
+
+  ~DomainNode()
+  {
+    executor_->cancel();
+    spin_thread_.join();
+    if (ingest_loop_) {
+      ingest_loop_->stop();
+      ingest_thread_.join();
+    }
+    context_->shutdown("quickplot domain removed");
+  }
+
+  // disable copy and move, since the threads reference this
+  DomainNode & operator=(DomainNode &&) = delete;
+
+  std::shared_ptr<QuickPlotNode> node() const
+  {
+    return node_;
+  }
+
+  rclcpp::Event::SharedPtr graph_event() const
+  {
+    return graph_event_;
+  }
+
+  // keep the handler of time jumps of the node's clock registered while the node exists
+  void set_jump_handler(rclcpp::JumpHandler::SharedPtr jump_handler)
+  {
+    jump_handler_ = std::move(jump_handler);
+  }
+};
+
+// parameters of the own node which configure the nodes of other domains the same way
+std::vector<rclcpp::Parameter> domain_node_parameters(const QuickPlotNode & node)
+{
+  std::vector<rclcpp::Parameter> parameters;
+  for (const auto & name : {"use_sim_time", "typed_message_types", "ingest_mode",
+      "ingest_batch_size", "pipeline_topics", "pipeline_workers", "scheduler_threads"})
+  {
+    parameters.push_back(node.get_parameter(name));
+  }
+  return parameters;
+}
+
+} // namespace quickplot
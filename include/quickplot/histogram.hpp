@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace quickplot
+{
+
+// percentiles and totals of the values recorded in the window of a WindowedHistogram
+struct HistogramSummary
+{
+  uint64_t count;
+  uint64_t p50;
+  uint64_t p99;
+  uint64_t max;
+  // sum of all values, e.g. to compute bytes per second
+  uint64_t sum;
+  // duration covered by the window, shorter than the window length shortly after the first record
+  double window;
+
+  double rate() const
+  {
+    return window > 0.0 ? count / window : 0.0;
+  }
+
+  double sum_rate() const
+  {
+    return window > 0.0 ? sum / window : 0.0;
+  }
+};
+
+/**
+ * Histogram of unsigned integer values over a sliding time window, with log-linear buckets.
+ * Each power of two range is divided into 2^SUB_BUCKET_BITS buckets, so percentiles have a
+ * relative error below 1 / 2^SUB_BUCKET_BITS.
+ *
+ * The window is a ring of slots, each covering slot_duration; the oldest slot is reset when
+ * recording into it again. Slots are allocated when a value is first recorded into them, so
+ * histograms which are never recorded to, e.g. the stamp latency of messages without header, take
+ * no memory for buckets. Recording is lock-free with a single writer. Readers may run
+ * concurrently, in which case a summary can be off by the values recorded while it is computed.
+ */
+class WindowedHistogram
+{
+public:
+  static constexpr unsigned SUB_BUCKET_BITS = 4;
+  static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  // values above 2^MAX_VALUE_BITS are recorded in the last bucket
+  static constexpr unsigned MAX_VALUE_BITS = 40;
+  static constexpr size_t BUCKETS = SUB_BUCKETS * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+  static size_t bucket_index(uint64_t value);
+
+  // upper bound of the values in the bucket
+  static uint64_t bucket_upper_bound(size_t index);
+
+  explicit WindowedHistogram(
+    std::chrono::nanoseconds slot_duration = std::chrono::seconds(1),
+    size_t slots = 10);
+
+  ~WindowedHistogram();
+
+  // disable copy and move
+  WindowedHistogram & operator=(WindowedHistogram &&) = delete;
+
+  // record a value at the steady time now
+  void record(uint64_t value, std::chrono::nanoseconds now);
+
+  HistogramSummary summary(std::chrono::nanoseconds now) const;
+
+  // forget all recorded values; may run concurrently with record, in which case the values
+  // recorded meanwhile are either kept or dropped, but the histogram stays consistent
+  void clear();
+
+  // bytes allocated for the slots
+  size_t memory_size() const;
+
+private:
+  struct Slot
+  {
+    // index of the slot duration since the epoch this slot currently holds, -1 if empty
+    std::atomic<int64_t> epoch;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+    // counts of a single slot duration, which do not overflow 32 bits
+    std::array<std::atomic<uint32_t>, BUCKETS> buckets;
+  };
+
+  int64_t slot_duration_;
+  // nullptr until a value is recorded into the slot; only the writer allocates slots
+  std::vector<std::atomic<Slot *>> slots_;
+  // steady time of the first recorded value, to report the covered window
+  std::atomic<int64_t> first_record_;
+};
+
+} // namespace quickplot
+
+// writes count, rate, percentiles, max and sum rate of the summary as a YAML flow mapping
+std::ostream & operator<<(std::ostream & os, const quickplot::HistogramSummary & summary);
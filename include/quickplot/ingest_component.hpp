@@ -0,0 +1,39 @@
+#pragma once
+
+#include <rclcpp/rclcpp.hpp>
+#include <memory>
+#include <thread>
+#include "quickplot/node.hpp"
+
+namespace quickplot
+{
+
+class Application;
+class IngestLoop;
+
+/**
+ * Headless quickplot node, which subscribes to the series of a plot configuration and exports
+ * them to shared memory.
+ * Intended to be loaded into the component container of the observed nodes, while one or more
+ * GUI processes started with shared_memory:=import display the exported series.
+ */
+class IngestComponent
+{
+private:
+  std::shared_ptr<QuickPlotNode> node_;
+  std::unique_ptr<Application> app_;
+  rclcpp::TimerBase::SharedPtr update_timer_;
+  // takes the messages of all subscriptions in ingest_mode 'wait_set', which the container's
+  // executor does not serve
+  std::unique_ptr<IngestLoop> ingest_loop_;
+  std::thread ingest_thread_;
+
+public:
+  explicit IngestComponent(const rclcpp::NodeOptions & options);
+
+  ~IngestComponent();
+
+  rclcpp::node_interfaces::NodeBaseInterface::SharedPtr get_node_base_interface() const;
+};
+
+} // namespace quickplot
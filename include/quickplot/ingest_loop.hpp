@@ -0,0 +1,95 @@
+#pragma once
+
+#include <rclcpp/rclcpp.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "quickplot/node.hpp"
+
+namespace quickplot
+{
+
+/**
+ * Takes messages of all subscriptions of a QuickPlotNode in ingest_mode 'wait_set'.
+ * When woken up by the wait set, all pending messages of a subscription are taken at once and
+ * pushed to each buffer in a single batch, instead of paying an executor dispatch, a callback and
+ * a buffer lock per message.
+ */
+class IngestLoop
+{
+private:
+  std::shared_ptr<QuickPlotNode> node_;
+  size_t batch_size_;
+  std::atomic<bool> running_;
+
+  // subscriptions in the current wait set, and the node's subscription generation it was built at
+  std::vector<std::weak_ptr<PlotSubscription>> subscriptions_;
+  size_t generation_;
+
+  std::unique_ptr<rclcpp::WaitSet> make_wait_set()
+  {
+    generation_ = node_->subscriptions_generation();
+    subscriptions_.clear();
+    auto wait_set = std::make_unique<rclcpp::WaitSet>();
+    wait_set->add_guard_condition(node_->subscriptions_changed());
+    for (const auto & subscription : node_->get_subscriptions()) {
+      wait_set->add_subscription(subscription->get_subscription());
+      subscriptions_.push_back(subscription);
+    }
+    return wait_set;
+  }
+
+public:
+  explicit IngestLoop(std::shared_ptr<QuickPlotNode> node)
+  : node_(node),
+    batch_size_(static_cast<size_t>(node->get_parameter("ingest_batch_size").as_int())),
+    running_(true), generation_(0)
+  {
+    if (!node_->uses_ingest_loop()) {
+      throw std::invalid_argument("IngestLoop requires a node with ingest_mode 'wait_set'");
+    }
+  }
+
+  // stop the loop from another thread
+  void stop()
+  {
+    running_ = false;
+    node_->subscriptions_changed()->trigger();
+  }
+
+  void run()
+  {
+    auto context = node_->get_node_base_interface()->get_context();
+    auto wait_set = make_wait_set();
+    while (running_ && rclcpp::ok(context)) {
+      // time out periodically, to release subscriptions that are no longer plotted
+      auto result = wait_set->wait(std::chrono::milliseconds(100));
+      bool expired = false;
+      if (result.kind() == rclcpp::WaitResultKind::Ready) {
+        // event handlers only inspect the wait set, but take it non-const
+        auto rcl_wait_set = const_cast<rcl_wait_set_t *>(
+          &result.get_wait_set().get_rcl_wait_set());
+        for (const auto & weak_subscription : subscriptions_) {
+          auto subscription = weak_subscription.lock();
+          if (subscription) {
+            subscription->execute_ready_events(rcl_wait_set);
+            subscription->take_pending(batch_size_);
+          } else {
+            expired = true;
+          }
+        }
+      } else {
+        for (const auto & weak_subscription : subscriptions_) {
+          expired |= weak_subscription.expired();
+        }
+      }
+      if (expired || generation_ != node_->subscriptions_generation()) {
+        wait_set = make_wait_set();
+      }
+    }
+  }
+};
+
+} // namespace quickplot
@@ -39,14 +39,30 @@ enum class DataSourceOperator {
   L2Norm,
 };
 
+// selects the item of a sequence by the value of a string sequence in the same message, like
+// position[name=elbow] of sensor_msgs/JointState
+struct SequenceKeyDescriptor
+{
+  std::string member_name;
+  std::string value;
+
+  inline bool operator==(const SequenceKeyDescriptor & other) const
+  {
+    return member_name == other.member_name && value == other.value;
+  }
+};
+
 struct MemberSequencePathItemDescriptor
 {
   std::string member_name;
   std::optional<size_t> sequence_idx;
+  // replaces sequence_idx, if the item is selected by name
+  std::optional<SequenceKeyDescriptor> sequence_key = std::nullopt;
 
   inline bool operator==(const MemberSequencePathItemDescriptor & other) const
   {
-    return member_name == other.member_name && sequence_idx == other.sequence_idx;
+    return member_name == other.member_name && sequence_idx == other.sequence_idx &&
+           sequence_key == other.sequence_key;
   }
 };
 
@@ -64,30 +80,68 @@ using MemberSequencePathItem = std::pair<MemberPtr, size_t>;
 
 using MemberSequencePath = std::vector<MemberSequencePathItem>;
 
+// resolved SequenceKeyDescriptor
+struct SequenceKey {
+  // item of the member path selected by name
+  size_t item;
+
+  // string sequence beside the sequence of the item
+  MemberPtr key_member;
+
+  std::string value;
+};
+
 struct MessageAccessor {
   // resolved member path of topic type
   MemberSequencePath member;
 
   // operator to apply to the member
   DataSourceOperator op;
+
+  // if set, the index of member[key->item] is the cached position of the key
+  std::optional<SequenceKey> key = std::nullopt;
 };
 
 double cast_numeric(const void * n, uint8_t type_id);
 
+void assign_numeric(void * n, uint8_t type_id, double value);
+
 bool is_numeric(uint8_t type_id);
 
+// bool and 8 bit integer members, which hold flags and enum values that rarely change
+bool is_state(uint8_t type_id);
+
+// accessor reads a state member without an operator, so its series only stores transitions
+bool is_state(const MessageAccessor &);
+
 bool contains_sequence(const MemberPath &);
 
 size_t total_member_offset(const MemberPath &);
 
 MemberSequencePath assume_members_unindexed(const MemberPath &);
 
+// throws introspection_error if the path is empty
 double get_numeric(const void *, const MemberSequencePath &, DataSourceOperator = DataSourceOperator::Identity);
 
+// set the member of a message in introspection layout, resizing sequences to contain the index;
+// throws introspection_error if the path is empty
+void set_numeric(void *, const MemberSequencePath &, double value);
+
 MemberSequencePathItemDescriptor to_descriptor_item(const MemberSequencePathItem &);
 
 MemberSequencePathDescriptor to_descriptor(const MemberSequencePath &);
 
+// descriptor of the accessor member, selecting the keyed item by name
+MemberSequencePathDescriptor to_descriptor(const MessageAccessor &);
+
+/**
+ * Point the keyed item of the accessor member path to the position of the key in the message.
+ * The previous position is checked first, with a single string comparison, so keys are only
+ * searched when the order of the sequence changes.
+ * Returns false if the message does not contain the key.
+ */
+bool resolve_sequence_key(const void * message, MessageAccessor & accessor);
+
 class MemberIterator : public std::iterator<std::forward_iterator_tag, MemberPath>
 {
 private:
@@ -248,6 +302,9 @@ public:
 
   const rosidl_message_type_support_t * get_typesupport_handle() const;
 
+  // path of the loaded introspection typesupport library
+  std::string library_path() const;
+
   // disable copy and move
   MessageIntrospection & operator=(MessageIntrospection && other) = delete;
 
@@ -259,6 +316,11 @@ public:
 
   std::optional<MemberSequencePath> get_member_sequence_path(
     MemberSequencePathDescriptor in_path) const;
+
+  // key of the resolved path, if an item of the descriptor selects a sequence item by name
+  // throws introspection_error if the key member is not a string sequence beside the sequence
+  std::optional<SequenceKey> get_sequence_key(
+    const MemberSequencePathDescriptor & in_path, const MemberSequencePath & path) const;
 };
 
 } // namespace quickplot
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "implot.h" // NOLINT
+#include <string>
+#include <vector>
+#include "quickplot/plot.hpp"
+#include "quickplot/plot_view.hpp"
+#include "quickplot/scheduler.hpp"
+
+namespace quickplot
+{
+
+constexpr const char * LATENCY_WINDOW_ID = "latency";
+
+struct LatencyViewOptions
+{
+  // plot header stamp to draw latency of all series over time
+  bool plot_stamp_to_draw;
+};
+
+ImPlotPoint point_vector_get_item(void * data, int idx)
+{
+  return static_cast<ImPlotPoint *>(data)[idx];
+}
+
+void LatencyRow(const char * stage, const WindowedHistogram & histogram)
+{
+  auto summary = histogram.summary(std::chrono::steady_clock::now().time_since_epoch());
+  ImGui::TableNextRow();
+  ImGui::TableNextColumn();
+  ImGui::Text("%s", stage);
+  ImGui::TableNextColumn();
+  ImGui::Text("%.2f", summary.p50 * 1e-6);
+  ImGui::TableNextColumn();
+  ImGui::Text("%.2f", summary.p99 * 1e-6);
+  ImGui::TableNextColumn();
+  ImGui::Text("%.2f", summary.max * 1e-6);
+}
+
+// queue depth and throughput of the background tasks, per priority
+void SchedulerTable(const SchedulerStats & stats)
+{
+  auto header = "scheduler (" + std::to_string(stats.workers) + " workers, " +
+    std::to_string(stats.steals) + " steals)";
+  if (!ImGui::CollapsingHeader(header.c_str())) {
+    return;
+  }
+  if (ImGui::BeginTable("scheduler", 3)) {
+    ImGui::TableSetupColumn("priority");
+    ImGui::TableSetupColumn("queued");
+    ImGui::TableSetupColumn("executed");
+    ImGui::TableHeadersRow();
+    const char * priorities[] = {"ingest", "render prep", "analysis", "export"};
+    for (size_t i = 0; i < TASK_PRIORITY_COUNT; i++) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", priorities[i]);
+      ImGui::TableNextColumn();
+      ImGui::Text("%lu", stats.queued[i]);
+      ImGui::TableNextColumn();
+      ImGui::Text("%lu", stats.executed[i]);
+    }
+    ImGui::EndTable();
+  }
+}
+
+/**
+ * Window showing the latency of each plotted series, from header stamp to receive, receive to
+ * commit into the plot buffer, and commit to the first frame which draws the sample.
+ */
+void LatencyView(
+  const std::vector<Plot> & plots, const PlotViewOptions & plot_opts,
+  const SchedulerStats & scheduler, LatencyViewOptions & options, bool * open)
+{
+  if (!ImGui::Begin(LATENCY_WINDOW_ID, open)) {
+    ImGui::End();
+    return;
+  }
+  SchedulerTable(scheduler);
+  ImGui::Checkbox("plot header stamp to draw", &options.plot_stamp_to_draw);
+
+  std::vector<std::pair<std::string, std::shared_ptr<PlotDataBuffer>>> buffers;
+  for (const auto & plot : plots) {
+    for (const auto & [series, _] : plot.series) {
+      auto active = std::get_if<ActiveDataSource>(&series.source);
+      // imported series are received by another process, which measures their latency
+      if (active && active->subscription) {
+        buffers.emplace_back(series.id, active->data);
+      }
+    }
+  }
+
+  for (const auto & [id, buffer] : buffers) {
+    if (!ImGui::CollapsingHeader(id.c_str(), ImGuiTreeNodeFlags_DefaultOpen)) {
+      continue;
+    }
+    if (ImGui::BeginTable(id.c_str(), 4)) {
+      ImGui::TableSetupColumn("ms");
+      ImGui::TableSetupColumn("p50");
+      ImGui::TableSetupColumn("p99");
+      ImGui::TableSetupColumn("max");
+      ImGui::TableHeadersRow();
+      // nothing was received yet
+      if (const auto * latency = buffer->latency()) {
+        LatencyRow("stamp to receive", latency->stamp_to_receive);
+        LatencyRow("receive to commit", latency->receive_to_commit);
+        LatencyRow("commit to draw", latency->commit_to_draw);
+        LatencyRow("stamp to draw", latency->stamp_to_draw);
+      }
+      ImGui::EndTable();
+    }
+  }
+
+  if (options.plot_stamp_to_draw) {
+    ImPlot::SetNextPlotLimitsX(
+      plot_opts.t_start.seconds(), plot_opts.t_end.seconds(), ImGuiCond_Always);
+    if (ImPlot::BeginPlot("##stamp_to_draw", "t (sec)", "stamp to draw (ms)", ImVec2(-1, -1))) {
+      for (const auto & [id, buffer] : buffers) {
+        auto points = buffer->latency_series();
+        ImPlot::PlotLineG(
+          id.c_str(), &point_vector_get_item, points.data(), static_cast<int>(points.size()));
+      }
+      ImPlot::EndPlot();
+    }
+  }
+  ImGui::End();
+}
+
+} // namespace quickplot
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace quickplot
+{
+
+// bytes held by a component; reserved includes allocated but unused capacity
+struct MemoryUsage
+{
+  size_t used;
+  size_t reserved;
+
+  MemoryUsage & operator+=(const MemoryUsage & other)
+  {
+    used += other.used;
+    reserved += other.reserved;
+    return *this;
+  }
+};
+
+struct NamedMemoryUsage
+{
+  std::string name;
+  MemoryUsage usage;
+};
+
+struct MemoryReport
+{
+  // plot buffers and latency instrumentation of each series
+  std::vector<NamedMemoryUsage> series;
+  // message scratch buffers, receive statistics and pending batches of each subscription
+  std::vector<NamedMemoryUsage> subscriptions;
+  // introspection typesupport libraries mapped into the process, used = reserved
+  std::vector<NamedMemoryUsage> libraries;
+  // heap allocated by ImGui and ImPlot, if the tracked allocator is installed
+  MemoryUsage gui;
+  // resident set size of the process, including everything not accounted for above
+  size_t resident;
+  // memory budget in bytes, zero if unlimited
+  size_t budget;
+
+  MemoryUsage accounted() const;
+
+  bool over_budget() const;
+};
+
+// ImGui allocator functions counting the bytes allocated by ImGui and ImPlot; install with
+// ImGui::SetAllocatorFunctions before creating the contexts
+void * tracked_gui_alloc(size_t size, void * user_data);
+
+void tracked_gui_free(void * ptr, void * user_data);
+
+size_t tracked_gui_bytes();
+
+// resident set size of this process in bytes, zero if it cannot be read
+size_t resident_set_size();
+
+// bytes of the shared library at path mapped into this process, zero if it is not loaded
+size_t mapped_library_size(const std::string & path);
+
+// write the report as YAML, for tooling that checks memory budgets
+void write_memory_report(std::ostream & os, const MemoryReport & report);
+
+} // namespace quickplot
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "implot.h" // NOLINT
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "quickplot/config.hpp"
+#include "quickplot/memory.hpp"
+#include "quickplot/style.hpp"
+
+namespace quickplot
+{
+
+constexpr const char * MEMORY_WINDOW_ID = "memory";
+
+void MemoryUsageTable(const char * id, const std::vector<NamedMemoryUsage> & items)
+{
+  if (items.empty() || !ImGui::BeginTable(id, 3)) {
+    return;
+  }
+  ImGui::TableSetupColumn(id);
+  ImGui::TableSetupColumn("used kB");
+  ImGui::TableSetupColumn("reserved kB");
+  ImGui::TableHeadersRow();
+  for (const auto & item : items) {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::Text("%s", item.name.c_str());
+    ImGui::TableNextColumn();
+    ImGui::Text("%.1f", item.usage.used / 1e3);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.1f", item.usage.reserved / 1e3);
+  }
+  ImGui::EndTable();
+}
+
+// window listing the memory accounted to each series, subscription and library
+void MemoryView(const MemoryReport & report, bool * open)
+{
+  if (!ImGui::Begin(MEMORY_WINDOW_ID, open)) {
+    ImGui::End();
+    return;
+  }
+  auto accounted = report.accounted();
+  ImGui::Text("resident %.1f MB", report.resident / 1e6);
+  if (report.budget != 0) {
+    ImGui::SameLine();
+    ImGui::Text("of %.1f MB budget", report.budget / 1e6);
+  }
+  if (report.over_budget()) {
+    ImGui::PushStyleColor(ImGuiCol_Text, WARNING_COLOR);
+    ImGui::TextWrapped("over budget; reduce the history length or remove series");
+    ImGui::PopStyleColor();
+  }
+  ImGui::Text(
+    "accounted %.1f MB used, %.1f MB reserved", accounted.used / 1e6,
+    accounted.reserved / 1e6);
+  ImGui::Text("gui %.1f MB", report.gui.used / 1e6);
+
+  if (ImGui::SmallButton("copy YAML")) {
+    std::stringstream ss;
+    write_memory_report(ss, report);
+    ImGui::SetClipboardText(ss.str().c_str());
+  }
+  ImGui::SameLine();
+  if (ImGui::SmallButton("save")) {
+    auto path = get_default_config_directory().append("memory.yaml");
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    std::ofstream fout(path);
+    write_memory_report(fout, report);
+    fout.flush();
+    if (fout.good()) {
+      std::cout << "Saved memory report to " << path << std::endl;
+    } else {
+      std::cerr << "Failed to save memory report to " << path << std::endl;
+    }
+  }
+
+  if (ImGui::CollapsingHeader("series", ImGuiTreeNodeFlags_DefaultOpen)) {
+    MemoryUsageTable("series", report.series);
+  }
+  if (ImGui::CollapsingHeader("subscriptions", ImGuiTreeNodeFlags_DefaultOpen)) {
+    MemoryUsageTable("subscriptions", report.subscriptions);
+  }
+  if (ImGui::CollapsingHeader("libraries")) {
+    MemoryUsageTable("libraries", report.libraries);
+  }
+  ImGui::End();
+}
+
+} // namespace quickplot
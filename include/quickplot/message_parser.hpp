@@ -37,7 +37,10 @@ public:
 
   void deserialize(const rclcpp::SerializedMessage &, void * message) const;
 
-  std::optional<rclcpp::Time> get_header_stamp(void * message) const;
+  // serialize a message in introspection layout, e.g. to publish synthetic data
+  void serialize(const void * message, rclcpp::SerializedMessage &) const;
+
+  std::optional<rclcpp::Time> get_header_stamp(const void * message) const;
 };
 
 } // namespace quickplot
@@ -7,7 +7,14 @@
 #include <utility>
 #include <list>
 #include <memory>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
 #include "quickplot/plot_subscription.hpp"
+#include "quickplot/scheduler.hpp"
+#include "quickplot/typed_subscription.hpp"
 
 namespace quickplot
 {
@@ -16,24 +23,178 @@ class QuickPlotNode : public rclcpp::Node
 {
 private:
   std::mutex topic_mutex_;
-  std::list<std::weak_ptr<PlotSubscription>> subscriptions_;
+  // indexed by topic name, so configs with thousands of topics are subscribed in linear time
+  std::unordered_multimap<std::string, std::weak_ptr<PlotSubscription>> subscriptions_;
+
+  // set if messages are taken in batches by an IngestLoop instead of the executor
+  rclcpp::CallbackGroup::SharedPtr ingest_callback_group_;
+  // triggered when a subscription is created, to wake up the IngestLoop
+  rclcpp::GuardCondition::SharedPtr subscriptions_changed_;
+  // set for nodes subscribing in another ROS domain than this process
+  std::optional<size_t> domain_id_;
+  // runs the workers of pipelined topics
+  std::shared_ptr<TaskScheduler> scheduler_;
+  std::atomic<size_t> subscriptions_generation_{0};
 
 public:
-  QuickPlotNode() : Node("quickplot")
+  explicit QuickPlotNode(
+    const std::string & node_name = "quickplot",
+    const rclcpp::NodeOptions & options = rclcpp::NodeOptions())
+  : Node(node_name, options)
+  {
+    // 'off', 'export' to share received series with other quickplot processes on this machine,
+    // or 'import' to read series exported by another process instead of subscribing
+    declare_parameter<std::string>("shared_memory", "off");
+    // number of samples in the ring of each exported series
+    declare_parameter<int64_t>("shared_memory_capacity", 1 << 16);
+    // message types which are subscribed with a typed fast path instead of introspection
+    declare_parameter<std::vector<std::string>>("typed_message_types", typed_message_types());
+    // show the window with publish to display latency of each series
+    declare_parameter<bool>("latency_view", false);
+    // show the window with memory accounted to each series, subscription and library
+    declare_parameter<bool>("memory_view", false);
+    // resident memory above which the memory window warns, 0 for no budget
+    declare_parameter<int64_t>("memory_budget_mb", 0);
+    // apply changes to the configuration file while running, keeping unchanged series
+    declare_parameter<bool>("reload_config", true);
+    // restore the history of the previous run at startup, and save it periodically and at exit
+    declare_parameter<bool>("snapshot", true);
+    // seconds between history snapshots, 0 to only save at exit
+    declare_parameter<double>("snapshot_period", 10.0);
+    // seconds by which samples of multiple publishers or sensors may arrive out of order; they
+    // are inserted in time order, and samples arriving later are dropped; 0 to append samples in
+    // the order they arrive
+    declare_parameter<double>("reorder_window", 0.0);
+    // 'udp:<port>' or 'unix:<path>' to receive samples of processes which are not ROS nodes
+    declare_parameter<std::string>("socket", "");
+    // maximum number of datagrams taken from the socket per receive call
+    declare_parameter<int64_t>("socket_batch_size", 64);
+    // 'executor' to handle each message in its own callback, or 'wait_set' to take all pending
+    // messages of a subscription in one batch from a dedicated ingest thread
+    auto ingest_mode = declare_parameter<std::string>("ingest_mode", "executor");
+    // maximum number of messages taken from one subscription per wake-up in wait_set mode
+    declare_parameter<int64_t>("ingest_batch_size", 1000);
+    // topics whose messages are deserialized by several workers, for topics with a rate or
+    // message size that saturates a core
+    declare_parameter<std::vector<std::string>>("pipeline_topics", std::vector<std::string>());
+    // deserialization workers per pipelined topic, 0 for one per core
+    declare_parameter<int64_t>("pipeline_workers", 0);
+    // threads running background tasks like deserialization and snapshot writes, 0 for one per
+    // core
+    declare_parameter<int64_t>("scheduler_threads", 0);
+    // seconds of ingest work per second (i.e. cores) above which topics of low priority series
+    // are thinned before deserialization; 0, the default, never thins topics, since the work of
+    // all ingest threads counts against the budget
+    declare_parameter<double>("ingest_budget", 0.0);
+    // messages a subscription may lag behind before its topic counts as overloaded
+    declare_parameter<int64_t>("shedding_backlog", 500);
+    if (ingest_mode == "wait_set") {
+      ingest_callback_group_ = create_callback_group(
+        rclcpp::CallbackGroupType::MutuallyExclusive, false);
+      subscriptions_changed_ = std::make_shared<rclcpp::GuardCondition>(
+        get_node_base_interface()->get_context());
+    } else if (ingest_mode != "executor") {
+      throw std::invalid_argument("unknown ingest_mode '" + ingest_mode + "'");
+    }
+  }
+
+  // must be set before subscribing
+  void set_domain_id(std::optional<size_t> domain_id)
+  {
+    domain_id_ = domain_id;
+  }
+
+  std::optional<size_t> domain_id() const
+  {
+    return domain_id_;
+  }
+
+  // must be set before subscribing; a scheduler is created on first use otherwise
+  void set_scheduler(std::shared_ptr<TaskScheduler> scheduler)
+  {
+    scheduler_ = scheduler;
+  }
+
+  bool uses_ingest_loop() const
   {
+    return ingest_callback_group_ != nullptr;
   }
 
+  rclcpp::GuardCondition::SharedPtr subscriptions_changed() const
+  {
+    return subscriptions_changed_;
+  }
+
+  size_t subscriptions_generation() const
+  {
+    return subscriptions_generation_;
+  }
+
+  std::vector<std::shared_ptr<PlotSubscription>> get_subscriptions()
+  {
+    std::unique_lock<std::mutex> lock(topic_mutex_);
+    std::vector<std::shared_ptr<PlotSubscription>> result;
+    auto it = subscriptions_.begin();
+    while (it != subscriptions_.end()) {
+      auto subscription = it->second.lock();
+      if (subscription) {
+        result.push_back(subscription);
+        ++it;
+      } else {
+        it = subscriptions_.erase(it);
+      }
+    }
+    return result;
+  }
+
+  // returns nullptr if the message type has no fast path, or it is disabled
+  const TypedMessageSupport * get_typed_support(const std::string & message_type) const
+  {
+    auto enabled = get_parameter("typed_message_types").as_string_array();
+    if (std::find(enabled.begin(), enabled.end(), message_type) == enabled.end()) {
+      return nullptr;
+    }
+    return find_typed_message_support(message_type);
+  }
+
+  // number of deserialization workers of the topic, 0 if it is not pipelined
+  size_t get_pipeline_workers(const std::string & topic) const
+  {
+    auto topics = get_parameter("pipeline_topics").as_string_array();
+    if (std::find(topics.begin(), topics.end(), topic) == topics.end()) {
+      return 0;
+    }
+    auto workers = get_parameter("pipeline_workers").as_int();
+    if (workers > 0) {
+      return static_cast<size_t>(workers);
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  // called with topic_mutex_ held
+  std::shared_ptr<TaskScheduler> scheduler()
+  {
+    if (!scheduler_) {
+      scheduler_ = std::make_shared<TaskScheduler>(
+        static_cast<size_t>(get_parameter("scheduler_threads").as_int()));
+    }
+    return scheduler_;
+  }
+
+  // sources of a topic share a subscription, unless they are configured with different QoS
   std::shared_ptr<PlotSubscription> get_or_create_subscription(
     std::string topic,
-    std::shared_ptr<MessageIntrospection> introspection)
+    std::shared_ptr<MessageIntrospection> introspection,
+    const std::optional<QosConfig> & qos = std::nullopt)
   {
     std::unique_lock<std::mutex> lock(topic_mutex_);
 
-    auto it = subscriptions_.begin();
-    while (it != subscriptions_.end()) {
-      auto subscription = it->lock();
+    auto [begin, end] = subscriptions_.equal_range(topic);
+    auto it = begin;
+    while (it != end) {
+      auto subscription = it->second.lock();
       if (subscription) {
-        if (subscription->topic_name() == topic) {
+        if (subscription->qos_config() == qos) {
           return subscription;
         }
         ++it;
@@ -42,27 +203,29 @@ public:
       }
     }
 
+    auto pipeline_workers = get_pipeline_workers(topic);
     auto new_subscription = std::make_shared<PlotSubscription>(
-      topic, get_node_topics_interface(), get_node_clock_interface(),
-      std::make_shared<IntrospectionMessageDeserializer>(introspection));
-    subscriptions_.emplace_back(new_subscription);
+      topic, *this, std::make_shared<IntrospectionMessageDeserializer>(introspection),
+      get_typed_support(introspection->message_type()), ingest_callback_group_, qos, domain_id_,
+      pipeline_workers, pipeline_workers > 0 ? scheduler() : nullptr);
+    subscriptions_.emplace(topic, new_subscription);
+    if (subscriptions_changed_) {
+      ++subscriptions_generation_;
+      subscriptions_changed_->trigger();
+    }
     return new_subscription;
   }
 
   bool is_subscribed_to(std::string topic)
   {
     std::unique_lock<std::mutex> lock(topic_mutex_);
-    auto it = subscriptions_.begin();
-    while (it != subscriptions_.end()) {
-      auto subscription = it->lock();
-      if (subscription) {
-        if (subscription->topic_name() == topic) {
-          return true;
-        }
-        ++it;
-      } else {
-        it = subscriptions_.erase(it);
+    auto [begin, end] = subscriptions_.equal_range(topic);
+    auto it = begin;
+    while (it != end) {
+      if (!it->second.expired()) {
+        return true;
       }
+      it = subscriptions_.erase(it);
     }
     return false;
   }
@@ -72,7 +235,7 @@ public:
     std::unique_lock<std::mutex> lock(topic_mutex_);
     auto it = subscriptions_.begin();
     while (it != subscriptions_.end()) {
-      auto subscription = it->lock();
+      auto subscription = it->second.lock();
       if (subscription) {
         subscription->clear();
         ++it;
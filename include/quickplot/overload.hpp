@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "quickplot/config.hpp"
+
+namespace quickplot
+{
+
+// ingest work of one subscription since the previous update of the OverloadController
+struct IngestLoad
+{
+  // highest priority of the series fed by the subscription
+  SeriesPriority priority;
+  // seconds spent receiving, deserializing and committing messages
+  double busy;
+  // messages received but not committed yet
+  size_t backlog;
+};
+
+/**
+ * Decides which topics are thinned when ingestion takes more time than budgeted, instead of
+ * leaving it to the middleware to drop messages of whichever queue overflows.
+ * Each update compares the ingest time of all subscriptions to the budget. While over budget, or
+ * while a subscription lags more than backlog_limit messages behind, the decimation of the lowest
+ * priority which has subscriptions is doubled, up to MAX_DECIMATION before the next priority is
+ * thinned. Series of High priority are never thinned. Once the load falls below
+ * RECOVERY_FRACTION of the budget, the decimation of the highest thinned priority is halved.
+ */
+class OverloadController
+{
+public:
+  static constexpr size_t MAX_DECIMATION = 64;
+  // halving the decimation at most doubles the load, so it stays within the budget
+  static constexpr double RECOVERY_FRACTION = 0.5;
+
+private:
+  double budget_;
+  size_t backlog_limit_;
+  // received messages per ingested message, indexed by priority
+  std::array<size_t, SERIES_PRIORITY_COUNT> decimation_;
+  double load_ = 0.0;
+  bool overloaded_ = false;
+
+public:
+  // budget is in seconds of ingest work per second, i.e. in cores
+  OverloadController(double budget, size_t backlog_limit);
+
+  // loads measured over the last period seconds
+  void update(const std::vector<IngestLoad> & loads, double period);
+
+  // received messages per ingested message of topics whose series have the priority
+  size_t decimation(SeriesPriority priority) const
+  {
+    return decimation_[static_cast<size_t>(priority)];
+  }
+
+  // seconds of ingest work per second in the last period
+  double load() const
+  {
+    return load_;
+  }
+
+  double budget() const
+  {
+    return budget_;
+  }
+
+  // whether the last period was over budget or had a backlog
+  bool overloaded() const
+  {
+    return overloaded_;
+  }
+
+  // whether any priority is thinned
+  bool shedding() const;
+};
+
+} // namespace quickplot
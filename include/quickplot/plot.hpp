@@ -1,11 +1,15 @@
 #pragma once
+#include <cstddef>
 #include <vector>
 #include <utility>
 #include <memory>
+#include <regex>
 #include <string>
+#include <unordered_set>
 #include "quickplot/config.hpp"
 #include "quickplot/introspection.hpp"
 #include "quickplot/plot_subscription.hpp"
+#include "quickplot/push.hpp"
 
 namespace quickplot
 {
@@ -61,8 +65,44 @@ struct ActiveDataSource
 
   // buffer to time series
   std::shared_ptr<PlotDataBuffer> data;
+
+  // set instead of the subscription if the series is imported from another quickplot process
+  std::shared_ptr<SharedSeriesReader> shared;
+
+  // set instead of the subscription if the series aggregates the topics of a pattern
+  std::shared_ptr<AggregateSeries> aggregate;
+
+  // pushed series received by this process, instead of the subscription
+  std::shared_ptr<PushSeries> pushed;
+
+  // name of the socket channel or pushed series, if the source is not a topic; pushed series may
+  // also be imported from another quickplot process
+  std::string channel;
+
+  std::string topic_name() const
+  {
+    if (subscription) {
+      return subscription->topic_name();
+    }
+    if (aggregate) {
+      return aggregate->name();
+    }
+    if (!channel.empty()) {
+      return channel;
+    }
+    return shared->topic_name();
+  }
 };
 
+DataSourceKind source_kind(const ActiveDataSource & source)
+{
+  if (source.channel.empty()) {
+    return DataSourceKind::Topic;
+  }
+  // socket channels are neither pushed nor imported
+  return source.pushed || source.shared ? DataSourceKind::Push : DataSourceKind::Socket;
+}
+
 // data sources may be uninitialized, or have failed to do so due to runtime error, in which case
 // they are managed as descriptors to display errors to the user
 // if they are initialized and active, they manage the data source and buffers
@@ -73,16 +113,23 @@ struct TimeSeries
   std::string id;
   DataSource source;
   DataSource stddev_source;
+  // added for a topic matching a pattern, so it is saved as part of the pattern
+  bool from_pattern = false;
+  SeriesPriority priority = SeriesPriority::Normal;
 
   std::string topic_name() const
   {
     return std::visit(
       overloaded {
         [this](const ActiveDataSource & active) {
-          return active.subscription->topic_name();
+          return active.topic_name();
         },
         [this](const SourceInfo & source_info) {
-          return source_info.config.topic_name;
+          if (source_info.config.kind != DataSourceKind::Topic) {
+            return source_info.config.topic_name;
+          }
+          return qualified_topic_name(
+            source_info.config.domain_id, source_info.config.topic_name);
         }
       }, source);
   }
@@ -93,11 +140,20 @@ struct TimeSeries
   }
 };
 
+struct TopicPattern
+{
+  TopicPatternConfig config;
+  std::regex regex;
+};
+
 struct Plot
 {
   // time series and its target plot y axis
   std::vector<std::pair<TimeSeries, int>> series;
+  std::vector<TopicPattern> patterns;
   std::vector<AxisConfig> axes;
+  // ids of series of matching topics removed by the user, which patterns do not add again
+  std::unordered_set<std::string> removed_series;
 };
 
 } // namespace quickplot
@@ -3,15 +3,30 @@
 // include implot.h for ImPlotPoint struct, to avoid copies when plotting
 #include "implot.h" // NOLINT
 
+#include "quickplot/config.hpp"
+#include "quickplot/histogram.hpp"
+#include "quickplot/memory.hpp"
 #include "quickplot/message_parser.hpp"
-#include <libstatistics_collector/moving_average_statistics/moving_average.hpp>
+#include "quickplot/scheduler.hpp"
+#include "quickplot/shared_memory.hpp"
+#include "quickplot/snapshot.hpp"
+#include "quickplot/typed_subscription.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
 #include <mutex>
 #include <string>
 #include <utility>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <deque>
+#include <unordered_map>
 #include <list>
+#include <sstream>
 #include <vector>
 #include <boost/circular_buffer.hpp>
 
@@ -19,10 +34,15 @@ namespace quickplot
 {
 using std::placeholders::_1;
 using CircularBuffer = boost::circular_buffer<ImPlotPoint>;
-using libstatistics_collector::moving_average_statistics::MovingAverageStatistics;
-using libstatistics_collector::moving_average_statistics::StatisticData;
+
+static_assert(
+  sizeof(Sample) == sizeof(ImPlotPoint) && alignof(Sample) == alignof(ImPlotPoint) &&
+  offsetof(Sample, x) == offsetof(ImPlotPoint, x) &&
+  offsetof(Sample, y) == offsetof(ImPlotPoint, y),
+  "samples are copied into plot buffers without conversion");
 
 class PlotDataBuffer;
+class PlotSubscription;
 
 /**
  * Immutable random-access-iterator of plot data.
@@ -45,9 +65,136 @@ public:
   CircularBuffer::const_iterator begin() const;
 
   CircularBuffer::const_iterator end() const;
+
+  // time of the newest sample of a run-length encoded buffer, which extends its last state
+  std::optional<double> run_end() const;
+};
+
+// receive timing of a sample, to measure its latency up to the display
+struct SampleTiming
+{
+  // steady time the message was received at
+  std::chrono::nanoseconds received;
+  // receive time minus header stamp in nanoseconds on the node clock, nullopt without stamp
+  std::optional<int64_t> stamp_latency;
+};
+
+// number of (t, stamp to draw) points kept for the latency view
+constexpr size_t LATENCY_SERIES_CAPACITY = 4096;
+
+// latency of the samples of a series on their way from the publisher to the display
+struct SeriesLatency
+{
+  WindowedHistogram stamp_to_receive;
+  WindowedHistogram receive_to_commit;
+  // age of the oldest sample committed since the last frame, when it is first drawn
+  WindowedHistogram commit_to_draw;
+  // header stamp to first draw of the same sample
+  WindowedHistogram stamp_to_draw;
+  // (node time, stamp to draw in milliseconds) points, guarded by the mutex of the buffer
+  CircularBuffer stamp_to_draw_series{LATENCY_SERIES_CAPACITY};
+};
+
+/**
+ * Reduces the samples of many sources to one series, as they are pushed into the buffers of the
+ * sources. Samples are reduced per time bucket, and a bucket is written to the output buffer
+ * once a sample two buckets later arrives, so sources may lag each other by up to one bucket.
+ */
+class AggregateSeries
+{
+private:
+  struct Bucket
+  {
+    int64_t index;
+    double min;
+    double max;
+    double sum;
+    size_t count;
+  };
+
+  mutable std::mutex mutex_;
+  std::string name_;
+  AggregateConfig config_;
+  std::shared_ptr<PlotDataBuffer> output_;
+  // buckets which may still receive samples, in time order
+  std::deque<Bucket> open_;
+  // index of the newest bucket written to the output
+  std::optional<int64_t> written_;
+  size_t late_samples_ = 0;
+
+  struct Member
+  {
+    std::shared_ptr<PlotSubscription> subscription;
+    // set instead of the subscription if the topic is imported from another quickplot process
+    std::shared_ptr<SharedSeriesReader> shared;
+    std::shared_ptr<PlotDataBuffer> buffer;
+  };
+
+  // sources and buffers of the aggregated topics, which forward their samples to this
+  std::unordered_map<std::string, Member> members_;
+
+  // mutex_ must be held
+  void write(const Bucket & bucket);
+
+public:
+  AggregateSeries(std::string name, AggregateConfig config);
+
+  ~AggregateSeries();
+
+  // disable copy and move, since member buffers point to this
+  AggregateSeries & operator=(AggregateSeries &&) = delete;
+
+  const std::string & name() const
+  {
+    return name_;
+  }
+
+  std::shared_ptr<PlotDataBuffer> data() const
+  {
+    return output_;
+  }
+
+  // called by the buffers of the members with their mutex held
+  void add(double x, double y);
+
+  bool has_member(const std::string & topic) const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return members_.find(topic) != members_.end();
+  }
+
+  void add_member(
+    const std::string & topic, std::shared_ptr<PlotSubscription> subscription,
+    std::shared_ptr<PlotDataBuffer> buffer, std::shared_ptr<SharedSeriesReader> shared = nullptr);
+
+  // prepend the history of the output of a previous run; buckets up to the newest restored one
+  // are not written again
+  void restore(const Sample * samples, size_t count);
+
+  size_t member_count() const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return members_.size();
+  }
+
+  std::vector<std::shared_ptr<PlotSubscription>> member_subscriptions() const;
+
+  // readers and buffers of the members imported from another quickplot process, which are read
+  // by the application
+  std::vector<std::pair<std::shared_ptr<SharedSeriesReader>, std::shared_ptr<PlotDataBuffer>>>
+  imported_members() const;
+
+  // samples dropped because their bucket was already written
+  size_t late_samples() const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return late_samples_;
+  }
+
+  void clear();
 };
 
-// Circular buffer of ImPlotPoint
+// Circular buffer of ImPlotPoint, kept sorted by x within the reorder window
 class PlotDataBuffer
 {
   friend class PlotDataContainer;
@@ -57,6 +204,111 @@ private:
   mutable std::mutex mutex_;
   CircularBuffer data_;
   std::weak_ptr<PlotDataContainer> active_container_;
+  // optional segment mirroring the pushed data, to be read by other quickplot processes
+  std::shared_ptr<SharedSeriesWriter> shared_writer_;
+  // set if the samples are only forwarded to an aggregate of many sources, and not stored; the
+  // aggregate owns this buffer and detaches it before it is destroyed
+  AggregateSeries * aggregate_ = nullptr;
+
+  // created on the first commit of a received sample, so buffers of imported, restored or
+  // aggregated series do not carry it; histograms are written with mutex_ held, and read without it
+  std::unique_ptr<SeriesLatency> latency_;
+  // oldest sample committed since the last frame which drew this buffer
+  std::optional<std::pair<SampleTiming, std::chrono::nanoseconds>> oldest_undrawn_;
+
+  // samples up to this many seconds older than the newest sample are inserted in time order,
+  // older samples are dropped; zero to append samples in the order they are pushed
+  double reorder_window_ = 0.0;
+  size_t late_samples_ = 0;
+
+  // store only the first sample of each run of equal values, for flags and enum states
+  bool run_length_ = false;
+  // time of the newest sample, which extends the last run
+  double run_end_ = 0.0;
+
+  static bool same_state(double a, double b)
+  {
+    return a == b || (std::isnan(a) && std::isnan(b));
+  }
+
+  // mutex_ must be held; transitions cannot be inserted into past runs, so late samples are
+  // dropped regardless of the reorder window
+  bool insert_run(const ImPlotPoint & point)
+  {
+    if (!data_.empty() && point.x < run_end_) {
+      late_samples_++;
+      return false;
+    }
+    if (data_.empty() || !same_state(point.y, data_.back().y)) {
+      data_.push_back(point);
+    }
+    run_end_ = point.x;
+    return true;
+  }
+
+  // keep data_ sorted by x, mutex_ must be held and data_ must not be full
+  bool insert_sorted(const ImPlotPoint & point)
+  {
+    if (run_length_) {
+      return insert_run(point);
+    }
+    if (data_.empty() || point.x >= data_.back().x || reorder_window_ <= 0.0) {
+      data_.push_back(point);
+      return true;
+    }
+    if (point.x < data_.back().x - reorder_window_) {
+      late_samples_++;
+      return false;
+    }
+    // late samples are close to the end, so search backwards and only shift the sorted tail
+    auto it = data_.end();
+    while (it != data_.begin() && std::prev(it)->x > point.x) {
+      --it;
+    }
+    data_.insert(it, point);
+    return true;
+  }
+
+  // mutex_ must be held
+  void record_commit(const SampleTiming & timing, std::chrono::nanoseconds committed)
+  {
+    if (!latency_) {
+      latency_ = std::make_unique<SeriesLatency>();
+    }
+    if (timing.stamp_latency.has_value() && timing.stamp_latency.value() >= 0) {
+      latency_->stamp_to_receive.record(
+        static_cast<uint64_t>(timing.stamp_latency.value()), committed);
+    }
+    latency_->receive_to_commit.record(
+      static_cast<uint64_t>((committed - timing.received).count()), committed);
+    if (!oldest_undrawn_.has_value()) {
+      oldest_undrawn_ = std::make_pair(timing, committed);
+    }
+  }
+
+  // timing is nullptr for samples which were not received by this process
+  void push_sample(
+    double x, double y, const SampleTiming * timing,
+    std::chrono::nanoseconds committed)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (aggregate_) {
+      aggregate_->add(x, y);
+      return;
+    }
+    if (data_.full()) {
+      data_.set_capacity(data_.capacity() * 2);
+    }
+    if (!insert_sorted(ImPlotPoint(x, y))) {
+      return;
+    }
+    if (shared_writer_) {
+      shared_writer_->push(x, y);
+    }
+    if (timing) {
+      record_commit(*timing, committed);
+    }
+  }
 
 public:
   explicit PlotDataBuffer(size_t capacity)
@@ -81,22 +333,253 @@ public:
     return data_.empty();
   }
 
+  void export_to(std::shared_ptr<SharedSeriesWriter> writer)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    shared_writer_ = writer;
+  }
+
+  // forward all further samples to the aggregate, dropping the samples stored so far;
+  // nullptr to store samples again
+  void aggregate_to(AggregateSeries * aggregate)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    aggregate_ = aggregate;
+    data_.clear();
+    data_.set_capacity(1);
+  }
+
+  void set_reorder_window(double seconds)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    reorder_window_ = seconds;
+  }
+
+  // must be set before samples are pushed
+  void set_run_length(bool run_length)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    run_length_ = run_length;
+  }
+
+  bool run_length() const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return run_length_;
+  }
+
+  // number of samples dropped for arriving later than the reorder window
+  size_t late_samples() const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return late_samples_;
+  }
+
+  // sample which was not received by this process, so no latency is recorded
   void push(double x, double y)
   {
+    push_sample(x, y, nullptr, std::chrono::nanoseconds::zero());
+  }
+
+  // committed is the steady time the sample is pushed at
+  void push(
+    double x, double y, const SampleTiming & timing,
+    std::chrono::nanoseconds committed)
+  {
+    push_sample(x, y, &timing, committed);
+  }
+
+  // push samples which were not received by this process in order, taking the lock once
+  void push_batch(const std::vector<ImPlotPoint> & points)
+  {
+    push_batch(points, {}, std::chrono::nanoseconds::zero());
+  }
+
+  // push samples in order, taking the lock once; timings holds one entry per point
+  void push_batch(
+    const std::vector<ImPlotPoint> & points,
+    const std::vector<SampleTiming> & timings,
+    std::chrono::nanoseconds committed)
+  {
+    if (points.empty()) {
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
-    if (data_.full()) {
-      data_.set_capacity(data_.capacity() * 2);
+    if (aggregate_) {
+      for (const auto & point : points) {
+        aggregate_->add(point.x, point.y);
+      }
+      return;
+    }
+    auto required = data_.size() + points.size();
+    if (required > data_.capacity()) {
+      data_.set_capacity(std::max(required, data_.capacity() * 2));
+    }
+    bool in_order = data_.empty() || points.front().x >= data_.back().x;
+    for (size_t i = 1; in_order && i < points.size(); i++) {
+      in_order = points[i].x >= points[i - 1].x;
+    }
+    if (!run_length_ && (in_order || reorder_window_ <= 0.0)) {
+      data_.insert(data_.end(), points.begin(), points.end());
+      if (shared_writer_) {
+        for (const auto & point : points) {
+          shared_writer_->push(point.x, point.y);
+        }
+      }
+    } else {
+      for (const auto & point : points) {
+        if (insert_sorted(point) && shared_writer_) {
+          shared_writer_->push(point.x, point.y);
+        }
+      }
+    }
+    for (const auto & timing : timings) {
+      record_commit(timing, committed);
+    }
+  }
+
+  // prepend the samples which are older than the oldest sample in the buffer, to restore the
+  // history of a previous run; samples must be in time order
+  void restore(const Sample * samples, size_t count)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto * points = reinterpret_cast<const ImPlotPoint *>(samples);
+    size_t restored = count;
+    if (!data_.empty()) {
+      auto first_x = data_.front().x;
+      restored = static_cast<size_t>(
+        std::lower_bound(
+          points, points + count, first_x, [](const ImPlotPoint & p, double x) {
+            return p.x < x;
+          }) - points);
+    }
+    if (restored == 0) {
+      return;
+    }
+    if (run_length_) {
+      restore_runs(points, restored);
+      return;
+    }
+    auto required = data_.size() + restored;
+    if (required > data_.capacity()) {
+      data_.set_capacity(std::max(required, data_.capacity() * 2));
+    }
+    data_.insert(data_.begin(), points, points + restored);
+  }
+
+  // mutex_ must be held; the snapshot of a run-length encoded buffer ends with its run end
+  void restore_runs(const ImPlotPoint * points, size_t count)
+  {
+    std::vector<ImPlotPoint> transitions;
+    for (size_t i = 0; i < count; i++) {
+      if (transitions.empty() || !same_state(points[i].y, transitions.back().y)) {
+        transitions.push_back(points[i]);
+      }
+    }
+    if (data_.empty()) {
+      run_end_ = points[count - 1].x;
+    } else if (same_state(transitions.back().y, data_.front().y)) {
+      // the first received run started before the restart
+      data_.pop_front();
+    }
+    auto required = data_.size() + transitions.size();
+    if (required > data_.capacity()) {
+      data_.set_capacity(std::max(required, data_.capacity() * 2));
+    }
+    data_.insert(data_.begin(), transitions.begin(), transitions.end());
+  }
+
+  // copy of the samples with x >= t_start, to be written to a snapshot
+  std::vector<Sample> snapshot(double t_start) const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto begin = std::lower_bound(
+      data_.begin(), data_.end(), t_start, [](const ImPlotPoint & p, double x) {
+        return p.x < x;
+      });
+    // the run which started before t_start is still the state at t_start
+    if (run_length_ && begin != data_.begin()) {
+      --begin;
+    }
+    std::vector<Sample> samples(static_cast<size_t>(data_.end() - begin));
+    std::copy(begin, data_.end(), reinterpret_cast<ImPlotPoint *>(samples.data()));
+    if (run_length_ && !data_.empty() && run_end_ > data_.back().x) {
+      samples.push_back({run_end_, data_.back().y});
+    }
+    return samples;
+  }
+
+  /**
+   * Record the latency of the oldest sample committed since the previous frame, which is drawn
+   * for the first time in the frame at node time t.
+   * Must not be called while a PlotDataContainer of this buffer is alive.
+   */
+  void mark_drawn(double t, std::chrono::nanoseconds now)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!oldest_undrawn_.has_value()) {
+      return;
+    }
+    const auto & [timing, committed] = oldest_undrawn_.value();
+    latency_->commit_to_draw.record(static_cast<uint64_t>((now - committed).count()), now);
+    if (timing.stamp_latency.has_value() && timing.stamp_latency.value() >= 0) {
+      auto stamp_to_draw = timing.stamp_latency.value() + (now - timing.received).count();
+      latency_->stamp_to_draw.record(static_cast<uint64_t>(stamp_to_draw), now);
+      latency_->stamp_to_draw_series.push_back(ImPlotPoint(t, stamp_to_draw * 1e-6));
     }
-    data_.push_back(
-      ImPlotPoint(
-        x,
-        y));
+    oldest_undrawn_.reset();
+  }
+
+  MemoryUsage memory_usage() const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    MemoryUsage usage {
+      .used = data_.size() * sizeof(ImPlotPoint),
+      .reserved = data_.capacity() * sizeof(ImPlotPoint),
+    };
+    if (latency_) {
+      size_t histograms = latency_->stamp_to_receive.memory_size() +
+        latency_->receive_to_commit.memory_size() + latency_->commit_to_draw.memory_size() +
+        latency_->stamp_to_draw.memory_size();
+      usage.used += latency_->stamp_to_draw_series.size() * sizeof(ImPlotPoint) + histograms;
+      usage.reserved += latency_->stamp_to_draw_series.capacity() * sizeof(ImPlotPoint) +
+        histograms;
+    }
+    return usage;
+  }
+
+  // nullptr until a received sample is committed; once created, it lives as long as the buffer
+  const SeriesLatency * latency() const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return latency_.get();
+  }
+
+  // copy of the (node time, stamp to draw in milliseconds) points of the latency view
+  std::vector<ImPlotPoint> latency_series() const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!latency_) {
+      return {};
+    }
+    const auto & series = latency_->stamp_to_draw_series;
+    return std::vector<ImPlotPoint>(series.begin(), series.end());
   }
 
   void clear_data_up_to(rclcpp::Time t)
   {
     std::unique_lock<std::mutex> lock(mutex_);
     auto s = t.seconds();
+    if (run_length_) {
+      // keep the run which started before t, unless it also ended before t
+      if (!data_.empty() && run_end_ < s) {
+        data_.clear();
+      }
+      while (data_.size() > 1 && data_[1].x <= s) {
+        data_.pop_front();
+      }
+      return;
+    }
     while (!data_.empty()) {
       if (data_.front().x < s) {
         data_.pop_front();
@@ -109,10 +592,148 @@ public:
   void clear()
   {
     std::unique_lock<std::mutex> lock(mutex_);
+    if (aggregate_) {
+      // buffers of all members are cleared together, for example on a time jump
+      aggregate_->clear();
+    }
     data_.clear();
+    if (latency_) {
+      latency_->stamp_to_draw_series.clear();
+    }
+    oldest_undrawn_.reset();
+    if (shared_writer_) {
+      shared_writer_->clear();
+    }
   }
 };
 
+AggregateSeries::AggregateSeries(std::string name, AggregateConfig config)
+: name_(name), config_(config), output_(std::make_shared<PlotDataBuffer>(1))
+{
+
+}
+
+AggregateSeries::~AggregateSeries()
+{
+  for (auto & [_, member] : members_) {
+    member.buffer->aggregate_to(nullptr);
+  }
+}
+
+void AggregateSeries::write(const Bucket & bucket)
+{
+  double value;
+  if (config_.op == AggregateOperator::Min) {
+    value = bucket.min;
+  } else if (config_.op == AggregateOperator::Max) {
+    value = bucket.max;
+  } else {
+    value = bucket.sum / static_cast<double>(bucket.count);
+  }
+  // points are drawn at the center of their bucket
+  output_->push((static_cast<double>(bucket.index) + 0.5) * config_.bucket, value);
+  written_ = bucket.index;
+}
+
+void AggregateSeries::add(double x, double y)
+{
+  if (std::isnan(y)) {
+    return;
+  }
+  auto index = static_cast<int64_t>(std::floor(x / config_.bucket));
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (written_.has_value() && index <= written_.value()) {
+    late_samples_++;
+    return;
+  }
+  // samples are mostly in the newest bucket, so search from the back
+  auto it = open_.end();
+  while (it != open_.begin() && std::prev(it)->index >= index) {
+    --it;
+  }
+  if (it != open_.end() && it->index == index) {
+    it->min = std::min(it->min, y);
+    it->max = std::max(it->max, y);
+    it->sum += y;
+    it->count++;
+  } else {
+    open_.insert(
+      it, Bucket {
+        .index = index,
+        .min = y,
+        .max = y,
+        .sum = y,
+        .count = 1,
+      });
+  }
+  auto newest = open_.back().index;
+  while (open_.front().index < newest - 1) {
+    write(open_.front());
+    open_.pop_front();
+  }
+}
+
+void AggregateSeries::add_member(
+  const std::string & topic, std::shared_ptr<PlotSubscription> subscription,
+  std::shared_ptr<PlotDataBuffer> buffer, std::shared_ptr<SharedSeriesReader> shared)
+{
+  buffer->aggregate_to(this);
+  std::unique_lock<std::mutex> lock(mutex_);
+  members_.emplace(
+    topic, Member {
+      .subscription = subscription,
+      .shared = shared,
+      .buffer = buffer,
+    });
+}
+
+void AggregateSeries::restore(const Sample * samples, size_t count)
+{
+  if (count == 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  output_->restore(samples, count);
+  auto newest = static_cast<int64_t>(std::floor(samples[count - 1].x / config_.bucket));
+  if (!written_.has_value() || newest > written_.value()) {
+    written_ = newest;
+  }
+}
+
+std::vector<std::shared_ptr<PlotSubscription>> AggregateSeries::member_subscriptions() const
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::vector<std::shared_ptr<PlotSubscription>> subscriptions;
+  for (const auto & [_, member] : members_) {
+    if (member.subscription) {
+      subscriptions.push_back(member.subscription);
+    }
+  }
+  return subscriptions;
+}
+
+std::vector<std::pair<std::shared_ptr<SharedSeriesReader>, std::shared_ptr<PlotDataBuffer>>>
+AggregateSeries::imported_members() const
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::vector<std::pair<std::shared_ptr<SharedSeriesReader>, std::shared_ptr<PlotDataBuffer>>>
+  imported;
+  for (const auto & [_, member] : members_) {
+    if (member.shared) {
+      imported.emplace_back(member.shared, member.buffer);
+    }
+  }
+  return imported;
+}
+
+void AggregateSeries::clear()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  open_.clear();
+  written_.reset();
+  output_->clear();
+}
+
 PlotDataContainer::PlotDataContainer(const PlotDataBuffer * parent)
 : parent_(parent), lock_(parent_->mutex_)
 {
@@ -143,6 +764,14 @@ CircularBuffer::const_iterator PlotDataContainer::end() const
   return parent_->data_.end();
 }
 
+std::optional<double> PlotDataContainer::run_end() const
+{
+  if (!parent_ || !parent_->run_length_ || parent_->data_.empty()) {
+    return std::nullopt;
+  }
+  return parent_->run_end_;
+}
+
 // return vector of items in b2, with nan values for every timestamp in b1 that does not occur in b2
 // timestamps in buffers are assumed to be sorted in ascending order already
 template<typename Iterator>
@@ -174,124 +803,1146 @@ std::vector<double> sync_right(
   return result;
 }
 
-struct ActiveBuffer
+// sources without QoS config use the sensor data profile, which is the default for plotting
+inline rclcpp::QoS make_qos(const std::optional<QosConfig> & config)
 {
-  MessageAccessor accessor;
-  std::weak_ptr<PlotDataBuffer> buffer;
-};
+  if (!config.has_value()) {
+    return rclcpp::SensorDataQoS();
+  }
+  rclcpp::QoS qos = config->history == QosHistory::KeepAll ?
+    rclcpp::QoS(rclcpp::KeepAll()) : rclcpp::QoS(rclcpp::KeepLast(config->depth));
+  if (config->reliability == QosReliability::Reliable) {
+    qos.reliable();
+  } else {
+    qos.best_effort();
+  }
+  return qos;
+}
 
-class PlotSubscription
+/**
+ * Detects gaps between the header stamps of consecutive messages, which indicate messages lost
+ * anywhere between the publisher and the plot, including losses the middleware does not report.
+ * A step is a gap if it is larger than GAP_FACTOR times the usual stamp period.
+ */
+class StampGapDetector
 {
 private:
-  std::vector<uint8_t> message_buffer_;
-  std::shared_ptr<IntrospectionMessageDeserializer> deserializer_;
-  rclcpp::node_interfaces::NodeClockInterface::SharedPtr node_clock_interface_;
-  rclcpp::GenericSubscription::SharedPtr subscription_;
-
-  rclcpp::Time last_received_;
-  rclcpp::Clock steady_clock_{RCL_STEADY_TIME};
-  MovingAverageStatistics receive_period_stats_;
+  static constexpr double GAP_FACTOR = 1.8;
+  // number of consecutive gaps after which the stamp period is assumed to have changed
+  static constexpr size_t RATE_CHANGE_GAPS = 3;
 
-  // protect access to list of buffers
-  mutable std::mutex buffers_mutex_;
+  double last_stamp_ = 0.0;
+  bool has_last_stamp_ = false;
+  // moving average of the steps which are not gaps, zero until the second stamp
+  double period_ = 0.0;
+  size_t consecutive_gaps_ = 0;
 
-  // Using list instead of vector, since the emplace_back operation does not require
-  // the element to be MoveConstructible for resizing the array. The data buffer should
-  // not be move constructed.
-  std::list<ActiveBuffer> buffers_;
+  uint64_t gaps_ = 0;
+  uint64_t missing_ = 0;
 
 public:
-  explicit PlotSubscription(
-    std::string topic_name,
-    rclcpp::node_interfaces::NodeTopicsInterface::SharedPtr topics_interface,
-    rclcpp::node_interfaces::NodeClockInterface::SharedPtr clock_interface,
-    std::shared_ptr<IntrospectionMessageDeserializer> deserializer)
-  : deserializer_(deserializer), node_clock_interface_(clock_interface)
+  // returns true if there is a gap before this stamp
+  bool update(double stamp)
   {
-    message_buffer_ = deserializer_->init_buffer();
-    subscription_ = rclcpp::create_generic_subscription(
-      topics_interface,
-      topic_name,
-      deserializer_->message_type(),
-      rclcpp::SensorDataQoS(),
-      std::bind(&PlotSubscription::receive_callback, this, _1),
-      rclcpp::SubscriptionOptionsWithAllocator<std::allocator<void>>()
-    );
-  }
-
-  ~PlotSubscription()
+    double step = stamp - last_stamp_;
+    bool had_last_stamp = has_last_stamp_;
+    last_stamp_ = stamp;
+    has_last_stamp_ = true;
+    if (!had_last_stamp || step == 0.0) {
+      return false;
+    }
+    if (step < 0.0) {
+      // stamps jumped back, e.g. on sim time restart; estimate the period anew
+      period_ = 0.0;
+      consecutive_gaps_ = 0;
+      return false;
+    }
+    if (period_ == 0.0) {
+      period_ = step;
+      return false;
+    }
+    if (step > GAP_FACTOR * period_) {
+      ++gaps_;
+      missing_ += static_cast<uint64_t>(std::max(std::round(step / period_) - 1.0, 1.0));
+      if (++consecutive_gaps_ >= RATE_CHANGE_GAPS) {
+        period_ = step;
+        consecutive_gaps_ = 0;
+      }
+      return true;
+    }
+    consecutive_gaps_ = 0;
+    period_ = 0.9 * period_ + 0.1 * step;
+    return false;
+  }
+
+  // number of detected gaps
+  uint64_t gaps() const
   {
-    deserializer_->fini_buffer(message_buffer_);
+    return gaps_;
   }
 
-  // disable copy and move
-  PlotSubscription & operator=(PlotSubscription && other) = delete;
+  // estimated number of messages missing in all gaps
+  uint64_t missing() const
+  {
+    return missing_;
+  }
 
-  std::string topic_name() const
+  void reset()
   {
-    return subscription_->get_topic_name();
+    *this = StampGapDetector();
   }
+};
 
-  std::shared_ptr<PlotDataBuffer> add_source(MessageAccessor accessor)
+// statistics of the messages received in the recent window
+struct ReceiveStats
+{
+  // inter-arrival time in nanoseconds
+  HistogramSummary period;
+  // receive time minus header stamp in nanoseconds, on the node clock
+  HistogramSummary latency;
+  // serialized message size in bytes, empty for typed subscriptions
+  HistogramSummary message_size;
+};
+
+struct ActiveBuffer
+{
+  MessageAccessor accessor;
+  // direct load of the member, if the message type has a typed fast path for it
+  FieldGetter getter;
+  std::weak_ptr<PlotDataBuffer> buffer;
+  // samples taken in the current batch, pushed to the buffer at once
+  std::vector<ImPlotPoint> pending;
+  std::vector<SampleTiming> pending_timing;
+};
+
+// value of a source in a message, nullopt if the message does not contain a keyed item
+inline std::optional<double> extract_value(
+  const void * message, MessageAccessor & accessor, FieldGetter getter)
+{
+  if (accessor.key.has_value() && !resolve_sequence_key(message, accessor)) {
+    return std::nullopt;
+  }
+  if (getter) {
+    auto value = getter(message);
+    if (accessor.op == DataSourceOperator::Sqrt) {
+      value = std::sqrt(value);
+    }
+    return value;
+  }
+  return get_numeric(message, accessor.member, accessor.op);
+}
+
+// source of an IngestCore as seen by the workers of an IngestPipeline
+struct PipelineSource
+{
+  MessageAccessor accessor;
+  FieldGetter getter;
+  std::weak_ptr<PlotDataBuffer> buffer;
+};
+
+using PipelineSources = std::vector<PipelineSource>;
+
+// values of one message, extracted by a pipeline worker and committed in arrival order
+struct ExtractedMessage
+{
+  // node and steady time of the receive
+  rclcpp::Time receive_time;
+  std::chrono::nanoseconds received;
+  std::optional<rclcpp::Time> stamp;
+  // sources the values were extracted for
+  std::shared_ptr<const PipelineSources> sources;
+  std::vector<std::optional<double>> values;
+};
+
+// time sources of the ingestion; FakeIngestClock makes benchmarks and tests deterministic
+class IngestClock
+{
+public:
+  virtual ~IngestClock() = default;
+
+  // node time, the x value of samples without header stamp
+  virtual rclcpp::Time now() = 0;
+
+  // monotonic time of the receive statistics and latency measurements
+  virtual std::chrono::nanoseconds steady_now() = 0;
+};
+
+class NodeIngestClock : public IngestClock
+{
+private:
+  rclcpp::Clock::SharedPtr clock_;
+
+public:
+  explicit NodeIngestClock(rclcpp::Clock::SharedPtr clock)
+  : clock_(clock)
+  {
+
+  }
+
+  rclcpp::Time now() override
+  {
+    return clock_->now();
+  }
+
+  std::chrono::nanoseconds steady_now() override
+  {
+    return std::chrono::steady_clock::now().time_since_epoch();
+  }
+};
+
+// clock which only advances when told to
+class FakeIngestClock : public IngestClock
+{
+private:
+  rclcpp::Time now_;
+  std::chrono::nanoseconds steady_now_;
+
+public:
+  // steady time starts above zero, which means no message was received yet
+  explicit FakeIngestClock(
+    rclcpp::Time start = rclcpp::Time(0, 0, RCL_ROS_TIME),
+    std::chrono::nanoseconds steady_start = std::chrono::seconds(1))
+  : now_(start), steady_now_(steady_start)
+  {
+
+  }
+
+  void advance(std::chrono::nanoseconds step)
+  {
+    now_ += rclcpp::Duration(step);
+    steady_now_ += step;
+  }
+
+  rclcpp::Time now() override
+  {
+    return now_;
+  }
+
+  std::chrono::nanoseconds steady_now() override
+  {
+    return steady_now_;
+  }
+};
+
+/**
+ * Ingestion of the messages of one topic into the plot buffers of its sources: deserialization,
+ * member access, receive statistics and commit into the buffers.
+ * Does not depend on the middleware, so it can be fed with serialized messages directly, see
+ * test/benchmark_ingest.cpp.
+ */
+class IngestCore
+{
+private:
+  std::shared_ptr<IntrospectionMessageDeserializer> deserializer_;
+  std::shared_ptr<IngestClock> clock_;
+  std::vector<uint8_t> message_buffer_;
+  // reused by receive_batch
+  rclcpp::SerializedMessage serialized_message_;
+
+  // protected by buffers_mutex_
+  StampGapDetector stamp_gaps_;
+
+  // steady time of the last received message, zero before the first one
+  std::chrono::nanoseconds last_received_{0};
+  WindowedHistogram receive_period_;
+  // written with buffers_mutex_ held
+  WindowedHistogram latency_;
+  WindowedHistogram message_size_;
+
+  // protect access to list of buffers
+  mutable std::mutex buffers_mutex_;
+
+  // Using list instead of vector, since the emplace_back operation does not require
+  // the element to be MoveConstructible for resizing the array. The data buffer should
+  // not be move constructed.
+  std::list<ActiveBuffer> buffers_;
+
+  // received messages per ingested message, set by the overload controller
+  std::atomic<size_t> decimation_{1};
+  // position in the decimation cycle, only used by the receiving thread
+  size_t decimation_phase_ = 0;
+  std::atomic<uint64_t> shed_messages_{0};
+  // nanoseconds spent ingesting messages since the last take_busy_time
+  std::atomic<uint64_t> busy_ns_{0};
+
+  // incremented when a source is added or removed, so pipeline workers refresh their sources
+  std::atomic<size_t> sources_generation_{0};
+  // protected by buffers_mutex_
+  std::shared_ptr<const PipelineSources> pipeline_sources_;
+  size_t pipeline_sources_generation_ = 0;
+  // reused by commit
+  std::vector<double> commit_times_;
+  std::vector<SampleTiming> commit_timing_;
+  std::vector<ImPlotPoint> commit_points_;
+  std::vector<SampleTiming> commit_point_timing_;
+
+  // record the arrival of a message; serialized_size is zero if the message was not serialized
+  void record_receive(size_t serialized_size = 0)
+  {
+    auto now = clock_->steady_now();
+    if (last_received_.count() != 0) {
+      receive_period_.record(static_cast<uint64_t>((now - last_received_).count()), now);
+    }
+    last_received_ = now;
+    if (serialized_size != 0) {
+      message_size_.record(serialized_size, now);
+    }
+  }
+
+  // x value of the samples of a message, the header stamp if it has one, updating the stamp
+  // statistics
+  // buffers_mutex_ must be held by the caller
+  rclcpp::Time sample_time(
+    const std::optional<rclcpp::Time> & stamp, const rclcpp::Time & receive_time,
+    SampleTiming & timing)
+  {
+    if (!stamp.has_value()) {
+      return receive_time;
+    }
+    auto t = stamp.value();
+    stamp_gaps_.update(t.seconds());
+    // stamps ahead of the receive time mean the clocks of publisher and quickplot disagree
+    auto latency = (receive_time - t).nanoseconds();
+    if (latency >= 0) {
+      latency_.record(static_cast<uint64_t>(latency), timing.received);
+    }
+    timing.stamp_latency = latency;
+    return t;
+  }
+
+  // push the values of all sources from the message, in the memory layout of its introspection
+  // typesupport, or append them to the pending batch of each buffer
+  // buffers_mutex_ must be held by the caller
+  void extract_values(const void * message, bool batch)
+  {
+    SampleTiming timing {
+      .received = last_received_,
+      .stamp_latency = std::nullopt,
+    };
+    auto t = sample_time(deserializer_->get_header_stamp(message), clock_->now(), timing);
+    auto it = buffers_.begin();
+    while (it != buffers_.end()) {
+      auto buffer = it->buffer.lock();
+      if (!buffer) {
+        it = buffers_.erase(it);
+        ++sources_generation_;
+        continue;
+      }
+      auto extracted = extract_value(message, it->accessor, it->getter);
+      if (!extracted.has_value()) {
+        // the message does not contain the keyed item
+        ++it;
+        continue;
+      }
+      auto value = extracted.value();
+      if (batch) {
+        it->pending.emplace_back(t.seconds(), value);
+        it->pending_timing.push_back(timing);
+      } else {
+        buffer->push(t.seconds(), value, timing, clock_->steady_now());
+      }
+      ++it;
+    }
+  }
+
+public:
+  IngestCore(
+    std::shared_ptr<IntrospectionMessageDeserializer> deserializer,
+    std::shared_ptr<IngestClock> clock)
+  : deserializer_(deserializer), clock_(clock)
+  {
+    message_buffer_ = deserializer_->init_buffer();
+  }
+
+  ~IngestCore()
+  {
+    deserializer_->fini_buffer(message_buffer_);
+  }
+
+  // disable copy and move
+  IngestCore & operator=(IngestCore && other) = delete;
+
+  // getter is the typed fast path of the accessor, or nullptr
+  std::shared_ptr<PlotDataBuffer> add_source(MessageAccessor accessor, FieldGetter getter)
   {
     std::unique_lock<std::mutex> lock(buffers_mutex_);
     auto buffer = std::make_shared<PlotDataBuffer>(1);
+    buffer->set_run_length(is_state(accessor));
     buffers_.emplace_back(
       ActiveBuffer {
         .accessor = accessor,
+        .getter = getter,
         .buffer = buffer,
       });
+    ++sources_generation_;
     return buffer;
   }
 
-  StatisticData receive_period_stats() const
+  /**
+   * Whether the message is dropped to thin the topic while ingestion is overloaded, before it is
+   * deserialized. Shed messages are recorded in the receive statistics, so these still show the
+   * rate of the topic.
+   * Called once per received message by the receiving thread.
+   */
+  bool shed(size_t serialized_size = 0)
   {
-    return receive_period_stats_.GetStatistics();
+    auto decimation = decimation_.load(std::memory_order_relaxed);
+    if (decimation <= 1 || decimation_phase_++ % decimation == 0) {
+      return false;
+    }
+    record_receive(serialized_size);
+    ++shed_messages_;
+    return true;
   }
 
-  void receive_callback(std::shared_ptr<rclcpp::SerializedMessage> message)
+  void set_decimation(size_t decimation)
+  {
+    decimation_ = std::max<size_t>(decimation, 1);
+  }
+
+  size_t decimation() const
+  {
+    return decimation_;
+  }
+
+  // messages dropped by shed
+  uint64_t shed_messages() const
+  {
+    return shed_messages_;
+  }
+
+  std::chrono::nanoseconds steady_now()
+  {
+    return clock_->steady_now();
+  }
+
+  // account the time since start to the ingest work of this topic
+  void add_busy_time(std::chrono::nanoseconds start)
+  {
+    busy_ns_ += static_cast<uint64_t>((clock_->steady_now() - start).count());
+  }
+
+  // time spent ingesting messages since the previous call
+  std::chrono::nanoseconds take_busy_time()
+  {
+    return std::chrono::nanoseconds(busy_ns_.exchange(0));
+  }
+
+  void receive_serialized(const rclcpp::SerializedMessage & message)
   {
-    auto t_steady = steady_clock_.now();
-    if (last_received_.nanoseconds() != 0) {
-      receive_period_stats_.AddMeasurement((t_steady - last_received_).seconds());
+    if (shed(message.size())) {
+      return;
     }
-    last_received_ = t_steady;
+    record_receive(message.size());
+    deserializer_->deserialize(message, message_buffer_.data());
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    extract_values(message_buffer_.data(), false);
+    lock.unlock();
+    add_busy_time(last_received_);
+  }
 
-    deserializer_->deserialize(*message, message_buffer_.data());
-    auto stamp = deserializer_->get_header_stamp(message_buffer_.data());
-    rclcpp::Time t;
-    if (stamp.has_value()) {
-      t = stamp.value();
-    } else {
-      t = node_clock_interface_->get_clock()->now();
+  // receive a message in the memory layout of its introspection typesupport
+  void receive_message(const void * message)
+  {
+    if (shed()) {
+      return;
     }
-    {
-      std::unique_lock<std::mutex> lock(buffers_mutex_);
-      std::remove_if(
-        buffers_.begin(), buffers_.end(), [this, t](ActiveBuffer & ab) {
-          auto buffer = ab.buffer.lock();
-          if (!buffer) {
-            return true;
+    record_receive();
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    extract_values(message, false);
+    lock.unlock();
+    add_busy_time(last_received_);
+  }
+
+  /**
+   * Receive up to max_messages serialized messages, and push them to each buffer in a single
+   * batch. take(rclcpp::SerializedMessage &) returns false if no message is left.
+   */
+  template<typename TakeFunction>
+  size_t receive_batch(TakeFunction take, size_t max_messages)
+  {
+    auto start = clock_->steady_now();
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    size_t taken = 0;
+    while (taken < max_messages && take(serialized_message_)) {
+      ++taken;
+      if (shed(serialized_message_.size())) {
+        continue;
+      }
+      record_receive(serialized_message_.size());
+      deserializer_->deserialize(serialized_message_, message_buffer_.data());
+      extract_values(message_buffer_.data(), true);
+    }
+    auto committed = clock_->steady_now();
+    for (auto & ab : buffers_) {
+      if (ab.pending.empty()) {
+        continue;
+      }
+      auto buffer = ab.buffer.lock();
+      if (buffer) {
+        buffer->push_batch(ab.pending, ab.pending_timing, committed);
+      }
+      ab.pending.clear();
+      ab.pending_timing.clear();
+    }
+    lock.unlock();
+    add_busy_time(start);
+    return taken;
+  }
+
+  /**
+   * Record the receive of a message which is handed to an IngestPipeline, in arrival order.
+   * Sets the receive times of the message.
+   */
+  void receive_pipelined(size_t serialized_size, ExtractedMessage & message)
+  {
+    record_receive(serialized_size);
+    message.receive_time = clock_->now();
+    message.received = last_received_;
+  }
+
+  size_t sources_generation() const
+  {
+    return sources_generation_;
+  }
+
+  // sources as seen by pipeline workers, rebuilt after sources were added or removed
+  std::shared_ptr<const PipelineSources> pipeline_sources()
+  {
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    if (!pipeline_sources_ || pipeline_sources_generation_ != sources_generation_) {
+      pipeline_sources_generation_ = sources_generation_;
+      auto sources = std::make_shared<PipelineSources>();
+      for (const auto & ab : buffers_) {
+        if (!ab.buffer.expired()) {
+          sources->push_back({ab.accessor, ab.getter, ab.buffer});
+        }
+      }
+      pipeline_sources_ = sources;
+    }
+    return pipeline_sources_;
+  }
+
+  /**
+   * Push the values extracted by pipeline workers to the buffers; messages are in arrival order.
+   * The messages extracted for the same sources are pushed to each buffer in one batch.
+   */
+  void commit(const std::vector<ExtractedMessage *> & messages)
+  {
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    commit_times_.clear();
+    commit_timing_.clear();
+    for (const auto * message : messages) {
+      auto & timing = commit_timing_.emplace_back(
+        SampleTiming {
+          .received = message->received,
+          .stamp_latency = std::nullopt,
+        });
+      commit_times_.push_back(sample_time(message->stamp, message->receive_time, timing).seconds());
+    }
+    auto committed = clock_->steady_now();
+    bool expired = false;
+    size_t begin = 0;
+    while (begin < messages.size()) {
+      const auto & sources = messages[begin]->sources;
+      auto end = begin;
+      while (end < messages.size() && messages[end]->sources == sources) {
+        ++end;
+      }
+      for (size_t i = 0; i < sources->size(); i++) {
+        auto buffer = (*sources)[i].buffer.lock();
+        if (!buffer) {
+          expired = true;
+          continue;
+        }
+        commit_points_.clear();
+        commit_point_timing_.clear();
+        for (auto j = begin; j < end; j++) {
+          const auto & value = messages[j]->values[i];
+          if (value.has_value()) {
+            commit_points_.emplace_back(commit_times_[j], value.value());
+            commit_point_timing_.push_back(commit_timing_[j]);
           }
-          double value = get_numeric(message_buffer_.data(), ab.accessor.member, ab.accessor.op);
-          buffer->push(t.seconds(), value);
-          return false;
+        }
+        if (!commit_points_.empty()) {
+          buffer->push_batch(commit_points_, commit_point_timing_, committed);
+        }
+      }
+      begin = end;
+    }
+    if (expired) {
+      buffers_.remove_if(
+        [](const ActiveBuffer & ab) {
+          return ab.buffer.expired();
         });
+      ++sources_generation_;
+    }
+  }
+
+  uint64_t stamp_gaps() const
+  {
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    return stamp_gaps_.gaps();
+  }
+
+  uint64_t stamp_gap_missing() const
+  {
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    return stamp_gaps_.missing();
+  }
+
+  ReceiveStats receive_stats() const
+  {
+    auto now = clock_->steady_now();
+    return ReceiveStats {
+      .period = receive_period_.summary(now),
+      .latency = latency_.summary(now),
+      .message_size = message_size_.summary(now),
+    };
+  }
+
+  // scratch buffers and statistics, excluding the plot buffers; memory owned by members of the
+  // deserialized message is not included
+  MemoryUsage memory_usage() const
+  {
+    size_t histograms = receive_period_.memory_size() + latency_.memory_size() +
+      message_size_.memory_size();
+    // the serialized message is reused by receive_batch with buffers_mutex_ held
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    MemoryUsage usage {
+      .used = message_buffer_.size() + serialized_message_.size() + histograms,
+      .reserved = message_buffer_.capacity() + serialized_message_.capacity() + histograms,
+    };
+    for (const auto & ab : buffers_) {
+      usage.used += sizeof(ActiveBuffer);
+      usage.reserved += sizeof(ActiveBuffer) + ab.pending.capacity() * sizeof(ImPlotPoint) +
+        ab.pending_timing.capacity() * sizeof(SampleTiming);
     }
+    return usage;
   }
 
   void clear()
   {
+    shed_messages_ = 0;
+    receive_period_.clear();
+    message_size_.clear();
     std::unique_lock<std::mutex> lock(buffers_mutex_);
-    std::remove_if(
-      buffers_.begin(), buffers_.end(), [](auto & ab) {
+    latency_.clear();
+    stamp_gaps_.reset();
+    bool expired = false;
+    buffers_.remove_if(
+      [&expired](ActiveBuffer & ab) {
         auto buffer = ab.buffer.lock();
         if (!buffer) {
+          expired = true;
           return true;
         }
         buffer->clear();
         return false;
       });
+    if (expired) {
+      ++sources_generation_;
+    }
+  }
+};
+
+/**
+ * Deserializes the messages of one subscription on several workers of the TaskScheduler, for
+ * topics whose deserialization saturates a core; callbacks of a single subscription are never run
+ * in parallel by an executor.
+ * Up to workers ingest tasks of a pipeline run at once, each with its own scratch message. Tasks
+ * write the values of a message into a slot of a ring indexed by its arrival sequence number, and
+ * the task completing the oldest message commits all consecutive completed messages to the
+ * buffers, so samples are committed in arrival order. At most capacity messages are in flight;
+ * submit blocks while the ring is full.
+ */
+class IngestPipeline
+{
+private:
+  struct Job
+  {
+    uint64_t sequence;
+    std::shared_ptr<rclcpp::SerializedMessage> message;
+  };
+
+  // state of a running task, kept between tasks so the scratch message is allocated once
+  struct WorkerState
+  {
+    std::vector<uint8_t> scratch;
+    std::shared_ptr<const PipelineSources> sources;
+    // copies of the accessors of the sources, which cache the index of keyed items
+    std::vector<MessageAccessor> accessors;
+    size_t generation = 0;
+  };
+
+  IngestCore & core_;
+  std::shared_ptr<IntrospectionMessageDeserializer> deserializer_;
+  std::shared_ptr<TaskScheduler> scheduler_;
+  size_t workers_;
+  size_t capacity_;
+
+  std::mutex queue_mutex_;
+  // submit waits for a free slot, flush and the destructor for the commit of all messages
+  std::condition_variable slot_available_;
+  std::deque<Job> jobs_;
+  // states of the tasks which are not running
+  std::vector<std::unique_ptr<WorkerState>> idle_states_;
+  size_t running_tasks_ = 0;
+  // only written by the submitting thread
+  uint64_t submitted_ = 0;
+  std::atomic<uint64_t> committed_{0};
+
+  // reorder stage, slots are indexed by sequence modulo capacity
+  std::mutex reorder_mutex_;
+  std::vector<ExtractedMessage> slots_;
+  std::vector<bool> completed_;
+  bool committing_ = false;
+  // reused by the committing task
+  std::vector<ExtractedMessage *> commit_batch_;
+  std::atomic<uint64_t> out_of_order_{0};
+
+  void complete(uint64_t sequence)
+  {
+    std::unique_lock<std::mutex> lock(reorder_mutex_);
+    completed_[sequence % capacity_] = true;
+    if (sequence != committed_) {
+      ++out_of_order_;
+    }
+    if (committing_) {
+      // the committing task picks up this message
+      return;
+    }
+    committing_ = true;
+    while (true) {
+      commit_batch_.clear();
+      auto next = committed_.load();
+      while (commit_batch_.size() < capacity_) {
+        auto slot = (next + commit_batch_.size()) % capacity_;
+        if (!completed_[slot]) {
+          break;
+        }
+        commit_batch_.push_back(&slots_[slot]);
+      }
+      if (commit_batch_.empty()) {
+        committing_ = false;
+        return;
+      }
+      // commit without the reorder lock, so other tasks complete messages meanwhile
+      lock.unlock();
+      core_.commit(commit_batch_);
+      for (auto * message : commit_batch_) {
+        message->sources.reset();
+      }
+      lock.lock();
+      for (size_t i = 0; i < commit_batch_.size(); i++) {
+        completed_[(next + i) % capacity_] = false;
+      }
+      {
+        std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+        committed_ = next + commit_batch_.size();
+      }
+      slot_available_.notify_all();
+    }
+  }
+
+  void extract(WorkerState & state, Job & job)
+  {
+    if (!state.sources || state.generation != core_.sources_generation()) {
+      state.generation = core_.sources_generation();
+      state.sources = core_.pipeline_sources();
+      state.accessors.clear();
+      for (const auto & source : *state.sources) {
+        state.accessors.push_back(source.accessor);
+      }
+    }
+    auto start = core_.steady_now();
+    // the slot is not reused before the message is committed
+    auto & extracted = slots_[job.sequence % capacity_];
+    deserializer_->deserialize(*job.message, state.scratch.data());
+    job.message.reset();
+    extracted.stamp = deserializer_->get_header_stamp(state.scratch.data());
+    extracted.sources = state.sources;
+    extracted.values.resize(state.sources->size());
+    for (size_t i = 0; i < state.sources->size(); i++) {
+      extracted.values[i] = extract_value(
+        state.scratch.data(), state.accessors[i], (*state.sources)[i].getter);
+    }
+    complete(job.sequence);
+    core_.add_busy_time(start);
+  }
+
+  // ingest task, running until the job queue is empty
+  void drain()
+  {
+    std::unique_ptr<WorkerState> state;
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      state = std::move(idle_states_.back());
+      idle_states_.pop_back();
+    }
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (jobs_.empty()) {
+          idle_states_.push_back(std::move(state));
+          --running_tasks_;
+          // notify with the lock held, since the destructor may run as soon as it is released
+          slot_available_.notify_all();
+          return;
+        }
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+      extract(*state, job);
+    }
+  }
+
+public:
+  IngestPipeline(
+    IngestCore & core, std::shared_ptr<IntrospectionMessageDeserializer> deserializer,
+    std::shared_ptr<TaskScheduler> scheduler, size_t workers, size_t capacity = 1024)
+  : core_(core), deserializer_(deserializer), scheduler_(scheduler),
+    workers_(std::max<size_t>(workers, 1)), capacity_(std::max<size_t>(capacity, 1)),
+    slots_(capacity_), completed_(capacity_, false)
+  {
+    for (size_t i = 0; i < workers_; i++) {
+      auto state = std::make_unique<WorkerState>();
+      state->scratch = deserializer_->init_buffer();
+      idle_states_.push_back(std::move(state));
+    }
+  }
+
+  // commits the submitted messages before returning
+  ~IngestPipeline()
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    slot_available_.wait(
+      lock, [this] {
+        return running_tasks_ == 0;
+      });
+    for (auto & state : idle_states_) {
+      deserializer_->fini_buffer(state->scratch);
+    }
+  }
+
+  // disable copy and move, since the tasks reference this
+  IngestPipeline & operator=(IngestPipeline &&) = delete;
+
+  // hand a message to the workers; called by one receiving thread at a time
+  void submit(std::shared_ptr<rclcpp::SerializedMessage> message)
+  {
+    if (core_.shed(message->size())) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    slot_available_.wait(
+      lock, [this] {
+        return submitted_ - committed_ < capacity_;
+      });
+    core_.receive_pipelined(message->size(), slots_[submitted_ % capacity_]);
+    jobs_.push_back({submitted_++, std::move(message)});
+    // start another task while queued jobs outnumber the tasks, up to one task per worker
+    if (running_tasks_ < workers_ && running_tasks_ < jobs_.size()) {
+      ++running_tasks_;
+      scheduler_->submit(TaskPriority::Ingest, [this] {drain();});
+    }
+  }
+
+  // wait until all submitted messages are committed
+  void flush()
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    slot_available_.wait(
+      lock, [this] {
+        return committed_ == submitted_;
+      });
+  }
+
+  size_t workers() const
+  {
+    return workers_;
+  }
+
+  // messages submitted but not committed yet
+  size_t backlog()
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    return submitted_ - committed_;
+  }
+
+  // messages completed by a task before an earlier message, and held back by the reorder stage
+  uint64_t out_of_order() const
+  {
+    return out_of_order_;
+  }
+};
+
+class PlotSubscription
+{
+private:
+  std::shared_ptr<IntrospectionMessageDeserializer> deserializer_;
+  // fast path of the message type, nullptr if messages are received serialized
+  const TypedMessageSupport * typed_support_;
+  // declared before the subscription, which calls into it
+  IngestCore core_;
+  // set if messages are deserialized by several workers
+  std::unique_ptr<IngestPipeline> pipeline_;
+  rclcpp::SubscriptionBase::SharedPtr subscription_;
+  std::optional<QosConfig> qos_config_;
+  // set if the node subscribes in another ROS domain than this process
+  std::optional<size_t> domain_id_;
+
+  // messages reported lost by the middleware
+  std::atomic<uint64_t> lost_messages_{0};
+  // at least this many messages were pending in the middleware at the last take_pending, if it
+  // took a full batch
+  std::atomic<size_t> pending_backlog_{0};
+
+  // priority and ingest load as of the last update of the overload controller, only used by the
+  // GUI thread
+  SeriesPriority priority_ = SeriesPriority::Normal;
+  double ingest_load_ = 0.0;
+
+  // reused by take_pending
+  rclcpp::MessageInfo message_info_;
+
+public:
+  explicit PlotSubscription(
+    std::string topic_name,
+    rclcpp::Node & node,
+    std::shared_ptr<IntrospectionMessageDeserializer> deserializer,
+    const TypedMessageSupport * typed_support = nullptr,
+    rclcpp::CallbackGroup::SharedPtr callback_group = nullptr,
+    const std::optional<QosConfig> & qos_config = std::nullopt,
+    std::optional<size_t> domain_id = std::nullopt,
+    size_t pipeline_workers = 0,
+    std::shared_ptr<TaskScheduler> scheduler = nullptr)
+  : deserializer_(deserializer), typed_support_(typed_support),
+    core_(deserializer, std::make_shared<NodeIngestClock>(
+        node.get_node_clock_interface()->get_clock())),
+    qos_config_(qos_config), domain_id_(domain_id)
+  {
+    if (pipeline_workers > 0) {
+      // typed messages are deserialized by the middleware, on the receiving thread
+      typed_support_ = nullptr;
+      pipeline_ = std::make_unique<IngestPipeline>(
+        core_, deserializer_, scheduler, pipeline_workers);
+    }
+    rclcpp::SubscriptionOptions options;
+    options.callback_group = callback_group;
+    options.event_callbacks.message_lost_callback = [this](rclcpp::QOSMessageLostInfo & info) {
+        lost_messages_ += info.total_count_change;
+      };
+    try {
+      create_subscription(node, topic_name, options);
+    } catch (const rclcpp::UnsupportedEventTypeException &) {
+      // the middleware does not report lost messages, rely on stamp gaps only
+      options.event_callbacks.message_lost_callback = nullptr;
+      create_subscription(node, topic_name, options);
+    }
+  }
+
+  void create_subscription(
+    rclcpp::Node & node, const std::string & topic_name,
+    const rclcpp::SubscriptionOptions & options)
+  {
+    if (typed_support_) {
+      subscription_ = typed_support_->create_subscription(
+        node,
+        topic_name,
+        make_qos(qos_config_),
+        std::bind(&PlotSubscription::receive_message, this, _1),
+        options);
+      return;
+    }
+    subscription_ = rclcpp::create_generic_subscription(
+      node.get_node_topics_interface(),
+      topic_name,
+      deserializer_->message_type(),
+      make_qos(qos_config_),
+      std::bind(&PlotSubscription::receive_callback, this, _1),
+      options
+    );
+  }
+
+  // disable copy and move
+  PlotSubscription & operator=(PlotSubscription && other) = delete;
+
+  // qualified with the domain, if the subscription is in another domain than this process
+  std::string topic_name() const
+  {
+    return qualified_topic_name(domain_id_, subscription_->get_topic_name());
+  }
+
+  std::optional<size_t> domain_id() const
+  {
+    return domain_id_;
+  }
+
+  rclcpp::SubscriptionBase::SharedPtr get_subscription() const
+  {
+    return subscription_;
+  }
+
+  bool is_typed() const
+  {
+    return typed_support_ != nullptr;
+  }
+
+  // number of deserialization workers, 0 if messages are deserialized on the receiving thread
+  size_t pipeline_workers() const
+  {
+    return pipeline_ ? pipeline_->workers() : 0;
+  }
+
+  const std::optional<QosConfig> & qos_config() const
+  {
+    return qos_config_;
+  }
+
+  uint64_t lost_messages() const
+  {
+    return lost_messages_;
+  }
+
+  uint64_t stamp_gaps() const
+  {
+    return core_.stamp_gaps();
+  }
+
+  uint64_t stamp_gap_missing() const
+  {
+    return core_.stamp_gap_missing();
+  }
+
+  /**
+   * Execute the QoS event handlers of the subscription which are ready in the wait set.
+   * Only required if the subscription is not served by an executor, see IngestLoop.
+   */
+  void execute_ready_events(rcl_wait_set_t * wait_set)
+  {
+    for (const auto & [_, handler] : subscription_->get_event_handlers()) {
+      if (handler->is_ready(wait_set)) {
+        auto data = handler->take_data();
+        handler->execute(data);
+      }
+    }
+  }
+
+  std::shared_ptr<PlotDataBuffer> add_source(MessageAccessor accessor)
+  {
+    FieldGetter getter = nullptr;
+    // the typed fast path loads fixed indices only
+    if (typed_support_ && accessor.op != DataSourceOperator::L2Norm && !accessor.key.has_value()) {
+      std::stringstream ss;
+      ss << accessor.member;
+      getter = typed_support_->find_field(ss.str());
+    }
+    return core_.add_source(accessor, getter);
+  }
+
+  // scratch buffers and statistics of this subscription, excluding the plot buffers
+  MemoryUsage memory_usage() const
+  {
+    return core_.memory_usage();
+  }
+
+  // time spent ingesting messages of this subscription since the previous call
+  std::chrono::nanoseconds take_busy_time()
+  {
+    return core_.take_busy_time();
+  }
+
+  // messages received but not ingested yet, as far as they are known
+  size_t backlog()
+  {
+    return (pipeline_ ? pipeline_->backlog() : 0) + pending_backlog_;
+  }
+
+  // thin the topic to one in decimation messages, dropped before deserialization
+  void set_shedding(SeriesPriority priority, double ingest_load, size_t decimation)
+  {
+    priority_ = priority;
+    ingest_load_ = ingest_load;
+    core_.set_decimation(decimation);
+  }
+
+  // highest priority of the series fed by this subscription
+  SeriesPriority priority() const
+  {
+    return priority_;
+  }
+
+  // seconds of ingest work per second
+  double ingest_load() const
+  {
+    return ingest_load_;
+  }
+
+  // received messages per ingested message, 1 if the topic is not thinned
+  size_t decimation() const
+  {
+    return core_.decimation();
+  }
+
+  uint64_t shed_messages() const
+  {
+    return core_.shed_messages();
+  }
+
+  ReceiveStats receive_stats() const
+  {
+    return core_.receive_stats();
+  }
+
+  void receive_callback(std::shared_ptr<rclcpp::SerializedMessage> message)
+  {
+    if (pipeline_) {
+      pipeline_->submit(message);
+      return;
+    }
+    core_.receive_serialized(*message);
+  }
+
+  // receive a message from a typed subscription
+  void receive_message(const void * message)
+  {
+    core_.receive_message(message);
+  }
+
+  /**
+   * Take up to max_messages messages pending in the middleware, and push them to each buffer in
+   * a single batch.
+   * Only valid if the subscription is not served by an executor, see IngestLoop.
+   */
+  size_t take_pending(size_t max_messages)
+  {
+    if (pipeline_) {
+      size_t taken = 0;
+      while (taken < max_messages) {
+        auto message = std::make_shared<rclcpp::SerializedMessage>();
+        if (!subscription_->take_serialized(*message, message_info_)) {
+          break;
+        }
+        pipeline_->submit(message);
+        ++taken;
+      }
+      pending_backlog_ = taken == max_messages ? taken : 0;
+      return taken;
+    }
+    auto taken = core_.receive_batch(
+      [this](rclcpp::SerializedMessage & message) {
+        return subscription_->take_serialized(message, message_info_);
+      }, max_messages);
+    pending_backlog_ = taken == max_messages ? taken : 0;
+    return taken;
+  }
+
+  void clear()
+  {
+    lost_messages_ = 0;
+    core_.clear();
   }
 };
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "implot.h" // NOLINT
+#include <algorithm>
+#include <chrono>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -97,10 +99,10 @@ PlotViewResult BeginPlotView(const char * id, Plot & plot, const PlotViewOptions
   return result;
 }
 
-bool PlotSeriesPopup(const std::string & id)
+bool PlotSeriesPopup(const std::string & label)
 {
   bool removed = false;
-  if (ImPlot::BeginLegendPopup(id.c_str())) {
+  if (ImPlot::BeginLegendPopup(label.c_str())) {
     if (ImGui::Button("remove")) {
       removed = true;
     }
@@ -109,10 +111,71 @@ bool PlotSeriesPopup(const std::string & id)
   return removed;
 }
 
+// transitions of a run-length encoded buffer, followed by the end of the last run
+struct StateTimeline
+{
+  CircularBuffer::const_iterator begin;
+  size_t size;
+  double run_end;
+};
+
+ImPlotPoint state_timeline_get_item(void * data, int idx)
+{
+  auto timeline = static_cast<StateTimeline *>(data);
+  if (static_cast<size_t>(idx) < timeline->size) {
+    return timeline->begin[idx];
+  }
+  return ImPlotPoint(timeline->run_end, timeline->begin[idx - 1].y);
+}
+
+// legend label of a series, marking topics thinned by the overload controller and series which
+// dropped samples arriving too late; aggregates are marked with the strongest thinning of their
+// topics; the item id after ### does not change with the marks
+std::string series_label(const TimeSeries & series)
+{
+  auto active = std::get_if<ActiveDataSource>(&series.source);
+  size_t decimation = 1;
+  size_t late_samples = 0;
+  if (active) {
+    late_samples = active->data->late_samples();
+  }
+  if (active && active->subscription) {
+    decimation = active->subscription->decimation();
+  } else if (active && active->aggregate) {
+    for (const auto & subscription : active->aggregate->member_subscriptions()) {
+      decimation = std::max(decimation, subscription->decimation());
+    }
+    late_samples += active->aggregate->late_samples();
+  }
+  auto label = series.id;
+  if (decimation > 1) {
+    label += " [1 in " + std::to_string(decimation) + "]";
+  }
+  if (late_samples > 0) {
+    label += " [" + std::to_string(late_samples) + " late]";
+  }
+  return label + "###" + series.id;
+}
+
 void PlotSource(const std::string & id, const ActiveDataSource & source)
 {
   auto data = source.data->data();
   auto it = data->begin();
+  auto run_end = data->run_end();
+  if (run_end.has_value()) {
+    // states hold their value until the next transition
+    StateTimeline timeline {
+      .begin = it,
+      .size = data->size(),
+      .run_end = run_end.value(),
+    };
+    ImPlot::PlotStairsG(
+      id.c_str(),
+      &state_timeline_get_item,
+      &timeline,
+      static_cast<int>(data->size() + 1));
+    return;
+  }
   ImPlot::PlotLineG(
     id.c_str(),
     &circular_buffer_get_item,
@@ -184,7 +247,7 @@ void PlotSeriesError(
   // plot empty line to show the item in legend, even though it is not received yet
   // this allows the user to remove the source from the list
   ImPlot::HideNextItem(true, ImGuiCond_Always);
-  ImPlot::PlotLine(series.id.c_str(), static_cast<float *>(nullptr), 0);
+  ImPlot::PlotLine(series_label(series).c_str(), static_cast<float *>(nullptr), 0);
   auto warning_color = ImPlot::GetLastItemColor();
 
   auto start_sec = plot_opts.t_start.seconds();
@@ -202,6 +265,8 @@ void PlotSeriesError(
 std::optional<SeriesPayload> PlotView(Plot & plot, const PlotViewOptions & plot_opts)
 {
   std::optional<SeriesPayload> result;
+  // time of this frame, to measure the latency of newly drawn samples
+  auto frame_time = std::chrono::steady_clock::now().time_since_epoch();
   for (ImPlotYAxis a = 0; a < static_cast<ImPlotYAxis>(plot.axes.size()); a++) {
     for (auto series_it = plot.series.begin(); series_it != plot.series.end(); ) {
       auto axis = series_it->second;
@@ -211,6 +276,7 @@ std::optional<SeriesPayload> PlotView(Plot & plot, const PlotViewOptions & plot_
         continue;
       }
       const auto & series = series_it->first;
+      auto label = series_label(series);
 
       // set axis just before matching source was found, to ensure axis is only displayed
       // if corresponding source exists
@@ -219,15 +285,16 @@ std::optional<SeriesPayload> PlotView(Plot & plot, const PlotViewOptions & plot_
       // display either data or detected errors related to the data
       std::visit(
         overloaded {
-          [series, &plot_opts](const ActiveDataSource & active) {
+          [series, &label, &plot_opts, frame_time](const ActiveDataSource & active) {
             if (active.warning == DataWarning::None) {
               ImPlot::HideNextItem(false, ImGuiCond_Always);
-              PlotSource(series.id, active);
+              PlotSource(label, active);
 
               auto stddev_active = std::get_if<ActiveDataSource>(&series.stddev_source);
               if (stddev_active) {
-                PlotSourceStddev(series.id, active, *stddev_active);
+                PlotSourceStddev(label, active, *stddev_active);
               }
+              active.data->mark_drawn(plot_opts.t_end.seconds(), frame_time);
             } else {
               PlotSeriesError(series, get_warning_message(active.warning), plot_opts);
             }
@@ -237,7 +304,10 @@ std::optional<SeriesPayload> PlotView(Plot & plot, const PlotViewOptions & plot_
           }
         }, series.source);
 
-      if (PlotSeriesPopup(series.id)) {
+      if (PlotSeriesPopup(label)) {
+        if (series.from_pattern) {
+          plot.removed_series.insert(series.id);
+        }
         series_it = plot.series.erase(series_it);
       } else {
         ++series_it;
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "quickplot/sample.hpp"
+
+namespace quickplot
+{
+
+/**
+ * Series fed by the process embedding the quickplot library, instead of a ROS topic.
+ * Any number of threads may push; each thread writes to its own shard, so producers do not
+ * contend on one lock. The Application plotting the series drains the shards once per frame into
+ * the plot buffer.
+ * Samples are only kept while a plot reads the series, and at most capacity samples are kept
+ * between two drains; further samples are counted as dropped.
+ */
+class PushSeries
+{
+private:
+  static constexpr size_t SHARD_COUNT = 16;
+
+  // counters are kept per shard under its lock, so producers do not share a cache line
+  struct alignas(64) Shard
+  {
+    mutable std::mutex mutex;
+    std::vector<Sample> pending;
+    uint64_t pushed = 0;
+    uint64_t dropped = 0;
+  };
+
+  std::string name_;
+  size_t shard_capacity_;
+  Shard shards_[SHARD_COUNT];
+  // plots reading the series; changes rarely, so producers keep reading it from their own cache
+  std::atomic<size_t> readers_{0};
+
+  Shard & shard();
+
+public:
+  PushSeries(std::string name, size_t capacity);
+
+  // disable copy and move, since producers hold handles to this
+  PushSeries & operator=(PushSeries &&) = delete;
+
+  const std::string & name() const
+  {
+    return name_;
+  }
+
+  // t in seconds of the plot clock, i.e. ROS time
+  void push(double t, double value);
+
+  // push count samples, taking one lock
+  void push_batch(const double * t, const double * values, size_t count);
+
+  void push_batch(const Sample * samples, size_t count);
+
+  // samples are kept from the first add_reader until the last remove_reader, which drops the
+  // samples pending at that point
+  void add_reader();
+
+  void remove_reader();
+
+  // append the samples pushed since the last drain to out, sorted by time, and return the
+  // number of appended samples; called by the plotting Application
+  size_t drain(std::vector<Sample> & out);
+
+  uint64_t pushed() const;
+
+  // samples pushed while the buffer between two drains was full
+  uint64_t dropped() const;
+};
+
+// samples kept per series between two drains, if not given at registration
+constexpr size_t DEFAULT_PUSH_CAPACITY = 1 << 22;
+
+/**
+ * Handle to the series of the given name, registered on first use; the plots of this process
+ * show it as a source configured with 'push_series: <name>'.
+ * Registering the same name again returns the same series; the capacity of the first
+ * registration applies.
+ */
+std::shared_ptr<PushSeries> register_push_series(
+  const std::string & name, size_t capacity = DEFAULT_PUSH_CAPACITY);
+
+/**
+ * Handle to the registered series of the given name for a plot draining it. The series keeps
+ * samples while at least one such handle exists.
+ */
+std::shared_ptr<PushSeries> read_push_series(const std::string & name);
+
+// names of all registered series, sorted
+std::vector<std::string> push_series_names();
+
+} // namespace quickplot
@@ -3,6 +3,7 @@
 #include <memory>
 #include <string>
 #include <map>
+#include <tuple>
 #include <utility>
 #include <unordered_map>
 #include "quickplot/introspection.hpp"
@@ -25,9 +26,18 @@ using MessageTypeInfo = std::variant<MessageIntrospectionPtr, MessageTypeError>;
 DataSourceConfig source_to_config(const ActiveDataSource & source)
 {
   DataSourceConfig config;
-  config.topic_name = source.subscription->topic_name();
-  config.member_path = to_descriptor(source.accessor.member);
+  if (!source.channel.empty()) {
+    config.topic_name = source.channel;
+    config.op = DataSourceOperator::Identity;
+    config.kind = source_kind(source);
+    return config;
+  }
+  std::tie(config.domain_id, config.topic_name) = split_qualified_topic_name(source.topic_name());
+  config.member_path = to_descriptor(source.accessor);
   config.op = source.accessor.op;
+  if (source.subscription) {
+    config.qos = source.subscription->qos_config();
+  }
   return config;
 }
 
@@ -38,30 +48,54 @@ TimeSeriesConfig series_to_config(const std::pair<TimeSeries, int> & p)
   auto active = std::get_if<ActiveDataSource>(&series.source);
   if (active) {
     config.source = source_to_config(*active);
+  } else {
+    // keep sources which are not initialized yet
+    config.source = std::get<SourceInfo>(series.source).config;
   }
   auto stddev_active = std::get_if<ActiveDataSource>(&series.stddev_source);
   if (stddev_active) {
     config.stddev_source = source_to_config(*stddev_active);
+  } else {
+    const auto & stddev_config = std::get<SourceInfo>(series.stddev_source).config;
+    if (!stddev_config.topic_name.empty()) {
+      config.stddev_source = stddev_config;
+    }
   }
   config.axis = axis;
+  config.priority = series.priority;
   return config;
 }
 
 PlotConfig plot_to_config(const Plot & plot)
 {
   PlotConfig config;
-  std::transform(
-    plot.series.begin(), plot.series.end(), std::inserter(config.series, config.series.begin()),
-    &series_to_config);
+  for (const auto & item : plot.series) {
+    if (!item.first.from_pattern) {
+      config.series.push_back(series_to_config(item));
+    }
+  }
+  for (const auto & pattern : plot.patterns) {
+    config.patterns.push_back(pattern.config);
+  }
   config.axes = plot.axes;
   return config;
 }
 
+// id of the series of a socket channel or pushed series
+std::string channel_series_id(DataSourceKind kind, const std::string & name)
+{
+  return (kind == DataSourceKind::Push ? "push:" : "socket:") + name;
+}
+
 // construct id of a time series based on an unresolved member path
 std::string series_id(const DataSourceConfig & source_config)
 {
+  if (source_config.kind != DataSourceKind::Topic) {
+    return channel_series_id(source_config.kind, source_config.topic_name);
+  }
   std::stringstream ss;
-  ss << source_config.topic_name << "/" << source_config.member_path;
+  ss << qualified_topic_name(source_config.domain_id, source_config.topic_name) << "/" <<
+    source_config.member_path;
   if (source_config.op == DataSourceOperator::Sqrt) {
     ss << "-sqrt";
   }
@@ -74,13 +108,26 @@ std::string series_id(const DataSourceConfig & source_config)
 std::string series_id(const std::string & topic, const MessageAccessor & accessor)
 {
   std::stringstream ss;
-  ss << topic << "/" << accessor.member;
+  ss << topic << "/" << to_descriptor(accessor);
   if (accessor.op == DataSourceOperator::Sqrt) {
     ss << "-sqrt";
   }
   return ss.str();
 }
 
+// id and name of the series aggregating the topics of a pattern
+std::string aggregate_series_id(const TopicPatternConfig & pattern)
+{
+  std::stringstream ss;
+  ss << aggregate_operator_name(pattern.aggregate->op) << "(" <<
+    qualified_topic_name(pattern.domain_id, pattern.topic_pattern) << "/" << pattern.member_path;
+  if (pattern.op == DataSourceOperator::Sqrt) {
+    ss << "-sqrt";
+  }
+  ss << ", " << pattern.aggregate->bucket << "s)";
+  return ss.str();
+}
+
 const char * get_message_type(const MessageTypeInfo & type_info)
 {
   return std::visit(
@@ -98,6 +145,8 @@ class IntrospectionCache
 {
 private:
   std::unordered_map<std::string, MessageIntrospectionPtr> cache_;
+  // resolved member paths, keyed by message type and member path descriptor
+  std::unordered_map<std::string, std::optional<MemberSequencePath>> member_paths_;
 
 public:
   IntrospectionCache() = default;
@@ -113,6 +162,37 @@ public:
       std::make_shared<MessageIntrospection>(message_type));
     return new_entry->second;
   }
+
+  /**
+   * Resolve the member path in the message type, once per type and path, so sources of many
+   * topics with the same type share the result of the introspection walk.
+   * nullopt if the type has no such member.
+   */
+  std::optional<MemberSequencePath> member_path(
+    const MessageIntrospectionPtr & introspection,
+    const MemberSequencePathDescriptor & descriptor)
+  {
+    std::stringstream key;
+    key << introspection->message_type() << ":" << descriptor;
+    auto it = member_paths_.find(key.str());
+    if (it != member_paths_.end()) {
+      return it->second;
+    }
+    std::optional<MemberSequencePath> path;
+    try {
+      path = introspection->get_member_sequence_path(descriptor);
+    } catch (const introspection_error &) {
+      path = std::nullopt;
+    }
+    member_paths_.emplace(key.str(), path);
+    return path;
+  }
+
+  // introspection libraries loaded so far, keyed by message type
+  const std::unordered_map<std::string, MessageIntrospectionPtr> & loaded() const
+  {
+    return cache_;
+  }
 };
 
 using TopicTypeMap = std::map<std::string, MessageTypeInfo>;
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace quickplot
+{
+
+/**
+ * Single (t, value) sample of pushed, imported, snapshot and socket series.
+ * Layout-compatible with ImPlotPoint, so samples are copied into plot buffers without conversion;
+ * plot_subscription.hpp asserts this.
+ */
+struct Sample
+{
+  double x;
+  double y;
+};
+
+} // namespace quickplot
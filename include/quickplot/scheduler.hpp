@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace quickplot
+{
+
+// priorities of background tasks, from most to least urgent
+enum class TaskPriority
+{
+  // deserialization and commit of received messages
+  Ingest,
+  // preparation of data for the next frame
+  RenderPrep,
+  // computations on received series, e.g. statistics or spectra
+  Analysis,
+  // writes to disk, e.g. history snapshots
+  Export,
+};
+
+constexpr size_t TASK_PRIORITY_COUNT = 4;
+
+struct SchedulerStats
+{
+  size_t workers;
+  // tasks waiting in the queues, per priority
+  std::array<size_t, TASK_PRIORITY_COUNT> queued;
+  // tasks run since start, per priority
+  std::array<uint64_t, TASK_PRIORITY_COUNT> executed;
+  // tasks taken from the queue of another worker
+  uint64_t steals;
+};
+
+/**
+ * Pool of worker threads running the background tasks of the application, instead of a thread
+ * per component.
+ * Each worker has a queue per priority. Workers run the most urgent task they find, first in
+ * their own queue and then by stealing from the other workers, so queued ingest tasks are always
+ * run before tasks of lower priority.
+ * Tasks below Ingest priority never occupy all workers, so a long export or analysis task does
+ * not delay ingestion.
+ */
+class TaskScheduler
+{
+private:
+  struct alignas(64) Worker
+  {
+    std::mutex mutex;
+    std::array<std::deque<std::function<void()>>, TASK_PRIORITY_COUNT> queues;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // protects sleeping on work_available_ and running_
+  std::mutex idle_mutex_;
+  std::condition_variable work_available_;
+  bool running_ = true;
+  // tasks in any queue
+  std::atomic<size_t> pending_{0};
+  // tasks below Ingest priority which are currently running
+  std::atomic<size_t> background_running_{0};
+  std::atomic<size_t> next_worker_{0};
+
+  std::array<std::atomic<size_t>, TASK_PRIORITY_COUNT> queued_ {};
+  std::array<std::atomic<uint64_t>, TASK_PRIORITY_COUNT> executed_ {};
+  std::atomic<uint64_t> steals_{0};
+
+  // count a running task below Ingest priority, if a worker is left for ingest tasks
+  bool reserve_background();
+
+  // take the most urgent task, from the queues of worker index first
+  bool take(size_t index, std::function<void()> & task, size_t & priority);
+
+  void run(size_t index);
+
+public:
+  // threads is the number of workers, 0 for one per core
+  explicit TaskScheduler(size_t threads = 0);
+
+  // runs the queued tasks before returning
+  ~TaskScheduler();
+
+  // disable copy and move, since the workers reference this
+  TaskScheduler & operator=(TaskScheduler &&) = delete;
+
+  // queue a task; tasks submitted by a worker are queued on that worker
+  void submit(TaskPriority priority, std::function<void()> task);
+
+  size_t workers() const
+  {
+    return workers_.size();
+  }
+
+  SchedulerStats stats() const;
+};
+
+} // namespace quickplot
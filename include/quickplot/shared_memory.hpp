@@ -0,0 +1,171 @@
+#pragma once
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "quickplot/sample.hpp"
+
+namespace quickplot
+{
+
+struct shared_memory_error : public std::exception
+{
+  std::string message_;
+
+  explicit shared_memory_error(std::string message)
+  : message_(message)
+  {
+
+  }
+
+  const char * what() const throw ()
+  {
+    return message_.c_str();
+  }
+};
+
+// how a quickplot process takes part in sharing series data with other quickplot processes
+enum class SharedMemoryMode
+{
+  // series are only stored in the buffers of this process
+  Off,
+  // received series are additionally written to shared memory segments
+  Export,
+  // series are read from segments exported by another process instead of subscribing
+  Import,
+};
+
+SharedMemoryMode parse_shared_memory_mode(const std::string & mode);
+
+// header at the start of every shared series segment, followed by the sample ring
+struct SharedSeriesHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+  // incremented when the exporting process clears the series, readers drop their copy
+  std::atomic<uint64_t> generation;
+  // value of written when the series was last cleared
+  std::atomic<uint64_t> cleared_at;
+  // number of samples ever written; acts as sequence counter for readers, since slot i % capacity
+  // holds sample i until sample i + capacity is being written
+  std::atomic<uint64_t> written;
+  // set by the writer before it unlinks the segment
+  std::atomic<bool> closed;
+  // process of the writer, so a segment is only replaced if its writer is gone
+  int64_t owner_pid;
+  char topic_name[256];
+};
+
+// name of the POSIX shared memory object holding a series; series ids contain slashes, so the
+// id is escaped and suffixed with a stable hash to avoid collisions after escaping
+std::string shared_segment_name(const std::string & series_id);
+
+// Single producer of a shared series segment.
+// The segment is created on construction and unlinked on destruction. A segment left behind by a
+// writer which did not shut down cleanly is replaced; if the writer of the segment is still
+// running, construction fails.
+class SharedSeriesWriter
+{
+private:
+  std::string name_;
+  SharedSeriesHeader * header_;
+  Sample * samples_;
+  size_t mapped_size_;
+
+public:
+  SharedSeriesWriter(
+    const std::string & series_id, const std::string & topic_name,
+    size_t capacity);
+
+  ~SharedSeriesWriter();
+
+  // disable copy and move
+  SharedSeriesWriter & operator=(SharedSeriesWriter &&) = delete;
+
+  const std::string & name() const;
+
+  size_t capacity() const;
+
+  void push(double x, double y);
+
+  void clear();
+};
+
+// Consumer of a shared series segment, any number of readers may attach to one segment.
+class SharedSeriesReader
+{
+private:
+  std::string name_;
+  const SharedSeriesHeader * header_;
+  const Sample * samples_;
+  size_t mapped_size_;
+  // identity of the mapped segment, to detect that a restarted writer replaced it
+  dev_t device_;
+  ino_t inode_;
+  // reads since the writer process was last checked to be alive
+  uint64_t reads_since_check_;
+
+  // sequence number of the next sample to read
+  uint64_t next_;
+  uint64_t generation_;
+
+  // number of samples which were overwritten before this reader could copy them
+  uint64_t overrun_;
+
+  bool map(const std::string & name);
+
+  void unmap();
+
+  // true if the writer closed the segment or, checked every few reads, its process is gone
+  bool writer_exited();
+
+  // true if the segment name refers to another segment than the mapped one
+  bool replaced() const;
+
+public:
+  // returns nullptr if no process exports the series
+  static std::shared_ptr<SharedSeriesReader> open(const std::string & series_id);
+
+  SharedSeriesReader();
+
+  ~SharedSeriesReader();
+
+  // disable copy and move
+  SharedSeriesReader & operator=(SharedSeriesReader &&) = delete;
+
+  std::string topic_name() const;
+
+  uint64_t overrun() const;
+
+  // true if the series was cleared by the writer since the last read
+  bool cleared();
+
+  // append all samples written since the last read to out, and return the number of appended
+  // samples; reattaches if the exporting process restarted in the meantime, also if it was killed
+  // before it could close the segment
+  size_t read(std::vector<Sample> & out);
+};
+
+// Keeps track of the series this process exports, to ensure there is a single writer per segment.
+class SharedSeriesStore
+{
+private:
+  std::mutex mutex_;
+  size_t capacity_;
+  std::unordered_map<std::string, std::weak_ptr<SharedSeriesWriter>> writers_;
+
+public:
+  explicit SharedSeriesStore(size_t capacity);
+
+  // returns nullptr if the series is already exported by another buffer of this process
+  std::shared_ptr<SharedSeriesWriter> export_series(
+    const std::string & series_id,
+    const std::string & topic_name);
+};
+
+} // namespace quickplot
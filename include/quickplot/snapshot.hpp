@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "quickplot/sample.hpp"
+
+namespace fs = std::filesystem;
+
+namespace quickplot
+{
+
+struct snapshot_error : public std::exception
+{
+  std::string message_;
+
+  explicit snapshot_error(std::string message)
+  : message_(message)
+  {
+
+  }
+
+  const char * what() const throw ()
+  {
+    return message_.c_str();
+  }
+};
+
+struct SnapshotSeries
+{
+  std::string id;
+  std::vector<Sample> samples;
+};
+
+// snapshot file next to the default config
+fs::path get_default_snapshot_path();
+
+/**
+ * Write the series to a snapshot file, replacing it atomically by renaming a temporary file which
+ * is synced to disk first, so a crash or power loss while writing leaves the previous snapshot
+ * intact.
+ * Throws snapshot_error if the file cannot be written.
+ */
+void write_snapshot(const fs::path & path, const std::vector<SnapshotSeries> & series);
+
+/**
+ * Read-only mapping of a snapshot file.
+ * Samples are stored in the layout of the plot buffers, so restoring a series is a copy of the
+ * mapped memory, without parsing.
+ */
+class Snapshot
+{
+private:
+  void * data_;
+  size_t size_;
+  std::unordered_map<std::string, std::pair<const Sample *, size_t>> index_;
+
+  Snapshot(void * data, size_t size);
+
+public:
+  // nullptr if the file does not exist, or is not a valid snapshot of this version
+  static std::unique_ptr<Snapshot> open(const fs::path & path);
+
+  ~Snapshot();
+
+  // disable copy and move
+  Snapshot & operator=(Snapshot &&) = delete;
+
+  // samples of the series in time order, {nullptr, 0} if the series is not in the snapshot
+  std::pair<const Sample *, size_t> find(const std::string & id) const;
+
+  size_t series_count() const;
+};
+
+} // namespace quickplot
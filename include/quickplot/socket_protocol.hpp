@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "quickplot/sample.hpp"
+
+namespace quickplot
+{
+
+struct socket_error : public std::exception
+{
+  std::string message_;
+
+  explicit socket_error(std::string message)
+  : message_(message)
+  {
+
+  }
+
+  const char * what() const throw ()
+  {
+    return message_.c_str();
+  }
+};
+
+enum class SocketType
+{
+  Udp,
+  Unix,
+};
+
+// address the socket source listens on, parsed from 'udp:<port>' or 'unix:<path>'
+struct SocketEndpoint
+{
+  SocketType type;
+  // UDP sockets are bound to the loopback interface
+  uint16_t port;
+  std::string path;
+};
+
+// throws socket_error if the endpoint is malformed
+SocketEndpoint parse_socket_endpoint(const std::string & endpoint);
+
+/**
+ * Binary datagram, in host byte order since both ends run on the same machine:
+ *
+ *   uint32 magic "qpsk", uint16 channel name length, uint16 sample count,
+ *   channel name (not terminated), count x (float64 t, float64 value)
+ *
+ * t is in seconds on the clock of the plotting node, NaN to use the receive time on that clock.
+ */
+constexpr uint32_t SOCKET_DATAGRAM_MAGIC = 0x6b737071; // "qpsk"
+constexpr size_t SOCKET_DATAGRAM_HEADER_SIZE = 8;
+// datagrams are received into buffers of this size; larger datagrams are dropped
+constexpr size_t SOCKET_DATAGRAM_MAX_SIZE = 8192;
+
+struct SocketDatagram
+{
+  std::string channel;
+  std::vector<Sample> samples;
+};
+
+/**
+ * Decode a binary or JSON datagram into out, reusing its storage.
+ * JSON datagrams are objects with a channel and either a value and optional t, or samples as
+ * [[t, value], ...]: {"channel": "motor/current", "t": 1700000000.25, "value": 0.5}
+ * Samples without time get receive_time. Returns false if the datagram is malformed.
+ */
+bool decode_socket_datagram(
+  const char * data, size_t size, double receive_time, SocketDatagram & out);
+
+// encode a binary datagram, for senders written in C++ and tests
+std::string encode_socket_datagram(
+  const std::string & channel, const std::vector<Sample> & samples);
+
+} // namespace quickplot
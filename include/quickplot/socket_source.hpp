@@ -0,0 +1,339 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "quickplot/plot_subscription.hpp"
+#include "quickplot/socket_protocol.hpp"
+
+namespace quickplot
+{
+
+// number of channels a socket source keeps track of, so senders cannot grow it without bound
+constexpr size_t SOCKET_MAX_CHANNELS = 1024;
+// unplotted channels not received for this long are forgotten when the channels are full
+constexpr std::chrono::seconds SOCKET_CHANNEL_EXPIRY{60};
+// the receive thread wakes up at least this often to notice stop, and waits this long after a
+// failed receive before retrying
+constexpr std::chrono::milliseconds SOCKET_POLL_TIMEOUT{100};
+
+/**
+ * Receives samples of processes which are not ROS nodes on a loopback UDP port or Unix datagram
+ * socket.
+ * A receive thread takes up to batch_size datagrams per recvmmsg call and pushes the samples of
+ * each datagram into the buffer of its channel in one batch, so senders batching samples per
+ * datagram reach high sample rates on a single core.
+ */
+class SocketSource
+{
+private:
+  SocketEndpoint endpoint_;
+  int fd_;
+  size_t batch_size_;
+  // clock of the plotting node, which stamps samples without time
+  std::shared_ptr<IngestClock> clock_;
+  std::atomic<bool> running_;
+  std::thread thread_;
+
+  struct Channel
+  {
+    // expires when no series plots the channel anymore
+    std::weak_ptr<PlotDataBuffer> buffer;
+    std::chrono::steady_clock::time_point received;
+  };
+
+  // channels seen so far, at most SOCKET_MAX_CHANNELS of them unless they are plotted
+  mutable std::mutex channels_mutex_;
+  std::unordered_map<std::string, Channel> channels_;
+
+  std::atomic<uint64_t> datagrams_{0};
+  std::atomic<uint64_t> samples_{0};
+  std::atomic<uint64_t> malformed_{0};
+  std::atomic<uint64_t> untracked_{0};
+
+  // socket file this instance bound, so only that file is removed again
+  bool bound_file_ = false;
+  dev_t bound_device_ = 0;
+  ino_t bound_inode_ = 0;
+
+  // whether path is a socket file; its dev and inode are returned in status
+  static bool is_socket_file(const std::string & path, struct stat & status)
+  {
+    return lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode);
+  }
+
+  void open()
+  {
+    if (endpoint_.type == SocketType::Udp) {
+      fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    } else {
+      fd_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    }
+    if (fd_ < 0) {
+      throw socket_error(std::string("socket failed: ") + std::strerror(errno));
+    }
+    // absorb bursts while the receive thread is descheduled
+    int receive_buffer = 8 << 20;
+    setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+
+    int result;
+    if (endpoint_.type == SocketType::Udp) {
+      sockaddr_in address {};
+      address.sin_family = AF_INET;
+      address.sin_port = htons(endpoint_.port);
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      result = bind(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    } else {
+      sockaddr_un address {};
+      address.sun_family = AF_UNIX;
+      if (endpoint_.path.size() >= sizeof(address.sun_path)) {
+        ::close(fd_);
+        throw socket_error("socket path '" + endpoint_.path + "' is too long");
+      }
+      std::strncpy(address.sun_path, endpoint_.path.c_str(), sizeof(address.sun_path) - 1);
+      // remove the socket file left by a previous run, but never other files at the path
+      struct stat status;
+      if (lstat(endpoint_.path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+          ::close(fd_);
+          throw socket_error("'" + endpoint_.path + "' exists and is not a socket");
+        }
+        unlink(endpoint_.path.c_str());
+      }
+      result = bind(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+      if (result == 0 && is_socket_file(endpoint_.path, status)) {
+        bound_file_ = true;
+        bound_device_ = status.st_dev;
+        bound_inode_ = status.st_ino;
+      }
+    }
+    if (result != 0) {
+      auto error = std::string("bind failed: ") + std::strerror(errno);
+      ::close(fd_);
+      throw socket_error(error);
+    }
+  }
+
+  // channels_mutex_ must be held; forget unplotted channels which were not received recently
+  void expire_channels(std::chrono::steady_clock::time_point now)
+  {
+    for (auto it = channels_.begin(); it != channels_.end(); ) {
+      if (it->second.buffer.expired() && now - it->second.received > SOCKET_CHANNEL_EXPIRY) {
+        it = channels_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // buffers of the channels of a batch, locking the channel map once per batch
+  void lookup(
+    const std::vector<SocketDatagram> & datagrams, size_t count,
+    std::vector<std::shared_ptr<PlotDataBuffer>> & buffers)
+  {
+    auto now = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(channels_mutex_);
+    for (size_t i = 0; i < count; i++) {
+      const auto & name = datagrams[i].channel;
+      auto it = channels_.find(name);
+      if (it == channels_.end()) {
+        if (channels_.size() >= SOCKET_MAX_CHANNELS) {
+          expire_channels(now);
+        }
+        if (channels_.size() >= SOCKET_MAX_CHANNELS) {
+          // nothing plots an unknown channel, so only its name is lost
+          ++untracked_;
+          continue;
+        }
+        it = channels_.emplace(name, Channel {}).first;
+      }
+      it->second.received = now;
+      buffers[i] = it->second.buffer.lock();
+    }
+  }
+
+  void run()
+  {
+    std::vector<char> storage(batch_size_ * SOCKET_DATAGRAM_MAX_SIZE);
+    std::vector<iovec> iovecs(batch_size_);
+    std::vector<mmsghdr> messages(batch_size_);
+    for (size_t i = 0; i < batch_size_; i++) {
+      iovecs[i].iov_base = &storage[i * SOCKET_DATAGRAM_MAX_SIZE];
+      iovecs[i].iov_len = SOCKET_DATAGRAM_MAX_SIZE;
+    }
+    std::vector<SocketDatagram> datagrams(batch_size_);
+    std::vector<std::shared_ptr<PlotDataBuffer>> buffers(batch_size_);
+    std::vector<ImPlotPoint> points;
+
+    pollfd poll_fd {
+      .fd = fd_,
+      .events = POLLIN,
+      .revents = 0,
+    };
+    // a failure is only reported once until a receive succeeds again
+    bool failing = false;
+    while (running_) {
+      int ready = poll(&poll_fd, 1, static_cast<int>(SOCKET_POLL_TIMEOUT.count()));
+      if (ready < 0 && errno != EINTR) {
+        std::string error = std::strerror(errno);
+        std::cerr << "socket source stopped: " << error << std::endl;
+        return;
+      }
+      if (ready <= 0) {
+        continue;
+      }
+      if (poll_fd.revents & POLLNVAL) {
+        std::cerr << "socket source stopped: socket is not open" << std::endl;
+        return;
+      }
+      for (size_t i = 0; i < batch_size_; i++) {
+        messages[i] = {};
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+      }
+      int received = recvmmsg(
+        fd_, messages.data(), static_cast<unsigned int>(batch_size_), MSG_DONTWAIT, nullptr);
+      int error = received < 0 ? errno : 0;
+      if (error == EINTR) {
+        continue;
+      }
+      // an error which receiving does not clear would wake up poll immediately again
+      bool would_block = error == EAGAIN || error == EWOULDBLOCK;
+      if (received < 0 && (!would_block || (poll_fd.revents & POLLERR))) {
+        if (!failing) {
+          std::cerr << "socket source failed to receive: " <<
+            (would_block ? "socket error" : std::strerror(error)) << std::endl;
+          failing = true;
+        }
+        std::this_thread::sleep_for(SOCKET_POLL_TIMEOUT);
+        continue;
+      }
+      if (received <= 0) {
+        continue;
+      }
+      failing = false;
+      auto receive_time = clock_->now().seconds();
+      size_t decoded = 0;
+      for (int i = 0; i < received; i++) {
+        const auto & header = messages[i].msg_hdr;
+        if ((header.msg_flags & MSG_TRUNC) ||
+          !decode_socket_datagram(
+            static_cast<const char *>(header.msg_iov->iov_base), messages[i].msg_len,
+            receive_time, datagrams[decoded]))
+        {
+          ++malformed_;
+          continue;
+        }
+        decoded++;
+      }
+      datagrams_ += static_cast<uint64_t>(received);
+      lookup(datagrams, decoded, buffers);
+      for (size_t i = 0; i < decoded; i++) {
+        const auto & samples = datagrams[i].samples;
+        samples_ += samples.size();
+        if (!buffers[i]) {
+          continue;
+        }
+        const auto * begin = reinterpret_cast<const ImPlotPoint *>(samples.data());
+        points.assign(begin, begin + samples.size());
+        buffers[i]->push_batch(points);
+        buffers[i].reset();
+      }
+    }
+  }
+
+public:
+  // throws socket_error if the socket cannot be bound
+  SocketSource(
+    const std::string & endpoint, size_t batch_size, std::shared_ptr<IngestClock> clock)
+  : endpoint_(parse_socket_endpoint(endpoint)), fd_(-1),
+    batch_size_(std::max<size_t>(batch_size, 1)), clock_(clock), running_(true)
+  {
+    open();
+    thread_ = std::thread(&SocketSource::run, this);
+  }
+
+  ~SocketSource()
+  {
+    running_ = false;
+    thread_.join();
+    ::close(fd_);
+    // another process may have replaced the socket file in the meantime
+    struct stat status;
+    if (bound_file_ && is_socket_file(endpoint_.path, status) &&
+      status.st_dev == bound_device_ && status.st_ino == bound_inode_)
+    {
+      unlink(endpoint_.path.c_str());
+    }
+  }
+
+  // disable copy and move, since the receive thread references this
+  SocketSource & operator=(SocketSource &&) = delete;
+
+  // buffer receiving the samples of a channel, created if no series plots the channel yet
+  std::shared_ptr<PlotDataBuffer> channel(const std::string & name)
+  {
+    std::unique_lock<std::mutex> lock(channels_mutex_);
+    auto & channel = channels_[name];
+    auto buffer = channel.buffer.lock();
+    if (!buffer) {
+      buffer = std::make_shared<PlotDataBuffer>(1);
+      channel.buffer = buffer;
+    }
+    return buffer;
+  }
+
+  // names of all channels received so far, sorted
+  std::vector<std::string> channel_names() const
+  {
+    std::unique_lock<std::mutex> lock(channels_mutex_);
+    std::vector<std::string> names;
+    names.reserve(channels_.size());
+    for (const auto & [name, _] : channels_) {
+      names.push_back(name);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+  }
+
+  uint64_t datagrams() const
+  {
+    return datagrams_;
+  }
+
+  uint64_t samples() const
+  {
+    return samples_;
+  }
+
+  // datagrams which were truncated or could not be decoded
+  uint64_t malformed() const
+  {
+    return malformed_;
+  }
+
+  // datagrams of new channels which were not tracked, because SOCKET_MAX_CHANNELS were tracked
+  uint64_t untracked() const
+  {
+    return untracked_;
+  }
+};
+
+} // namespace quickplot
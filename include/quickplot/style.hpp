@@ -0,0 +1,12 @@
+#pragma once
+
+#include "implot.h" // NOLINT
+
+namespace quickplot
+{
+
+// color of warnings, eye-dropped from Rviz display warnings
+// TODO(ZeilingerM) single hardcoded color does not work well with theme changes
+inline const ImVec4 WARNING_COLOR = static_cast<ImVec4>(ImColor::HSV(0.1083f, 0.968f, 0.867f));
+
+} // namespace quickplot
@@ -1,13 +1,17 @@
 #pragma once
 
 #include <set>
+#include <functional>
 #include <utility>
 #include <memory>
 #include <vector>
 #include <string>
+#include <sstream>
 #include <rcpputils/asserts.hpp>
+#include "quickplot/overload.hpp"
 #include "quickplot/resources.hpp"
 #include "quickplot/plot_subscription.hpp"
+#include "quickplot/style.hpp"
 
 namespace quickplot
 {
@@ -25,9 +29,6 @@ bool TopicEntryError(const std::string & topic, const MessageTypeError & error)
   ImGui::PushStyleColor(ImGuiCol_Text, ImGui::GetStyle().Colors[ImGuiCol_TextDisabled]);
   if (ImGui::TreeNodeEx(topic.c_str(), ImGuiTreeNodeFlags_Leaf)) {
     ImGui::PopStyleColor();
-    // color was eye-dropped from Rviz display warnings
-    // TODO(ZeilingerM) single hardcoded color does not work well with theme changes
-    static ImVec4 WARNING_COLOR = static_cast<ImVec4>(ImColor::HSV(0.1083f, 0.968f, 0.867f));
     ImGui::PushStyleColor(ImGuiCol_Text, WARNING_COLOR);
     ImGui::TextWrapped("message type '%s' is not available:", error.message_type.c_str());
     ImGui::TextWrapped("%s", error.error_message.c_str());
@@ -104,6 +105,88 @@ RenderResultWithPayload TopicEntry(const std::string & topic, const MessageTypeI
     }, type_info);
 }
 
+// rate, bandwidth and percentiles of the receive statistics window
+void ReceiveStatsText(const ReceiveStats & stats)
+{
+  if (stats.period.count == 0) {
+    return;
+  }
+  if (stats.message_size.count > 0) {
+    ImGui::Text("%.1f hz, %.1f kB/s", stats.period.rate(), stats.message_size.sum_rate() / 1e3);
+  } else {
+    ImGui::Text("%.1f hz", stats.period.rate());
+  }
+  ImGui::TextDisabled("p50 / p99 / max");
+  ImGui::Text(
+    "period  %.2f / %.2f / %.2f ms", stats.period.p50 * 1e-6, stats.period.p99 * 1e-6,
+    stats.period.max * 1e-6);
+  if (stats.latency.count > 0) {
+    ImGui::Text(
+      "latency %.2f / %.2f / %.2f ms", stats.latency.p50 * 1e-6, stats.latency.p99 * 1e-6,
+      stats.latency.max * 1e-6);
+  }
+  if (stats.message_size.count > 0) {
+    ImGui::Text(
+      "size    %lu / %lu / %lu B", stats.message_size.p50, stats.message_size.p99,
+      stats.message_size.max);
+  }
+}
+
+void write_receive_stats(std::ostream & os, const std::string & topic, const ReceiveStats & stats)
+{
+  os << topic << ":\n";
+  os << "  period_ns: " << stats.period << "\n";
+  os << "  latency_ns: " << stats.latency << "\n";
+  os << "  message_size_bytes: " << stats.message_size << "\n";
+}
+
+// QoS of the subscription, and messages lost on the way to it
+void ReceiveCounters(const PlotSubscription & subscription)
+{
+  const auto & qos = subscription.qos_config();
+  if (qos.has_value()) {
+    auto reliability = qos->reliability == QosReliability::Reliable ? "reliable" : "best effort";
+    if (qos->history == QosHistory::KeepAll) {
+      ImGui::Text("%s, keep all", reliability);
+    } else {
+      ImGui::Text("%s, keep last %lu", reliability, qos->depth);
+    }
+  }
+  if (subscription.pipeline_workers() > 0) {
+    ImGui::Text("%lu deserialization workers", subscription.pipeline_workers());
+  }
+  ImGui::Text(
+    "ingest %.1f%% of a core, %s priority", 100.0 * subscription.ingest_load(),
+    series_priority_name(subscription.priority()));
+  if (subscription.decimation() > 1) {
+    ImGui::PushStyleColor(ImGuiCol_Text, WARNING_COLOR);
+    ImGui::Text(
+      "thinned to 1 in %lu messages, %lu shed", subscription.decimation(),
+      subscription.shed_messages());
+    ImGui::PopStyleColor();
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip(
+        "ingestion is over budget, so messages of this topic are dropped before\n"
+        "deserialization; raise the priority of its series to keep them");
+    }
+  }
+  auto lost = subscription.lost_messages();
+  auto gaps = subscription.stamp_gaps();
+  if (lost == 0 && gaps == 0) {
+    return;
+  }
+  ImGui::PushStyleColor(ImGuiCol_Text, WARNING_COLOR);
+  ImGui::Text("%lu lost", lost);
+  ImGui::SameLine();
+  ImGui::Text("%lu stamp gaps (~%lu missing)", gaps, subscription.stamp_gap_missing());
+  ImGui::PopStyleColor();
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip(
+      "lost: reported by the middleware\n"
+      "stamp gaps: header stamp steps much larger than the usual period");
+  }
+}
+
 void EndTopicEntry()
 {
   ImGui::TreePop();
@@ -112,47 +195,65 @@ void EndTopicEntry()
 ClickPayload TopicList(
   const TopicTypeMap & topics_to_types,
   std::vector<Plot> & plots,
-  std::shared_ptr<QuickPlotNode> node)
+  const std::function<bool(const std::string &)> & is_subscribed_to)
 {
   ClickPayload payload;
 
   ImGuiWindowFlags list_window_flags = ImGuiWindowFlags_None;
   if (ImGui::Begin(TOPIC_LIST_WINDOW_ID, nullptr, list_window_flags)) {
     // accumulate and sort subscriptions of active plots
+    // a topic may have several subscriptions with different QoS
     auto cmp_topic_names =
       [](std::shared_ptr<PlotSubscription> s1, std::shared_ptr<PlotSubscription> s2) {
-        return s1->topic_name() < s2->topic_name();
+        auto t1 = s1->topic_name();
+        auto t2 = s2->topic_name();
+        return t1 < t2 || (t1 == t2 && s1 < s2);
       };
     std::set<std::shared_ptr<PlotSubscription>, decltype(cmp_topic_names)> active_topics(
       cmp_topic_names);
     for (auto & plot : plots) {
       for (auto & [series, _] : plot.series) {
         auto active = std::get_if<ActiveDataSource>(&series.source);
-        if (active) {
+        // sources imported from shared memory have no subscription to show stats for
+        if (active && active->subscription) {
           active_topics.insert(active->subscription);
         }
+        // aggregates subscribe to all topics matching their pattern
+        if (active && active->aggregate) {
+          for (const auto & subscription : active->aggregate->member_subscriptions()) {
+            active_topics.insert(subscription);
+          }
+        }
       }
     }
 
     // display list of subscribed topics and their receive stats
     if (!active_topics.empty()) {
       if (ImGui::CollapsingHeader("active topics", ImGuiTreeNodeFlags_DefaultOpen)) {
+        if (ImGui::SmallButton("copy stats")) {
+          std::stringstream ss;
+          for (const auto & subscription : active_topics) {
+            write_receive_stats(ss, subscription->topic_name(), subscription->receive_stats());
+          }
+          ImGui::SetClipboardText(ss.str().c_str());
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip("copy receive statistics of the active topics as YAML");
+        }
         for (const auto & subscription : active_topics) {
           auto type_it = topics_to_types.find(subscription->topic_name());
           rcpputils::assert_true(
             type_it != topics_to_types.end(),
             "topics can only become active when their type is known");
+          ImGui::PushID(subscription.get());
           const auto & [render_result, _] = TopicEntry(
             subscription->topic_name(), type_it->second);
           if (render_result) {
-            auto stats = subscription->receive_period_stats();
-            if (stats.standard_deviation < (stats.average / 10.0) && stats.average < 1.0 &&
-              stats.average > 0.001)
-            {
-              ImGui::Text("%.1f hz", 1.0 / stats.average);
-            }
+            ReceiveStatsText(subscription->receive_stats());
+            ReceiveCounters(*subscription);
             EndTopicEntry();
           }
+          ImGui::PopID();
         }
       }
     }
@@ -174,7 +275,7 @@ ClickPayload TopicList(
       auto it = topics_to_types.begin();
       for (; it != topics_to_types.end(); ++it) {
         const auto & [topic, type] = *it;
-        if (node->is_subscribed_to(topic)) {
+        if (is_subscribed_to(topic)) {
           // skip subscribed topics, those are already listed in the 'active topics' section
           continue;
         }
@@ -205,4 +306,40 @@ ClickPayload TopicList(
   return payload;
 }
 
+// ingest load against the budget, appended to the topic list window while topics are thinned
+void OverloadStatus(const OverloadController & controller)
+{
+  if (!controller.shedding()) {
+    return;
+  }
+  if (ImGui::Begin(TOPIC_LIST_WINDOW_ID)) {
+    ImGui::PushStyleColor(ImGuiCol_Text, WARNING_COLOR);
+    ImGui::TextWrapped(
+      "ingest load %.2f of %.2f cores, thinning topics of low priority series to 1 in %lu and of "
+      "normal priority series to 1 in %lu messages", controller.load(), controller.budget(),
+      controller.decimation(SeriesPriority::Low), controller.decimation(SeriesPriority::Normal));
+    ImGui::PopStyleColor();
+  }
+  ImGui::End();
+}
+
+// list socket channels or pushed series, appended to the topic list window; returns the clicked
+// channel
+std::optional<std::string> ChannelList(
+  const char * header, const std::vector<std::string> & channels)
+{
+  std::optional<std::string> clicked;
+  if (ImGui::Begin(TOPIC_LIST_WINDOW_ID)) {
+    if (ImGui::CollapsingHeader(header, ImGuiTreeNodeFlags_DefaultOpen)) {
+      for (const auto & channel : channels) {
+        if (ImGui::Selectable(channel.c_str())) {
+          clicked = channel;
+        }
+      }
+    }
+  }
+  ImGui::End();
+  return clicked;
+}
+
 } // namespace quickplot
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <rclcpp/rclcpp.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace quickplot
+{
+
+// load of a numeric field from a message of a type known at compile time
+using FieldGetter = double (*)(const void * message);
+
+// receives a pointer to the message, in the memory layout described by its introspection
+// typesupport
+using TypedMessageCallback = std::function<void (const void *)>;
+
+using TypedSubscriptionFactory = std::function<rclcpp::SubscriptionBase::SharedPtr(
+      rclcpp::Node &, const std::string &, const rclcpp::QoS &, TypedMessageCallback,
+      const rclcpp::SubscriptionOptions &)>;
+
+/**
+ * Fast path for a well-known message type.
+ * Typed subscriptions receive messages without a serialized intermediate (and via intra-process
+ * communication if enabled on the node), and registered fields are read by direct member loads
+ * instead of walking the introspection member path.
+ */
+struct TypedMessageSupport
+{
+  TypedSubscriptionFactory create_subscription;
+
+  // getters keyed by member path, as written by operator<< of MemberSequencePath
+  std::unordered_map<std::string, FieldGetter> fields;
+
+  FieldGetter find_field(const std::string & member_path) const
+  {
+    auto it = fields.find(member_path);
+    if (it == fields.end()) {
+      return nullptr;
+    }
+    return it->second;
+  }
+};
+
+template<typename MessageT>
+rclcpp::SubscriptionBase::SharedPtr create_typed_subscription(
+  rclcpp::Node & node, const std::string & topic_name, const rclcpp::QoS & qos,
+  TypedMessageCallback callback, const rclcpp::SubscriptionOptions & options)
+{
+  return node.create_subscription<MessageT>(
+    topic_name, qos, [callback](std::shared_ptr<const MessageT> message) {
+      callback(message.get());
+    }, options);
+}
+
+// resolves a chain of pointers to members at compile time
+template<auto Member, auto ... Members>
+struct MemberChain
+{
+  template<typename T>
+  static const auto & get(const T & object)
+  {
+    if constexpr (sizeof...(Members) == 0) {
+      return object.*Member;
+    } else {
+      return MemberChain<Members...>::get(object.*Member);
+    }
+  }
+};
+
+template<typename MessageT, auto ... Members>
+double load_field(const void * message)
+{
+  return static_cast<double>(
+    MemberChain<Members...>::get(*static_cast<const MessageT *>(message)));
+}
+
+template<typename MessageT>
+class TypedMessageSupportBuilder
+{
+private:
+  TypedMessageSupport support_;
+
+public:
+  TypedMessageSupportBuilder()
+  {
+    support_.create_subscription = &create_typed_subscription<MessageT>;
+  }
+
+  template<auto ... Members>
+  TypedMessageSupportBuilder & field(const std::string & member_path)
+  {
+    support_.fields.emplace(member_path, &load_field<MessageT, Members...>);
+    return *this;
+  }
+
+  TypedMessageSupport build() const
+  {
+    return support_;
+  }
+};
+
+// message types with a typed fast path, keyed by full type name, e.g. geometry_msgs/msg/Twist
+const std::unordered_map<std::string, TypedMessageSupport> & typed_message_registry();
+
+std::vector<std::string> typed_message_types();
+
+// returns nullptr if the message type has no fast path
+const TypedMessageSupport * find_typed_message_support(const std::string & message_type);
+
+} // namespace quickplot
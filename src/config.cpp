@@ -6,6 +6,7 @@
 #include <sstream>
 #include <fstream>
 #include <charconv>
+#include <regex>
 #include <yaml-cpp/yaml.h>
 #include <rclcpp/rclcpp.hpp>
 #include "quickplot/config.hpp"
@@ -16,42 +17,9 @@ namespace fs = std::filesystem;
 namespace YAML
 {
 
-template<typename Value>
-struct convert<std::unordered_set<Value>>
-{
-  static YAML::Node encode(const std::unordered_set<Value> & rhs)
-  {
-    Node node(NodeType::Sequence);
-    for (auto it = std::begin(rhs); it != std::end(rhs); ++it) {
-      node.push_back(*it);
-    }
-    return node;
-  }
-
-  static bool decode(const Node & node, std::unordered_set<Value> & rhs)
-  {
-    if (!node.IsSequence()) {
-      return false;
-    }
-    for (auto it = node.begin(); it != node.end(); ++it) {
-      rhs.insert(it->as<Value>());
-    }
-    return true;
-  }
-};
-
 template<>
 struct convert<quickplot::MemberSequencePathItemDescriptor>
 {
-  static Node encode(const quickplot::MemberSequencePathItemDescriptor & item)
-  {
-    Node node(NodeType::Scalar);
-    std::stringstream ss;
-    write_member_sequence_path_item_descriptor(ss, item);
-    node = ss.str();
-    return node;
-  }
-
   static bool decode(const Node & node, quickplot::MemberSequencePathItemDescriptor & item)
   {
     auto in_str = node.as<std::string>();
@@ -61,6 +29,20 @@ struct convert<quickplot::MemberSequencePathItemDescriptor>
       item.sequence_idx = std::nullopt;
       return true;
     }
+    auto equals = in_str.find_first_of('=', first_bracket + 1);
+    if (equals != std::string::npos) {
+      // item selected by the value of a string sequence, e.g. position[name=elbow]
+      if (in_str.back() != ']' || equals == first_bracket + 1 || equals + 2 == in_str.size()) {
+        return false;
+      }
+      item.member_name = in_str.substr(0, first_bracket);
+      item.sequence_idx = std::nullopt;
+      item.sequence_key = quickplot::SequenceKeyDescriptor {
+        in_str.substr(first_bracket + 1, equals - first_bracket - 1),
+        in_str.substr(equals + 1, in_str.size() - equals - 2),
+      };
+      return true;
+    }
     auto last_bracket = in_str.find_first_of(']', first_bracket + 1);
     if (last_bracket == std::string::npos || last_bracket + 1 != in_str.size()) {
       return false;
@@ -79,33 +61,108 @@ struct convert<quickplot::MemberSequencePathItemDescriptor>
 };
 
 template<>
-struct convert<quickplot::DataSourceConfig>
+struct convert<quickplot::QosConfig>
 {
-  static Node encode(const quickplot::DataSourceConfig & config)
+  static bool decode(const Node & node, quickplot::QosConfig & config)
   {
-    Node node;
-    node["topic_name"] = config.topic_name;
-    node["member_path"] = config.member_path;
-    if (config.op == quickplot::DataSourceOperator::Sqrt) {
-      node["op"] = "sqrt";
-    } else if (config.op == quickplot::DataSourceOperator::L2Norm) {
-      node["op"] = "l2";
+    // defaults match the sensor data profile
+    config.history = quickplot::QosHistory::KeepLast;
+    config.depth = 5;
+    config.reliability = quickplot::QosReliability::BestEffort;
+    if (node["history"].IsDefined()) {
+      auto history = node["history"].as<std::string>();
+      if (history == "keep_all") {
+        config.history = quickplot::QosHistory::KeepAll;
+      } else if (history != "keep_last") {
+        return false;
+      }
+    }
+    if (node["depth"].IsDefined()) {
+      config.depth = node["depth"].as<size_t>();
+      if (config.depth == 0) {
+        return false;
+      }
+    }
+    if (node["reliability"].IsDefined()) {
+      auto reliability = node["reliability"].as<std::string>();
+      if (reliability == "reliable") {
+        config.reliability = quickplot::QosReliability::Reliable;
+      } else if (reliability != "best_effort") {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// op and axis, shared by series and topic patterns
+static quickplot::DataSourceOperator decode_op(const Node & node)
+{
+  if (node["op"].IsDefined()) {
+    auto op = node["op"].as<std::string>();
+    if (op == "sqrt") {
+      return quickplot::DataSourceOperator::Sqrt;
+    } else if (op == "l2") {
+      return quickplot::DataSourceOperator::L2Norm;
     }
-    return node;
   }
+  return quickplot::DataSourceOperator::Identity;
+}
+
+static bool decode_axis(const Node & node, int & axis)
+{
+  if (node["axis"].IsDefined()) {
+    axis = node["axis"].as<int>();
+    return axis >= 0 && axis <= 2;
+  }
+  axis = 0;
+  return true;
+}
 
+static bool decode_priority(const Node & node, quickplot::SeriesPriority & priority)
+{
+  priority = quickplot::SeriesPriority::Normal;
+  if (!node["priority"].IsDefined()) {
+    return true;
+  }
+  auto name = node["priority"].as<std::string>();
+  for (auto candidate : {quickplot::SeriesPriority::Low, quickplot::SeriesPriority::Normal,
+      quickplot::SeriesPriority::High})
+  {
+    if (name == quickplot::series_priority_name(candidate)) {
+      priority = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+template<>
+struct convert<quickplot::DataSourceConfig>
+{
   static bool decode(const Node & node, quickplot::DataSourceConfig & config)
   {
+    for (const auto & [key, kind] : {
+        std::make_pair("socket_channel", quickplot::DataSourceKind::Socket),
+        std::make_pair("push_series", quickplot::DataSourceKind::Push)})
+    {
+      if (node[key].IsDefined()) {
+        // channels have a single value, so there is no member to select
+        config.topic_name = node[key].as<std::string>();
+        config.member_path.clear();
+        config.op = quickplot::DataSourceOperator::Identity;
+        config.kind = kind;
+        return !config.topic_name.empty();
+      }
+    }
     config.topic_name = node["topic_name"].as<std::string>();
     config.member_path = node["member_path"].as<quickplot::MemberSequencePathDescriptor>();
-    config.op = quickplot::DataSourceOperator::Identity;
-    if (node["op"].IsDefined()) {
-      auto op = node["op"].as<std::string>();
-      if (op == "sqrt") {
-        config.op = quickplot::DataSourceOperator::Sqrt;
-      } else if (op == "l2") {
-        config.op = quickplot::DataSourceOperator::L2Norm;
-      }
+    config.op = decode_op(node);
+    if (node["qos"].IsDefined()) {
+      config.qos = node["qos"].as<quickplot::QosConfig>();
+    }
+    if (node["domain_id"].IsDefined()) {
+      config.domain_id = node["domain_id"].as<size_t>();
     }
     return true;
   }
@@ -114,48 +171,62 @@ struct convert<quickplot::DataSourceConfig>
 template<>
 struct convert<quickplot::TimeSeriesConfig>
 {
-  static Node encode(const quickplot::TimeSeriesConfig & config)
-  {
-    Node node;
-    node["source"] = config.source;
-    if (config.stddev_source.has_value()) {
-      node["stddev_source"] = config.stddev_source.value();
-    }
-    if (config.axis != 0) {
-      node["axis"] = config.axis;
-    }
-    return node;
-  }
-
   static bool decode(const Node & node, quickplot::TimeSeriesConfig & config)
   {
     config.source = node["source"].as<quickplot::DataSourceConfig>();
     if (node["stddev_source"].IsDefined()) {
       config.stddev_source = node["stddev_source"].as<quickplot::DataSourceConfig>();
     }
-    if (node["axis"].IsDefined()) {
-      config.axis = node["axis"].as<int>();
-      if (config.axis < 0 || config.axis > 2) {
+    return decode_axis(node, config.axis) && decode_priority(node, config.priority);
+  }
+};
+
+template<>
+struct convert<quickplot::TopicPatternConfig>
+{
+  static bool decode(const Node & node, quickplot::TopicPatternConfig & config)
+  {
+    config.topic_pattern = node["topic_pattern"].as<std::string>();
+    try {
+      std::regex(config.topic_pattern);
+    } catch (const std::regex_error &) {
+      return false;
+    }
+    config.domain_id = std::nullopt;
+    if (node["domain_id"].IsDefined()) {
+      config.domain_id = node["domain_id"].as<size_t>();
+    }
+    config.member_path = node["member_path"].as<quickplot::MemberSequencePathDescriptor>();
+    config.op = decode_op(node);
+    if (node["qos"].IsDefined()) {
+      config.qos = node["qos"].as<quickplot::QosConfig>();
+    }
+    config.aggregate = std::nullopt;
+    if (node["aggregate"].IsDefined()) {
+      quickplot::AggregateConfig aggregate;
+      auto op = node["aggregate"].as<std::string>();
+      if (op == "min") {
+        aggregate.op = quickplot::AggregateOperator::Min;
+      } else if (op == "max") {
+        aggregate.op = quickplot::AggregateOperator::Max;
+      } else if (op == "mean") {
+        aggregate.op = quickplot::AggregateOperator::Mean;
+      } else {
         return false;
       }
-    } else {
-      config.axis = 0;
+      aggregate.bucket = node["bucket"].IsDefined() ? node["bucket"].as<double>() : 1.0;
+      if (!(aggregate.bucket > 0.0)) {
+        return false;
+      }
+      config.aggregate = aggregate;
     }
-    return true;
+    return decode_axis(node, config.axis) && decode_priority(node, config.priority);
   }
 };
 
 template<>
 struct convert<quickplot::AxisConfig>
 {
-  static Node encode(const quickplot::AxisConfig & s)
-  {
-    Node node;
-    node["y_min"] = s.y_min;
-    node["y_max"] = s.y_max;
-    return node;
-  }
-
   static bool decode(const Node & node, quickplot::AxisConfig & s)
   {
     s.y_min = node["y_min"].as<double>();
@@ -167,18 +238,27 @@ struct convert<quickplot::AxisConfig>
 template<>
 struct convert<quickplot::PlotConfig>
 {
-  static Node encode(const quickplot::PlotConfig & s)
-  {
-    Node node;
-    node["axes"] = s.axes;
-    node["series"] = s.series;
-    return node;
-  }
-
   static bool decode(const Node & node, quickplot::PlotConfig & s)
   {
     s.axes = node["axes"].as<std::vector<quickplot::AxisConfig>>();
-    s.series = node["series"].as<std::unordered_set<quickplot::TimeSeriesConfig>>();
+    auto series = node["series"];
+    if (!series.IsSequence()) {
+      return false;
+    }
+    s.series.clear();
+    s.series.reserve(series.size());
+    std::unordered_set<quickplot::TimeSeriesConfig> seen;
+    seen.reserve(series.size());
+    for (const auto & item : series) {
+      auto config = item.as<quickplot::TimeSeriesConfig>();
+      if (seen.insert(config).second) {
+        s.series.push_back(std::move(config));
+      }
+    }
+    s.patterns.clear();
+    if (node["patterns"].IsDefined()) {
+      s.patterns = node["patterns"].as<std::vector<quickplot::TopicPatternConfig>>();
+    }
     return true;
   }
 };
@@ -186,14 +266,6 @@ struct convert<quickplot::PlotConfig>
 template<>
 struct convert<quickplot::ApplicationConfig>
 {
-  static Node encode(const quickplot::ApplicationConfig & config)
-  {
-    Node node;
-    node["history_length"] = config.history_length;
-    node["plots"] = config.plots;
-    return node;
-  }
-
   static bool decode(const Node & node, quickplot::ApplicationConfig & config)
   {
     config.history_length = node["history_length"].as<double>();
@@ -201,6 +273,142 @@ struct convert<quickplot::ApplicationConfig>
     return true;
   }
 };
+
+// configs are saved by streaming into an emitter, which does not build a node tree first
+
+Emitter & operator<<(Emitter & out, const quickplot::MemberSequencePathItemDescriptor & item)
+{
+  std::stringstream ss;
+  write_member_sequence_path_item_descriptor(ss, item);
+  return out << ss.str();
+}
+
+Emitter & operator<<(Emitter & out, const quickplot::QosConfig & config)
+{
+  out << BeginMap;
+  if (config.history == quickplot::QosHistory::KeepAll) {
+    out << Key << "history" << Value << "keep_all";
+  } else {
+    out << Key << "history" << Value << "keep_last";
+    out << Key << "depth" << Value << config.depth;
+  }
+  out << Key << "reliability" << Value <<
+  (config.reliability == quickplot::QosReliability::Reliable ? "reliable" : "best_effort");
+  return out << EndMap;
+}
+
+// member path, op and QoS keys, shared by sources and topic patterns
+static void emit_member_keys(
+  Emitter & out, const quickplot::MemberSequencePathDescriptor & member_path,
+  quickplot::DataSourceOperator op, const std::optional<quickplot::QosConfig> & qos)
+{
+  out << Key << "member_path" << Value << BeginSeq;
+  for (const auto & item : member_path) {
+    out << item;
+  }
+  out << EndSeq;
+  if (op == quickplot::DataSourceOperator::Sqrt) {
+    out << Key << "op" << Value << "sqrt";
+  } else if (op == quickplot::DataSourceOperator::L2Norm) {
+    out << Key << "op" << Value << "l2";
+  }
+  if (qos.has_value()) {
+    out << Key << "qos" << Value << qos.value();
+  }
+}
+
+Emitter & operator<<(Emitter & out, const quickplot::DataSourceConfig & config)
+{
+  out << BeginMap;
+  if (config.kind == quickplot::DataSourceKind::Socket) {
+    out << Key << "socket_channel" << Value << config.topic_name;
+    return out << EndMap;
+  } else if (config.kind == quickplot::DataSourceKind::Push) {
+    out << Key << "push_series" << Value << config.topic_name;
+    return out << EndMap;
+  }
+  out << Key << "topic_name" << Value << config.topic_name;
+  emit_member_keys(out, config.member_path, config.op, config.qos);
+  if (config.domain_id.has_value()) {
+    out << Key << "domain_id" << Value << config.domain_id.value();
+  }
+  return out << EndMap;
+}
+
+Emitter & operator<<(Emitter & out, const quickplot::TopicPatternConfig & config)
+{
+  out << BeginMap;
+  out << Key << "topic_pattern" << Value << config.topic_pattern;
+  if (config.domain_id.has_value()) {
+    out << Key << "domain_id" << Value << config.domain_id.value();
+  }
+  emit_member_keys(out, config.member_path, config.op, config.qos);
+  if (config.axis != 0) {
+    out << Key << "axis" << Value << config.axis;
+  }
+  if (config.aggregate.has_value()) {
+    out << Key << "aggregate" << Value << quickplot::aggregate_operator_name(config.aggregate->op);
+    out << Key << "bucket" << Value << config.aggregate->bucket;
+  }
+  if (config.priority != quickplot::SeriesPriority::Normal) {
+    out << Key << "priority" << Value << quickplot::series_priority_name(config.priority);
+  }
+  return out << EndMap;
+}
+
+Emitter & operator<<(Emitter & out, const quickplot::TimeSeriesConfig & config)
+{
+  out << BeginMap;
+  out << Key << "source" << Value << config.source;
+  if (config.stddev_source.has_value()) {
+    out << Key << "stddev_source" << Value << config.stddev_source.value();
+  }
+  if (config.axis != 0) {
+    out << Key << "axis" << Value << config.axis;
+  }
+  if (config.priority != quickplot::SeriesPriority::Normal) {
+    out << Key << "priority" << Value << quickplot::series_priority_name(config.priority);
+  }
+  return out << EndMap;
+}
+
+Emitter & operator<<(Emitter & out, const quickplot::PlotConfig & config)
+{
+  out << BeginMap;
+  out << Key << "axes" << Value << BeginSeq;
+  for (const auto & axis : config.axes) {
+    out << BeginMap;
+    out << Key << "y_min" << Value << axis.y_min;
+    out << Key << "y_max" << Value << axis.y_max;
+    out << EndMap;
+  }
+  out << EndSeq;
+  out << Key << "series" << Value << BeginSeq;
+  for (const auto & series : config.series) {
+    out << series;
+  }
+  out << EndSeq;
+  if (!config.patterns.empty()) {
+    out << Key << "patterns" << Value << BeginSeq;
+    for (const auto & pattern : config.patterns) {
+      out << pattern;
+    }
+    out << EndSeq;
+  }
+  return out << EndMap;
+}
+
+Emitter & operator<<(Emitter & out, const quickplot::ApplicationConfig & config)
+{
+  out << BeginMap;
+  out << Key << "history_length" << Value << config.history_length;
+  out << Key << "plots" << Value << BeginSeq;
+  for (const auto & plot : config.plots) {
+    out << plot;
+  }
+  out << EndSeq;
+  return out << EndMap;
+}
 } // namespace YAML
 
 namespace quickplot
@@ -227,19 +435,67 @@ fs::path get_default_config_directory()
   return fs::path(xdg_config_home).append(APPLICATION_NAME);
 }
 
+std::string qualified_topic_name(std::optional<size_t> domain_id, const std::string & topic_name)
+{
+  if (!domain_id.has_value()) {
+    return topic_name;
+  }
+  return "[" + std::to_string(domain_id.value()) + "]" + topic_name;
+}
+
+std::pair<std::optional<size_t>, std::string> split_qualified_topic_name(
+  const std::string & qualified)
+{
+  // topic names cannot contain brackets, so only qualified names start with one
+  auto end = qualified.find(']');
+  if (qualified.empty() || qualified[0] != '[' || end == std::string::npos) {
+    return {std::nullopt, qualified};
+  }
+  size_t domain_id;
+  auto result = std::from_chars(qualified.data() + 1, qualified.data() + end, domain_id);
+  if (result.ec != std::errc() || result.ptr != qualified.data() + end) {
+    return {std::nullopt, qualified};
+  }
+  return {domain_id, qualified.substr(end + 1)};
+}
+
+const char * aggregate_operator_name(AggregateOperator op)
+{
+  switch (op) {
+    case AggregateOperator::Min:
+      return "min";
+    case AggregateOperator::Max:
+      return "max";
+    default:
+      return "mean";
+  }
+}
+
+const char * series_priority_name(SeriesPriority priority)
+{
+  switch (priority) {
+    case SeriesPriority::Low:
+      return "low";
+    case SeriesPriority::High:
+      return "high";
+    default:
+      return "normal";
+  }
+}
+
 fs::path get_default_config_path()
 {
   return get_default_config_directory().append("default.yaml");
 }
 
-void save_config(ApplicationConfig config, fs::path path)
+void save_config(const ApplicationConfig & config, fs::path path)
 {
   std::ofstream fout;
   std::ios_base::iostate errors = fout.exceptions() | std::ios::failbit;
   fout.exceptions(errors);
   fout.open(path);
-  YAML::Node node = YAML::convert<ApplicationConfig>::encode(config);
-  fout << node;
+  YAML::Emitter out(fout);
+  out << config;
   fout << std::endl;
   fout.close();
 }
@@ -262,4 +518,36 @@ ApplicationConfig load_config(fs::path path)
   }
 }
 
+ConfigWatcher::ConfigWatcher(fs::path path, std::chrono::steady_clock::duration poll_period)
+: path_(path), poll_period_(poll_period), last_poll_(std::chrono::steady_clock::now())
+{
+  std::error_code ec;
+  auto write_time = fs::last_write_time(path_, ec);
+  if (!ec) {
+    last_write_time_ = write_time;
+  }
+}
+
+std::optional<ApplicationConfig> ConfigWatcher::poll()
+{
+  auto now = std::chrono::steady_clock::now();
+  if (now - last_poll_ < poll_period_) {
+    return std::nullopt;
+  }
+  last_poll_ = now;
+  std::error_code ec;
+  auto write_time = fs::last_write_time(path_, ec);
+  if (ec || write_time == last_write_time_) {
+    return std::nullopt;
+  }
+  last_write_time_ = write_time;
+  try {
+    return load_config(path_);
+  } catch (const config_error & e) {
+    // editors may save incomplete files, the next write triggers another attempt
+    std::cerr << "Failed to reload configuration from " << path_ << std::endl;
+    return std::nullopt;
+  }
+}
+
 } // namespace quickplot
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cmath>
+#include "quickplot/histogram.hpp"
+
+namespace quickplot
+{
+
+size_t WindowedHistogram::bucket_index(uint64_t value)
+{
+  if (value < SUB_BUCKETS) {
+    return value;
+  }
+  unsigned exponent = 63 - __builtin_clzll(value);
+  if (exponent >= MAX_VALUE_BITS) {
+    return BUCKETS - 1;
+  }
+  uint64_t mantissa = (value >> (exponent - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+  return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS + mantissa;
+}
+
+uint64_t WindowedHistogram::bucket_upper_bound(size_t index)
+{
+  if (index < SUB_BUCKETS) {
+    return index;
+  }
+  auto k = index - SUB_BUCKETS;
+  unsigned shift = k / SUB_BUCKETS;
+  uint64_t lower = (SUB_BUCKETS + k % SUB_BUCKETS) << shift;
+  return lower + (uint64_t(1) << shift) - 1;
+}
+
+WindowedHistogram::WindowedHistogram(std::chrono::nanoseconds slot_duration, size_t slots)
+: slot_duration_(slot_duration.count()), slots_(std::max<size_t>(slots, 1)), first_record_(-1)
+{
+  for (auto & slot : slots_) {
+    slot.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+WindowedHistogram::~WindowedHistogram()
+{
+  for (auto & slot : slots_) {
+    delete slot.load(std::memory_order_relaxed);
+  }
+}
+
+void WindowedHistogram::record(uint64_t value, std::chrono::nanoseconds now)
+{
+  auto t = now.count();
+  auto epoch = t / slot_duration_;
+  auto & slot_ptr = slots_[static_cast<size_t>(epoch) % slots_.size()];
+  if (!slot_ptr.load(std::memory_order_relaxed)) {
+    // value-initialized, so all counts are zero
+    auto * new_slot = new Slot();
+    new_slot->epoch.store(-1, std::memory_order_relaxed);
+    slot_ptr.store(new_slot, std::memory_order_release);
+  }
+  auto & slot = *slot_ptr.load(std::memory_order_relaxed);
+  if (slot.epoch.load(std::memory_order_relaxed) != epoch) {
+    // the slot holds values of an expired epoch; invalidate it while resetting
+    slot.epoch.store(-1, std::memory_order_relaxed);
+    for (auto & bucket : slot.buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    slot.sum.store(0, std::memory_order_relaxed);
+    slot.max.store(0, std::memory_order_relaxed);
+    slot.epoch.store(epoch, std::memory_order_release);
+  }
+  if (first_record_.load(std::memory_order_relaxed) < 0) {
+    first_record_.store(t, std::memory_order_relaxed);
+  }
+
+  // single writer, so load and store instead of read-modify-write operations
+  auto & bucket = slot.buckets[bucket_index(value)];
+  bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  slot.sum.store(slot.sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  if (value > slot.max.load(std::memory_order_relaxed)) {
+    slot.max.store(value, std::memory_order_relaxed);
+  }
+}
+
+HistogramSummary WindowedHistogram::summary(std::chrono::nanoseconds now) const
+{
+  HistogramSummary summary {
+    .count = 0,
+    .p50 = 0,
+    .p99 = 0,
+    .max = 0,
+    .sum = 0,
+    .window = 0.0,
+  };
+  auto t = now.count();
+  auto current_epoch = t / slot_duration_;
+  auto oldest_epoch = current_epoch - static_cast<int64_t>(slots_.size()) + 1;
+
+  std::array<uint64_t, BUCKETS> merged {};
+  for (const auto & slot_ptr : slots_) {
+    const auto * slot = slot_ptr.load(std::memory_order_acquire);
+    if (!slot) {
+      continue;
+    }
+    auto epoch = slot->epoch.load(std::memory_order_acquire);
+    if (epoch < 0 || epoch < oldest_epoch || epoch > current_epoch) {
+      continue;
+    }
+    for (size_t i = 0; i < BUCKETS; i++) {
+      merged[i] += slot->buckets[i].load(std::memory_order_relaxed);
+    }
+    summary.sum += slot->sum.load(std::memory_order_relaxed);
+    summary.max = std::max(summary.max, slot->max.load(std::memory_order_relaxed));
+  }
+  for (auto count : merged) {
+    summary.count += count;
+  }
+  if (summary.count == 0) {
+    return summary;
+  }
+
+  auto percentile = [&](double p) {
+      auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * summary.count)));
+      uint64_t cumulative = 0;
+      for (size_t i = 0; i < BUCKETS; i++) {
+        cumulative += merged[i];
+        if (cumulative >= rank) {
+          return std::min(bucket_upper_bound(i), summary.max);
+        }
+      }
+      return summary.max;
+    };
+  summary.p50 = percentile(0.5);
+  summary.p99 = percentile(0.99);
+
+  auto covered = (static_cast<int64_t>(slots_.size()) - 1) * slot_duration_ +
+    (t - current_epoch * slot_duration_);
+  auto since_first = t - first_record_.load(std::memory_order_relaxed);
+  summary.window = std::max<int64_t>(0, std::min(covered, since_first)) * 1e-9;
+  return summary;
+}
+
+void WindowedHistogram::clear()
+{
+  for (auto & slot_ptr : slots_) {
+    auto * slot = slot_ptr.load(std::memory_order_acquire);
+    if (slot) {
+      // the writer resets the buckets of the slot before recording into it again
+      slot->epoch.store(-1, std::memory_order_relaxed);
+    }
+  }
+  first_record_.store(-1, std::memory_order_relaxed);
+}
+
+size_t WindowedHistogram::memory_size() const
+{
+  size_t allocated = 0;
+  for (const auto & slot : slots_) {
+    if (slot.load(std::memory_order_relaxed)) {
+      ++allocated;
+    }
+  }
+  return slots_.capacity() * sizeof(std::atomic<Slot *>) + allocated * sizeof(Slot);
+}
+
+} // namespace quickplot
+
+std::ostream & operator<<(std::ostream & os, const quickplot::HistogramSummary & summary)
+{
+  os << "{count: " << summary.count << ", rate: " << summary.rate() << ", p50: " <<
+    summary.p50 << ", p99: " << summary.p99 << ", max: " << summary.max << ", sum_rate: " <<
+    summary.sum_rate() << "}";
+  return os;
+}
@@ -0,0 +1,64 @@
+#include <rclcpp_components/register_node_macro.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include "quickplot/application.hpp"
+#include "quickplot/config.hpp"
+#include "quickplot/ingest_component.hpp"
+#include "quickplot/ingest_loop.hpp"
+
+namespace quickplot
+{
+
+IngestComponent::IngestComponent(const rclcpp::NodeOptions & options)
+: node_(std::make_shared<QuickPlotNode>("quickplot_ingest", options))
+{
+  // the component has no display, so exporting is the only way to make use of its data
+  if (node_->get_parameter("shared_memory").as_string() != "export") {
+    node_->set_parameter(rclcpp::Parameter("shared_memory", "export"));
+  }
+  // the history snapshot belongs to the quickplot window, which would restore the component's
+  node_->set_parameter(rclcpp::Parameter("snapshot", false));
+  auto config_file = node_->declare_parameter<std::string>(
+    "config", get_default_config_path().string());
+  // interval at which new topics are discovered and data older than the history is pruned
+  auto update_period = node_->declare_parameter<double>("update_period", 0.1);
+
+  ApplicationConfig config;
+  try {
+    config = load_config(config_file);
+    std::cout << "Using configuration at " << config_file << std::endl;
+  } catch (const config_error & e) {
+    std::cerr << "Failed to read configuration from '" << config_file << "'" << std::endl;
+    config = default_config();
+  }
+
+  if (node_->uses_ingest_loop()) {
+    ingest_loop_ = std::make_unique<IngestLoop>(node_);
+    ingest_thread_ = std::thread([this] {ingest_loop_->run();});
+  }
+  app_ = std::make_unique<Application>(node_);
+  app_->apply_config(config);
+  update_timer_ = node_->create_wall_timer(
+    std::chrono::duration<double>(update_period), [this] {
+      app_->update_headless();
+    });
+}
+
+IngestComponent::~IngestComponent()
+{
+  if (ingest_thread_.joinable()) {
+    ingest_loop_->stop();
+    ingest_thread_.join();
+  }
+}
+
+rclcpp::node_interfaces::NodeBaseInterface::SharedPtr IngestComponent::get_node_base_interface()
+const
+{
+  return node_->get_node_base_interface();
+}
+
+} // namespace quickplot
+
+RCLCPP_COMPONENTS_REGISTER_NODE(quickplot::IngestComponent)
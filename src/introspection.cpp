@@ -36,6 +36,54 @@ double cast_numeric(const void * n, uint8_t type_id)
       return *static_cast<const uint16_t *>(n);
     case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8:
       return *static_cast<const uint8_t *>(n);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET:
+      return *static_cast<const uint8_t *>(n);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN:
+      return *static_cast<const bool *>(n) ? 1.0 : 0.0;
+    default:
+      throw std::invalid_argument("non-numeric member type_id");
+  }
+}
+
+void assign_numeric(void * n, uint8_t type_id, double value)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
+      *static_cast<float *>(n) = static_cast<float>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_DOUBLE:
+      *static_cast<double *>(n) = value;
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT64:
+      *static_cast<int64_t *>(n) = static_cast<int64_t>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT32:
+      *static_cast<int32_t *>(n) = static_cast<int32_t>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT16:
+      *static_cast<int16_t *>(n) = static_cast<int16_t>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT8:
+      *static_cast<int8_t *>(n) = static_cast<int8_t>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT64:
+      *static_cast<uint64_t *>(n) = static_cast<uint64_t>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT32:
+      *static_cast<uint32_t *>(n) = static_cast<uint32_t>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT16:
+      *static_cast<uint16_t *>(n) = static_cast<uint16_t>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8:
+      *static_cast<uint8_t *>(n) = static_cast<uint8_t>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET:
+      *static_cast<uint8_t *>(n) = static_cast<uint8_t>(value);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN:
+      *static_cast<bool *>(n) = value != 0.0;
+      break;
     default:
       throw std::invalid_argument("non-numeric member type_id");
   }
@@ -63,8 +111,11 @@ MemberSequencePath assume_members_unindexed(const MemberPath & in_path)
 
 double get_numeric(const void * message, const MemberSequencePath & path, DataSourceOperator op)
 {
+  if (path.empty()) {
+    throw introspection_error("member path is empty");
+  }
   auto member_memory = static_cast<const uint8_t *>(message);
-  uint8_t last_type;
+  uint8_t last_type = 0;
   for (const auto & [member, idx] : path) {
     member_memory += member->offset_;
     if (member->is_array_) {
@@ -84,6 +135,27 @@ double get_numeric(const void * message, const MemberSequencePath & path, DataSo
   return value;
 }
 
+void set_numeric(void * message, const MemberSequencePath & path, double value)
+{
+  if (path.empty()) {
+    throw introspection_error("member path is empty");
+  }
+  auto member_memory = static_cast<uint8_t *>(message);
+  uint8_t last_type = 0;
+  for (const auto & [member, idx] : path) {
+    member_memory += member->offset_;
+    if (member->is_array_) {
+      // grow sequences to contain the index, fixed size arrays have no resize function
+      if (member->resize_function && member->size_function(member_memory) <= idx) {
+        member->resize_function(member_memory, idx + 1);
+      }
+      member_memory = static_cast<uint8_t *>(member->get_function(member_memory, idx));
+    }
+    last_type = member->type_id_;
+  }
+  assign_numeric(member_memory, last_type, value);
+}
+
 MemberSequencePathItemDescriptor to_descriptor_item(const MemberSequencePathItem & item)
 {
   std::optional<size_t> idx = std::nullopt;
@@ -105,6 +177,52 @@ MemberSequencePathDescriptor to_descriptor(const MemberSequencePath & in_path)
   return out_path;
 }
 
+MemberSequencePathDescriptor to_descriptor(const MessageAccessor & accessor)
+{
+  auto out_path = to_descriptor(accessor.member);
+  if (accessor.key.has_value()) {
+    auto & item = out_path[accessor.key->item];
+    item.sequence_idx = std::nullopt;
+    item.sequence_key = SequenceKeyDescriptor {
+      accessor.key->key_member->name_,
+      accessor.key->value,
+    };
+  }
+  return out_path;
+}
+
+bool resolve_sequence_key(const void * message, MessageAccessor & accessor)
+{
+  const auto & key = accessor.key.value();
+  // message containing both sequences
+  auto member_memory = static_cast<const uint8_t *>(message);
+  for (size_t i = 0; i < key.item; i++) {
+    const auto & [member, idx] = accessor.member[i];
+    member_memory += member->offset_;
+    if (member->is_array_) {
+      member_memory = static_cast<const uint8_t *>(member->get_const_function(member_memory, idx));
+    }
+  }
+  auto & [sequence, cached_idx] = accessor.member[key.item];
+  auto keys = member_memory + key.key_member->offset_;
+  auto values = member_memory + sequence->offset_;
+  auto size = std::min(key.key_member->size_function(keys), sequence->size_function(values));
+  auto matches = [&](size_t idx) {
+      return *static_cast<const std::string *>(key.key_member->get_const_function(keys, idx)) ==
+             key.value;
+    };
+  if (cached_idx < size && matches(cached_idx)) {
+    return true;
+  }
+  for (size_t idx = 0; idx < size; idx++) {
+    if (matches(idx)) {
+      cached_idx = idx;
+      return true;
+    }
+  }
+  return false;
+}
+
 bool contains_sequence(const MemberPath & member_path)
 {
   for (const auto & member : member_path) {
@@ -138,11 +256,37 @@ bool is_numeric(uint8_t type_id)
       return true;
     case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8:
       return true;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET:
+      return true;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN:
+      return true;
     default:
       return false;
   }
 }
 
+bool is_state(uint8_t type_id)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN:
+      return true;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET:
+      return true;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT8:
+      return true;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool is_state(const MessageAccessor & accessor)
+{
+  return accessor.op == DataSourceOperator::Identity && !accessor.member.empty() &&
+         is_state(accessor.member.back().first->type_id_);
+}
+
 MessageMemberContainer::MessageMemberContainer(
   const rosidl_message_type_support_t * introspection_support)
 : introspection_support_(introspection_support)
@@ -184,6 +328,11 @@ MessageIntrospection::MessageIntrospection(std::string message_type)
   }
 }
 
+std::string MessageIntrospection::library_path() const
+{
+  return introspection_support_library_->get_library_path();
+}
+
 const char * MessageIntrospection::message_type() const
 {
   return message_type_.c_str();
@@ -258,8 +407,8 @@ std::optional<MemberSequencePath> MessageIntrospection::get_member_sequence_path
     std::invalid_argument("member_path required");
   }
   std::vector<std::string> names;
-  for (const auto & [name, _] : in_path) {
-    names.push_back(name);
+  for (const auto & item : in_path) {
+    names.push_back(item.member_name);
   }
   auto member_path_opt = get_member_path(names);
   if (!member_path_opt.has_value()) {
@@ -272,7 +421,8 @@ std::optional<MemberSequencePath> MessageIntrospection::get_member_sequence_path
   MemberSequencePath result(in_path.size());
   MemberPath sub_path;
   for (size_t i = 0; i < result.size(); i++) {
-    if (in_path[i].sequence_idx.has_value() && !(*member_it)->is_array_) {
+    auto indexed = in_path[i].sequence_idx.has_value() || in_path[i].sequence_key.has_value();
+    if (indexed && !(*member_it)->is_array_) {
       throw introspection_error(
               "member sequence path descriptor item defines index for non-array member");
     }
@@ -283,6 +433,45 @@ std::optional<MemberSequencePath> MessageIntrospection::get_member_sequence_path
   return result;
 }
 
+std::optional<SequenceKey> MessageIntrospection::get_sequence_key(
+  const MemberSequencePathDescriptor & in_path, const MemberSequencePath & path) const
+{
+  std::optional<SequenceKey> key;
+  for (size_t i = 0; i < in_path.size(); i++) {
+    if (!in_path[i].sequence_key.has_value()) {
+      continue;
+    }
+    if (key.has_value()) {
+      throw introspection_error("member sequence path descriptor defines more than one key");
+    }
+    // the key sequence is a sibling of the keyed sequence
+    auto members = static_cast<const rosidl_typesupport_introspection_cpp::MessageMembers *>(
+      i == 0 ? introspection_support_handle_->data : path[i - 1].first->members_->data);
+    const auto & descriptor = in_path[i].sequence_key.value();
+    for (size_t j = 0; j < members->member_count_; j++) {
+      const auto & member = members->members_[j];
+      if (descriptor.member_name.compare(member.name_) != 0) {
+        continue;
+      }
+      if (!member.is_array_ ||
+        member.type_id_ != rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING)
+      {
+        throw introspection_error(
+                "sequence key member '" + descriptor.member_name + "' is not a string sequence");
+      }
+      key = SequenceKey {
+        .item = i,
+        .key_member = &member,
+        .value = descriptor.value,
+      };
+    }
+    if (!key.has_value()) {
+      throw introspection_error("sequence key member '" + descriptor.member_name + "' not found");
+    }
+  }
+  return key;
+}
+
 } // namespace quickplot
 
 void write_member_sequence_path_item_descriptor(
@@ -290,7 +479,9 @@ void write_member_sequence_path_item_descriptor(
   const quickplot::MemberSequencePathItemDescriptor & item)
 {
   out << item.member_name;
-  if (item.sequence_idx.has_value()) {
+  if (item.sequence_key.has_value()) {
+    out << "[" << item.sequence_key->member_name << "=" << item.sequence_key->value << "]";
+  } else if (item.sequence_idx.has_value()) {
     out << "[" << item.sequence_idx.value() << "]";
   }
 }
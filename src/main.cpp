@@ -10,6 +10,8 @@
 #include <filesystem>
 #include "quickplot/application.hpp"
 #include "quickplot/config.hpp"
+#include "quickplot/dock_space.hpp"
+#include "quickplot/ingest_loop.hpp"
 
 static void glfw_error_callback(int error, const char * description)
 {
@@ -38,6 +40,12 @@ int main(int argc, char ** argv)
   std::thread ros_thread([ = ] {
       rclcpp::spin(node);
     });
+  std::unique_ptr<quickplot::IngestLoop> ingest_loop;
+  std::thread ingest_thread;
+  if (node->uses_ingest_loop()) {
+    ingest_loop = std::make_unique<quickplot::IngestLoop>(node);
+    ingest_thread = std::thread([&ingest_loop] {ingest_loop->run();});
+  }
 
   fs::path config_file;
   bool using_default_config_file = false;
@@ -62,6 +70,10 @@ int main(int argc, char ** argv)
 
   quickplot::Application app(node);
   app.apply_config(config);
+  std::unique_ptr<quickplot::ConfigWatcher> config_watcher;
+  if (node->get_parameter("reload_config").as_bool()) {
+    config_watcher = std::make_unique<quickplot::ConfigWatcher>(config_file);
+  }
 
   glfwSetErrorCallback(glfw_error_callback);
   if (!glfwInit()) {
@@ -90,6 +102,8 @@ int main(int argc, char ** argv)
   }
 
   IMGUI_CHECKVERSION();
+  // count bytes allocated by ImGui and ImPlot for the memory window
+  ImGui::SetAllocatorFunctions(&quickplot::tracked_gui_alloc, &quickplot::tracked_gui_free);
   ImGui::CreateContext();
   ImPlot::CreateContext();
   ImGuiIO & io = ImGui::GetIO();
@@ -129,61 +143,19 @@ int main(int argc, char ** argv)
     // TODO(ZeilingerM) should probably be user-configured
     ImPlot::GetStyle().LineWeight = 2.0;
 
-    static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_PassthruCentralNode;
-    // build parent window with dock spaces
-    ImGuiWindowFlags parent_window_flags = ImGuiWindowFlags_NoSavedSettings;
-    parent_window_flags |= ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoCollapse |
-      ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove;
-    parent_window_flags |= ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoNavFocus;
-    if (dockspace_flags & ImGuiDockNodeFlags_PassthruCentralNode) {
-      parent_window_flags |= ImGuiWindowFlags_NoBackground;
-    }
-
-    ImGuiViewport * viewport = ImGui::GetMainViewport();
-    ImGui::SetNextWindowPos(viewport->Pos);
-    ImGui::SetNextWindowSize(viewport->Size);
-    ImGui::SetNextWindowViewport(viewport->ID);
-
-    // remove redundant padding from outer window
-    ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0, 0.0));
-    ImGui::Begin("ParentDock", nullptr, parent_window_flags);
-    ImGui::PopStyleVar();
-
-    ImGuiID dockspace_id = ImGui::GetID("ParentDockSpace");
-    ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), dockspace_flags);
-
-    if (first_time) {
-      first_time = false;
-      ImGui::DockBuilderRemoveNode(dockspace_id); // clear any previous layout
-      ImGui::DockBuilderAddNode(dockspace_id, dockspace_flags | ImGuiDockNodeFlags_DockSpace);
-      ImGui::DockBuilderSetNodeSize(dockspace_id, viewport->Size);
-
-      float default_list_width = (1 - (1.0 / 1.61803398875)) / 2.0;
-      ImGuiID dock_id_plot;
-      ImGuiID dock_id_list = ImGui::DockBuilderSplitNode(
-        dockspace_id, ImGuiDir_Left,
-        default_list_width, nullptr, &dock_id_plot);
-      // disable docking and bar in list window
-      ImGui::DockBuilderGetNode(dock_id_list)->SetLocalFlags(
-        ImGuiDockNodeFlags_NoDocking | ImGuiDockNodeFlags_NoTabBar);
-
-      // we now dock our windows into the docking node we made above
-      ImGui::DockBuilderDockWindow(quickplot::TOPIC_LIST_WINDOW_ID, dock_id_list);
-
-      if (config.plots.size() >= 1) {
-        ImGui::DockBuilderDockWindow("plot0", dock_id_plot);
-        float equal_ratio = 1.0 / config.plots.size();
-        for (size_t i = 1; i < config.plots.size(); i++) {
-          ImGui::DockBuilderSplitNode(
-            dock_id_plot, ImGuiDir_Down,
-            equal_ratio, &dock_id_plot, nullptr);
-          std::string win_id = "plot" + std::to_string(i);
-          ImGui::DockBuilderDockWindow(win_id.c_str(), dock_id_plot);
-        }
+    if (config_watcher) {
+      auto reloaded = config_watcher->poll();
+      if (reloaded.has_value()) {
+        // windows of added plots are docked by resetting the layout
+        first_time = first_time || reloaded->plots.size() != config.plots.size();
+        config = reloaded.value();
+        app.apply_config(config);
+        std::cout << "Reloaded configuration at " << config_file << std::endl;
       }
-      ImGui::DockBuilderFinish(dockspace_id);
     }
-    ImGui::End();
+
+    quickplot::ParentDockSpace(config.plots.size(), first_time);
+    first_time = false;
 
     // update quickplot
     app.update();
@@ -216,7 +188,14 @@ int main(int argc, char ** argv)
   if (using_default_config_file) {
     quickplot::save_config(app.get_config(), config_file);
   }
+  if (node->get_parameter("snapshot").as_bool()) {
+    app.save_snapshot();
+  }
 
   ros_thread.join();
+  if (ingest_thread.joinable()) {
+    ingest_loop->stop();
+    ingest_thread.join();
+  }
   return EXIT_SUCCESS;
 }
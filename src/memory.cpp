@@ -0,0 +1,133 @@
+#include <unistd.h>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "quickplot/memory.hpp"
+
+namespace fs = std::filesystem;
+
+namespace quickplot
+{
+
+MemoryUsage MemoryReport::accounted() const
+{
+  MemoryUsage total {
+    .used = gui.used,
+    .reserved = gui.reserved,
+  };
+  for (const auto & group : {&series, &subscriptions, &libraries}) {
+    for (const auto & item : *group) {
+      total += item.usage;
+    }
+  }
+  return total;
+}
+
+bool MemoryReport::over_budget() const
+{
+  return budget != 0 && resident > budget;
+}
+
+// allocation size is stored in front of each block, with the alignment malloc guarantees
+constexpr size_t ALLOCATION_HEADER_SIZE = alignof(std::max_align_t);
+
+static std::atomic<size_t> gui_bytes {0};
+
+void * tracked_gui_alloc(size_t size, void *)
+{
+  auto block = static_cast<char *>(std::malloc(size + ALLOCATION_HEADER_SIZE));
+  if (!block) {
+    return nullptr;
+  }
+  *reinterpret_cast<size_t *>(block) = size;
+  gui_bytes.fetch_add(size, std::memory_order_relaxed);
+  return block + ALLOCATION_HEADER_SIZE;
+}
+
+void tracked_gui_free(void * ptr, void *)
+{
+  if (!ptr) {
+    return;
+  }
+  auto block = static_cast<char *>(ptr) - ALLOCATION_HEADER_SIZE;
+  gui_bytes.fetch_sub(*reinterpret_cast<size_t *>(block), std::memory_order_relaxed);
+  std::free(block);
+}
+
+size_t tracked_gui_bytes()
+{
+  return gui_bytes.load(std::memory_order_relaxed);
+}
+
+size_t resident_set_size()
+{
+  // second field of statm is the number of resident pages
+  std::ifstream statm("/proc/self/statm");
+  size_t total_pages, resident_pages;
+  if (!(statm >> total_pages >> resident_pages)) {
+    return 0;
+  }
+  return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+size_t mapped_library_size(const std::string & path)
+{
+  std::error_code ec;
+  auto canonical = fs::canonical(path, ec);
+  if (ec) {
+    return 0;
+  }
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  size_t size = 0;
+  while (std::getline(maps, line)) {
+    // address range, permissions, offset, device, inode, path
+    std::istringstream fields(line);
+    std::string range, perms, offset, device, inode, mapped_path;
+    fields >> range >> perms >> offset >> device >> inode >> mapped_path;
+    if (mapped_path != canonical.string()) {
+      continue;
+    }
+    auto dash = range.find('-');
+    if (dash == std::string::npos) {
+      continue;
+    }
+    auto begin = std::stoull(range.substr(0, dash), nullptr, 16);
+    auto end = std::stoull(range.substr(dash + 1), nullptr, 16);
+    size += end - begin;
+  }
+  return size;
+}
+
+static void write_usage_list(
+  std::ostream & os, const char * key,
+  const std::vector<NamedMemoryUsage> & items)
+{
+  os << key << ":";
+  if (items.empty()) {
+    os << " []";
+  }
+  os << "\n";
+  for (const auto & item : items) {
+    os << "  - {name: \"" << item.name << "\", used: " << item.usage.used << ", reserved: " <<
+      item.usage.reserved << "}\n";
+  }
+}
+
+void write_memory_report(std::ostream & os, const MemoryReport & report)
+{
+  auto accounted = report.accounted();
+  os << "resident: " << report.resident << "\n";
+  os << "budget: " << report.budget << "\n";
+  os << "over_budget: " << (report.over_budget() ? "true" : "false") << "\n";
+  os << "accounted: {used: " << accounted.used << ", reserved: " << accounted.reserved << "}\n";
+  os << "gui: {used: " << report.gui.used << ", reserved: " << report.gui.reserved << "}\n";
+  write_usage_list(os, "series", report.series);
+  write_usage_list(os, "subscriptions", report.subscriptions);
+  write_usage_list(os, "libraries", report.libraries);
+}
+
+} // namespace quickplot
@@ -59,14 +59,23 @@ void IntrospectionMessageDeserializer::deserialize(
   deserializer_->deserialize_message(&serialized_message, message);
 }
 
-std::optional<rclcpp::Time> IntrospectionMessageDeserializer::get_header_stamp(void * message) const
+void IntrospectionMessageDeserializer::serialize(
+  const void * message,
+  rclcpp::SerializedMessage & serialized_message) const
+{
+  deserializer_->serialize_message(message, &serialized_message);
+}
+
+std::optional<rclcpp::Time> IntrospectionMessageDeserializer::get_header_stamp(
+  const void * message) const
 {
   if (!header_offset_.has_value()) {
     return {};
   }
-  auto bytes = static_cast<uint8_t *>(message);
+  auto bytes = static_cast<const uint8_t *>(message);
   auto header =
-    static_cast<std_msgs::msg::Header *>(static_cast<void *>(bytes + header_offset_.value()));
+    static_cast<const std_msgs::msg::Header *>(
+    static_cast<const void *>(bytes + header_offset_.value()));
   return header->stamp;
 }
 
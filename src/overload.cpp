@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <vector>
+#include "quickplot/overload.hpp"
+
+namespace quickplot
+{
+
+OverloadController::OverloadController(double budget, size_t backlog_limit)
+: budget_(budget), backlog_limit_(backlog_limit)
+{
+  decimation_.fill(1);
+}
+
+void OverloadController::update(const std::vector<IngestLoad> & loads, double period)
+{
+  double busy = 0.0;
+  bool backlog = false;
+  std::array<bool, SERIES_PRIORITY_COUNT> present {};
+  for (const auto & load : loads) {
+    busy += load.busy;
+    backlog = backlog || load.backlog > backlog_limit_;
+    present[static_cast<size_t>(load.priority)] = true;
+  }
+  load_ = period > 0.0 ? busy / period : 0.0;
+  overloaded_ = backlog || load_ > budget_;
+  auto high = static_cast<size_t>(SeriesPriority::High);
+  if (overloaded_) {
+    // thin the least important topics first
+    for (size_t p = 0; p < high; p++) {
+      if (present[p] && decimation_[p] < MAX_DECIMATION) {
+        decimation_[p] *= 2;
+        return;
+      }
+    }
+    return;
+  }
+  if (load_ < RECOVERY_FRACTION * budget_) {
+    // restore the most important topics first
+    for (size_t p = high; p-- > 0; ) {
+      if (decimation_[p] > 1) {
+        decimation_[p] /= 2;
+        return;
+      }
+    }
+  }
+}
+
+bool OverloadController::shedding() const
+{
+  return std::any_of(
+    decimation_.begin(), decimation_.end(), [](size_t decimation) {
+      return decimation > 1;
+    });
+}
+
+} // namespace quickplot
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "quickplot/push.hpp"
+
+namespace quickplot
+{
+
+PushSeries::PushSeries(std::string name, size_t capacity)
+: name_(name), shard_capacity_(std::max<size_t>(capacity / SHARD_COUNT, 1))
+{
+
+}
+
+PushSeries::Shard & PushSeries::shard()
+{
+  // threads are assigned shards round robin on their first push to any series
+  static std::atomic<size_t> next_thread {0};
+  thread_local size_t thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+  return shards_[thread_index % SHARD_COUNT];
+}
+
+void PushSeries::push(double t, double value)
+{
+  push_batch(&t, &value, 1);
+}
+
+void PushSeries::push_batch(const double * t, const double * values, size_t count)
+{
+  auto & target = shard();
+  std::unique_lock<std::mutex> lock(target.mutex);
+  target.pushed += count;
+  if (readers_.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  auto space = shard_capacity_ - std::min(shard_capacity_, target.pending.size());
+  auto accepted = std::min(count, space);
+  for (size_t i = 0; i < accepted; i++) {
+    target.pending.push_back({t[i], values[i]});
+  }
+  target.dropped += count - accepted;
+}
+
+void PushSeries::push_batch(const Sample * samples, size_t count)
+{
+  auto & target = shard();
+  std::unique_lock<std::mutex> lock(target.mutex);
+  target.pushed += count;
+  if (readers_.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  auto space = shard_capacity_ - std::min(shard_capacity_, target.pending.size());
+  auto accepted = std::min(count, space);
+  target.pending.insert(target.pending.end(), samples, samples + accepted);
+  target.dropped += count - accepted;
+}
+
+uint64_t PushSeries::pushed() const
+{
+  uint64_t pushed = 0;
+  for (const auto & shard : shards_) {
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    pushed += shard.pushed;
+  }
+  return pushed;
+}
+
+uint64_t PushSeries::dropped() const
+{
+  uint64_t dropped = 0;
+  for (const auto & shard : shards_) {
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    dropped += shard.dropped;
+  }
+  return dropped;
+}
+
+void PushSeries::add_reader()
+{
+  readers_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PushSeries::remove_reader()
+{
+  if (readers_.fetch_sub(1, std::memory_order_relaxed) != 1) {
+    return;
+  }
+  // producers check the readers with the lock of their shard held, so none appends after this
+  for (auto & shard : shards_) {
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    std::vector<Sample>().swap(shard.pending);
+  }
+}
+
+size_t PushSeries::drain(std::vector<Sample> & out)
+{
+  auto begin = out.size();
+  size_t shards_with_samples = 0;
+  for (auto & shard : shards_) {
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    if (shard.pending.empty()) {
+      continue;
+    }
+    shards_with_samples++;
+    out.insert(out.end(), shard.pending.begin(), shard.pending.end());
+    shard.pending.clear();
+  }
+  // samples of one thread are usually in order, but threads interleave
+  if (shards_with_samples > 1) {
+    std::stable_sort(
+      out.begin() + begin, out.end(), [](const Sample & a, const Sample & b) {
+        return a.x < b.x;
+      });
+  }
+  return out.size() - begin;
+}
+
+static std::mutex registry_mutex;
+
+static std::map<std::string, std::shared_ptr<PushSeries>> & registry()
+{
+  static std::map<std::string, std::shared_ptr<PushSeries>> series;
+  return series;
+}
+
+std::shared_ptr<PushSeries> register_push_series(const std::string & name, size_t capacity)
+{
+  std::unique_lock<std::mutex> lock(registry_mutex);
+  auto & series = registry()[name];
+  if (!series) {
+    series = std::make_shared<PushSeries>(name, capacity);
+  }
+  return series;
+}
+
+std::shared_ptr<PushSeries> read_push_series(const std::string & name)
+{
+  auto series = register_push_series(name);
+  series->add_reader();
+  // the handle shares ownership of the registered series, and releases the reader with its last
+  // copy
+  return std::shared_ptr<PushSeries>(
+    series.get(), [series](PushSeries * reader) {
+      reader->remove_reader();
+    });
+}
+
+std::vector<std::string> push_series_names()
+{
+  std::unique_lock<std::mutex> lock(registry_mutex);
+  std::vector<std::string> names;
+  for (const auto & [name, _] : registry()) {
+    names.push_back(name);
+  }
+  return names;
+}
+
+} // namespace quickplot
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "quickplot/scheduler.hpp"
+
+namespace quickplot
+{
+
+// index of the worker running on this thread, so tasks spawned by a task stay on its worker
+static thread_local const TaskScheduler * current_scheduler = nullptr;
+static thread_local size_t current_worker = 0;
+
+TaskScheduler::TaskScheduler(size_t threads)
+{
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  for (size_t i = 0; i < threads; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < threads; i++) {
+    threads_.emplace_back(&TaskScheduler::run, this, i);
+  }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+  {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    running_ = false;
+  }
+  work_available_.notify_all();
+  for (auto & thread : threads_) {
+    thread.join();
+  }
+}
+
+void TaskScheduler::submit(TaskPriority priority, std::function<void()> task)
+{
+  auto index = current_scheduler == this ?
+    current_worker : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+  auto p = static_cast<size_t>(priority);
+  // count the task before it is visible in the queue, so taking it can not wrap the counters
+  ++queued_[p];
+  {
+    // increment under the idle lock, so a worker checking for work before sleeping sees it
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    ++pending_;
+  }
+  {
+    std::unique_lock<std::mutex> lock(workers_[index]->mutex);
+    workers_[index]->queues[p].push_back(std::move(task));
+  }
+  work_available_.notify_one();
+}
+
+bool TaskScheduler::reserve_background()
+{
+  // keep a worker free for ingest tasks, unless there is only one
+  auto limit = std::max<size_t>(workers_.size() - 1, 1);
+  auto running = background_running_.load();
+  while (running < limit) {
+    if (background_running_.compare_exchange_weak(running, running + 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TaskScheduler::take(size_t index, std::function<void()> & task, size_t & priority)
+{
+  for (priority = 0; priority < TASK_PRIORITY_COUNT; priority++) {
+    for (size_t offset = 0; offset < workers_.size(); offset++) {
+      auto & worker = *workers_[(index + offset) % workers_.size()];
+      std::unique_lock<std::mutex> lock(worker.mutex);
+      auto & queue = worker.queues[priority];
+      if (queue.empty()) {
+        continue;
+      }
+      if (priority > 0 && !reserve_background()) {
+        return false;
+      }
+      if (offset == 0) {
+        // own tasks are run newest first, while their data is still in the cache
+        task = std::move(queue.back());
+        queue.pop_back();
+      } else {
+        task = std::move(queue.front());
+        queue.pop_front();
+        ++steals_;
+      }
+      --queued_[priority];
+      --pending_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TaskScheduler::run(size_t index)
+{
+  current_scheduler = this;
+  current_worker = index;
+  std::function<void()> task;
+  size_t priority;
+  while (true) {
+    if (take(index, task, priority)) {
+      task();
+      task = nullptr;
+      ++executed_[priority];
+      if (priority > 0) {
+        {
+          std::unique_lock<std::mutex> lock(idle_mutex_);
+          --background_running_;
+        }
+        // a worker may wait for the background slot of this task
+        work_available_.notify_one();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    if (!running_ && pending_ == 0) {
+      // the last task may have been taken without waking the workers waiting for it
+      work_available_.notify_all();
+      break;
+    }
+    work_available_.wait(
+      lock, [this] {
+        // after shutdown, queued background tasks still wait for a free slot
+        return (!running_ && pending_ == 0) || queued_[0] > 0 ||
+        (pending_ > 0 && background_running_ < std::max<size_t>(workers_.size() - 1, 1));
+      });
+  }
+}
+
+SchedulerStats TaskScheduler::stats() const
+{
+  SchedulerStats stats {
+    .workers = workers_.size(),
+    .queued = {},
+    .executed = {},
+    .steals = steals_,
+  };
+  for (size_t i = 0; i < TASK_PRIORITY_COUNT; i++) {
+    stats.queued[i] = queued_[i];
+    stats.executed[i] = executed_[i];
+  }
+  return stats;
+}
+
+} // namespace quickplot
@@ -0,0 +1,363 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "quickplot/shared_memory.hpp"
+
+namespace quickplot
+{
+
+constexpr uint32_t SHARED_SERIES_MAGIC = 0x71706c74; // "qplt"
+constexpr uint32_t SHARED_SERIES_VERSION = 2;
+
+// number of reads between checks whether the writer of a segment is still running
+constexpr uint64_t WRITER_CHECK_INTERVAL = 64;
+
+// keep segment names well below NAME_MAX, including prefix and hash suffix
+constexpr size_t MAX_ESCAPED_ID_LENGTH = 200;
+
+SharedMemoryMode parse_shared_memory_mode(const std::string & mode)
+{
+  if (mode == "export") {
+    return SharedMemoryMode::Export;
+  } else if (mode == "import") {
+    return SharedMemoryMode::Import;
+  } else if (mode.empty() || mode == "off") {
+    return SharedMemoryMode::Off;
+  }
+  throw shared_memory_error("unknown shared memory mode '" + mode + "'");
+}
+
+std::string shared_segment_name(const std::string & series_id)
+{
+  // FNV-1a, which unlike std::hash is guaranteed to be stable across builds
+  uint64_t hash = 14695981039346656037ull;
+  std::string escaped;
+  for (char c : series_id) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+    if (escaped.size() < MAX_ESCAPED_ID_LENGTH) {
+      escaped.push_back(std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+    }
+  }
+  std::stringstream ss;
+  ss << "/quickplot" << escaped << "_" << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return ss.str();
+}
+
+static size_t segment_size(size_t capacity)
+{
+  return sizeof(SharedSeriesHeader) + capacity * sizeof(Sample);
+}
+
+static std::string errno_message(const std::string & what)
+{
+  return what + ": " + std::strerror(errno);
+}
+
+static bool process_alive(pid_t pid)
+{
+  // EPERM means the process exists, but belongs to another user
+  return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// process writing the existing segment, 0 if the segment is closed, not initialized or its writer
+// has exited
+static pid_t live_owner(const std::string & name)
+{
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedSeriesHeader)) {
+    close(fd);
+    return 0;
+  }
+  void * memory = mmap(nullptr, sizeof(SharedSeriesHeader), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    return 0;
+  }
+  auto header = static_cast<const SharedSeriesHeader *>(memory);
+  pid_t owner = 0;
+  if (header->magic == SHARED_SERIES_MAGIC && header->version == SHARED_SERIES_VERSION &&
+    !header->closed.load(std::memory_order_acquire))
+  {
+    owner = static_cast<pid_t>(header->owner_pid);
+  }
+  munmap(memory, sizeof(SharedSeriesHeader));
+  return process_alive(owner) ? owner : 0;
+}
+
+SharedSeriesWriter::SharedSeriesWriter(
+  const std::string & series_id, const std::string & topic_name,
+  size_t capacity)
+: name_(shared_segment_name(series_id)), header_(nullptr), samples_(nullptr),
+  mapped_size_(segment_size(capacity))
+{
+  if (capacity == 0) {
+    throw shared_memory_error("shared series capacity must be positive");
+  }
+  int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0 && errno == EEXIST) {
+    auto owner = live_owner(name_);
+    if (owner != 0) {
+      throw shared_memory_error(name_ + " is exported by process " + std::to_string(owner));
+    }
+    // segment left behind by a process that did not shut down cleanly
+    shm_unlink(name_.c_str());
+    fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  }
+  if (fd < 0) {
+    throw shared_memory_error(errno_message("failed to create " + name_));
+  }
+  if (ftruncate(fd, static_cast<off_t>(mapped_size_)) != 0) {
+    auto message = errno_message("failed to resize " + name_);
+    close(fd);
+    shm_unlink(name_.c_str());
+    throw shared_memory_error(message);
+  }
+  void * memory = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    auto message = errno_message("failed to map " + name_);
+    shm_unlink(name_.c_str());
+    throw shared_memory_error(message);
+  }
+
+  header_ = new (memory) SharedSeriesHeader();
+  header_->capacity = capacity;
+  header_->generation.store(0, std::memory_order_relaxed);
+  header_->cleared_at.store(0, std::memory_order_relaxed);
+  header_->written.store(0, std::memory_order_relaxed);
+  header_->closed.store(false, std::memory_order_relaxed);
+  header_->owner_pid = getpid();
+  std::strncpy(header_->topic_name, topic_name.c_str(), sizeof(header_->topic_name) - 1);
+  header_->version = SHARED_SERIES_VERSION;
+  samples_ = reinterpret_cast<Sample *>(static_cast<uint8_t *>(memory) +
+    sizeof(SharedSeriesHeader));
+  // readers verify the magic number, write it last to publish the initialized header
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = SHARED_SERIES_MAGIC;
+}
+
+SharedSeriesWriter::~SharedSeriesWriter()
+{
+  header_->closed.store(true, std::memory_order_release);
+  munmap(header_, mapped_size_);
+  shm_unlink(name_.c_str());
+}
+
+const std::string & SharedSeriesWriter::name() const
+{
+  return name_;
+}
+
+size_t SharedSeriesWriter::capacity() const
+{
+  return header_->capacity;
+}
+
+void SharedSeriesWriter::push(double x, double y)
+{
+  auto written = header_->written.load(std::memory_order_relaxed);
+  samples_[written % header_->capacity] = Sample {x, y};
+  header_->written.store(written + 1, std::memory_order_release);
+}
+
+void SharedSeriesWriter::clear()
+{
+  header_->cleared_at.store(
+    header_->written.load(std::memory_order_relaxed),
+    std::memory_order_relaxed);
+  header_->generation.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<SharedSeriesReader> SharedSeriesReader::open(const std::string & series_id)
+{
+  auto reader = std::make_shared<SharedSeriesReader>();
+  if (!reader->map(shared_segment_name(series_id))) {
+    return nullptr;
+  }
+  return reader;
+}
+
+SharedSeriesReader::SharedSeriesReader()
+: header_(nullptr), samples_(nullptr), mapped_size_(0), device_(0), inode_(0),
+  reads_since_check_(0), next_(0), generation_(0), overrun_(0)
+{
+
+}
+
+SharedSeriesReader::~SharedSeriesReader()
+{
+  unmap();
+}
+
+bool SharedSeriesReader::map(const std::string & name)
+{
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedSeriesHeader)) {
+    close(fd);
+    return false;
+  }
+  auto size = static_cast<size_t>(st.st_size);
+  void * memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    return false;
+  }
+  auto header = static_cast<const SharedSeriesHeader *>(memory);
+  if (header->magic != SHARED_SERIES_MAGIC || header->version != SHARED_SERIES_VERSION ||
+    segment_size(header->capacity) != size)
+  {
+    munmap(memory, size);
+    return false;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  unmap();
+  name_ = name;
+  header_ = header;
+  samples_ = reinterpret_cast<const Sample *>(static_cast<const uint8_t *>(memory) +
+    sizeof(SharedSeriesHeader));
+  mapped_size_ = size;
+  device_ = st.st_dev;
+  inode_ = st.st_ino;
+  reads_since_check_ = 0;
+  generation_ = header_->generation.load(std::memory_order_acquire);
+  next_ = header_->cleared_at.load(std::memory_order_relaxed);
+  return true;
+}
+
+void SharedSeriesReader::unmap()
+{
+  if (header_) {
+    munmap(const_cast<SharedSeriesHeader *>(header_), mapped_size_);
+    header_ = nullptr;
+    samples_ = nullptr;
+  }
+}
+
+bool SharedSeriesReader::writer_exited()
+{
+  if (header_->closed.load(std::memory_order_acquire)) {
+    return true;
+  }
+  // a killed writer never sets closed
+  if (++reads_since_check_ < WRITER_CHECK_INTERVAL) {
+    return false;
+  }
+  reads_since_check_ = 0;
+  return !process_alive(static_cast<pid_t>(header_->owner_pid));
+}
+
+bool SharedSeriesReader::replaced() const
+{
+  int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  bool replaced = fstat(fd, &st) == 0 && (st.st_dev != device_ || st.st_ino != inode_);
+  close(fd);
+  return replaced;
+}
+
+std::string SharedSeriesReader::topic_name() const
+{
+  return std::string(
+    header_->topic_name,
+    strnlen(header_->topic_name, sizeof(header_->topic_name)));
+}
+
+uint64_t SharedSeriesReader::overrun() const
+{
+  return overrun_;
+}
+
+bool SharedSeriesReader::cleared()
+{
+  auto generation = header_->generation.load(std::memory_order_acquire);
+  if (generation == generation_) {
+    return false;
+  }
+  generation_ = generation;
+  next_ = std::max(next_, header_->cleared_at.load(std::memory_order_relaxed));
+  return true;
+}
+
+size_t SharedSeriesReader::read(std::vector<Sample> & out)
+{
+  // the exporting process has exited; if it has been restarted, follow the new segment, otherwise
+  // keep reading what is left in the old one
+  if (writer_exited() && replaced() && !map(name_)) {
+    return 0;
+  }
+  const auto capacity = header_->capacity;
+  auto written = header_->written.load(std::memory_order_acquire);
+  if (written < next_) {
+    next_ = written;
+  }
+  auto from = std::max(next_, written > capacity ? written - capacity : 0);
+  overrun_ += from - next_;
+
+  auto offset = out.size();
+  out.resize(offset + (written - from));
+  for (auto i = from; i < written; i++) {
+    out[offset + (i - from)] = samples_[i % capacity];
+  }
+
+  // samples below written_after + 1 - capacity may have been overwritten while copying, the
+  // writer overwrites slot of sample i - capacity before publishing sample i
+  std::atomic_thread_fence(std::memory_order_acquire);
+  auto written_after = header_->written.load(std::memory_order_relaxed);
+  auto valid_from = written_after + 1 > capacity ? written_after + 1 - capacity : 0;
+  if (valid_from > from) {
+    auto torn = std::min(valid_from - from, written - from);
+    out.erase(
+      out.begin() + static_cast<std::ptrdiff_t>(offset),
+      out.begin() + static_cast<std::ptrdiff_t>(offset + torn));
+    overrun_ += torn;
+  }
+  next_ = written;
+  return out.size() - offset;
+}
+
+SharedSeriesStore::SharedSeriesStore(size_t capacity)
+: capacity_(capacity)
+{
+
+}
+
+std::shared_ptr<SharedSeriesWriter> SharedSeriesStore::export_series(
+  const std::string & series_id,
+  const std::string & topic_name)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = writers_.find(series_id);
+  if (it != writers_.end() && !it->second.expired()) {
+    return nullptr;
+  }
+  auto writer = std::make_shared<SharedSeriesWriter>(series_id, topic_name, capacity_);
+  writers_[series_id] = writer;
+  return writer;
+}
+
+} // namespace quickplot
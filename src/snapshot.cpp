@@ -0,0 +1,198 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "quickplot/config.hpp"
+#include "quickplot/snapshot.hpp"
+
+namespace quickplot
+{
+
+constexpr char SNAPSHOT_MAGIC[8] = {'q', 'p', 'l', 't', 's', 'n', 'a', 'p'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+// file layout: header, one entry per series, series ids, padding, samples of all series
+struct SnapshotHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t series_count;
+};
+
+struct SnapshotEntry
+{
+  uint64_t id_offset;
+  uint64_t id_size;
+  uint64_t samples_offset;
+  uint64_t sample_count;
+};
+
+fs::path get_default_snapshot_path()
+{
+  return get_default_config_directory().append("history.snapshot");
+}
+
+static size_t align_up(size_t offset, size_t alignment)
+{
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// write size bytes, retrying partial writes
+static bool write_all(int fd, const void * data, size_t size)
+{
+  auto bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    auto n = ::write(fd, bytes, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+void write_snapshot(const fs::path & path, const std::vector<SnapshotSeries> & series)
+{
+  SnapshotHeader header;
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.series_count = static_cast<uint32_t>(series.size());
+
+  std::vector<SnapshotEntry> entries(series.size());
+  size_t offset = sizeof(SnapshotHeader) + series.size() * sizeof(SnapshotEntry);
+  for (size_t i = 0; i < series.size(); i++) {
+    entries[i].id_offset = offset;
+    entries[i].id_size = series[i].id.size();
+    offset += series[i].id.size();
+  }
+  size_t ids_end = offset;
+  offset = align_up(offset, alignof(Sample));
+  for (size_t i = 0; i < series.size(); i++) {
+    entries[i].samples_offset = offset;
+    entries[i].sample_count = series[i].samples.size();
+    offset += series[i].samples.size() * sizeof(Sample);
+  }
+
+  // a unique temporary file, so processes saving to the same path do not write into each other's
+  // file before it is renamed
+  auto tmp_template = path.string() + ".tmp." + std::to_string(getpid()) + ".XXXXXX";
+  std::vector<char> tmp_path(tmp_template.begin(), tmp_template.end());
+  tmp_path.push_back('\0');
+  int fd = mkstemp(tmp_path.data());
+  if (fd < 0) {
+    throw snapshot_error("failed to create " + tmp_template + ": " + std::strerror(errno));
+  }
+  std::vector<char> padding(align_up(ids_end, alignof(Sample)) - ids_end, 0);
+  bool written = write_all(fd, &header, sizeof(header)) &&
+    write_all(fd, entries.data(), entries.size() * sizeof(SnapshotEntry));
+  for (size_t i = 0; written && i < series.size(); i++) {
+    written = write_all(fd, series[i].id.data(), series[i].id.size());
+  }
+  written = written && write_all(fd, padding.data(), padding.size());
+  for (size_t i = 0; written && i < series.size(); i++) {
+    written = write_all(
+      fd, series[i].samples.data(), series[i].samples.size() * sizeof(Sample));
+  }
+  // the data must be on disk before the rename is, so a power loss does not leave an empty file
+  written = written && ::fsync(fd) == 0;
+  written = ::close(fd) == 0 && written;
+  if (!written) {
+    ::unlink(tmp_path.data());
+    throw snapshot_error(std::string("failed to write ") + tmp_path.data());
+  }
+  if (::rename(tmp_path.data(), path.c_str()) != 0) {
+    auto error = std::strerror(errno);
+    ::unlink(tmp_path.data());
+    throw snapshot_error("failed to replace " + path.string() + ": " + error);
+  }
+  // persist the rename; if this fails, the previous or the new snapshot is kept
+  int dir_fd = ::open(path.parent_path().empty() ? "." : path.parent_path().c_str(), O_RDONLY);
+  if (dir_fd >= 0) {
+    ::fsync(dir_fd);
+    ::close(dir_fd);
+  }
+}
+
+Snapshot::Snapshot(void * data, size_t size)
+: data_(data), size_(size)
+{
+
+}
+
+std::unique_ptr<Snapshot> Snapshot::open(const fs::path & path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+    close(fd);
+    return nullptr;
+  }
+  auto size = static_cast<size_t>(st.st_size);
+  void * data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  // private constructor
+  std::unique_ptr<Snapshot> snapshot(new Snapshot(data, size));
+
+  auto bytes = static_cast<const char *>(data);
+  const auto * header = reinterpret_cast<const SnapshotHeader *>(bytes);
+  if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+    header->version != SNAPSHOT_VERSION ||
+    header->series_count > (size - sizeof(SnapshotHeader)) / sizeof(SnapshotEntry))
+  {
+    return nullptr;
+  }
+  const auto * entries = reinterpret_cast<const SnapshotEntry *>(bytes + sizeof(SnapshotHeader));
+  for (size_t i = 0; i < header->series_count; i++) {
+    const auto & entry = entries[i];
+    // a truncated or corrupt file invalidates the whole snapshot
+    if (entry.id_offset > size || entry.id_size > size - entry.id_offset ||
+      entry.samples_offset > size || entry.samples_offset % alignof(Sample) != 0 ||
+      entry.sample_count > (size - entry.samples_offset) / sizeof(Sample))
+    {
+      return nullptr;
+    }
+    snapshot->index_.emplace(
+      std::string(bytes + entry.id_offset, entry.id_size),
+      std::make_pair(
+        reinterpret_cast<const Sample *>(bytes + entry.samples_offset),
+        entry.sample_count));
+  }
+  return snapshot;
+}
+
+Snapshot::~Snapshot()
+{
+  munmap(data_, size_);
+}
+
+std::pair<const Sample *, size_t> Snapshot::find(const std::string & id) const
+{
+  auto it = index_.find(id);
+  if (it == index_.end()) {
+    return {nullptr, 0};
+  }
+  return it->second;
+}
+
+size_t Snapshot::series_count() const
+{
+  return index_.size();
+}
+
+} // namespace quickplot
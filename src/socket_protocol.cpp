@@ -0,0 +1,134 @@
+#include <yaml-cpp/yaml.h>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include "quickplot/socket_protocol.hpp"
+
+namespace quickplot
+{
+
+SocketEndpoint parse_socket_endpoint(const std::string & endpoint)
+{
+  auto colon = endpoint.find(':');
+  if (colon != std::string::npos) {
+    auto scheme = endpoint.substr(0, colon);
+    auto address = endpoint.substr(colon + 1);
+    if (scheme == "udp") {
+      unsigned int port;
+      auto result = std::from_chars(address.data(), address.data() + address.size(), port);
+      if (result.ec == std::errc() && result.ptr == address.data() + address.size() &&
+        port > 0 && port <= std::numeric_limits<uint16_t>::max())
+      {
+        return SocketEndpoint {
+          .type = SocketType::Udp,
+          .port = static_cast<uint16_t>(port),
+          .path = "",
+        };
+      }
+    } else if (scheme == "unix" && !address.empty()) {
+      return SocketEndpoint {
+        .type = SocketType::Unix,
+        .port = 0,
+        .path = address,
+      };
+    }
+  }
+  throw socket_error(
+          "invalid socket endpoint '" + endpoint + "', expected 'udp:<port>' or 'unix:<path>'");
+}
+
+static bool decode_binary(
+  const char * data, size_t size, double receive_time, SocketDatagram & out)
+{
+  uint32_t magic;
+  uint16_t name_length, count;
+  std::memcpy(&magic, data, sizeof(magic));
+  std::memcpy(&name_length, data + 4, sizeof(name_length));
+  std::memcpy(&count, data + 6, sizeof(count));
+  if (magic != SOCKET_DATAGRAM_MAGIC || name_length == 0 ||
+    size != SOCKET_DATAGRAM_HEADER_SIZE + name_length + count * sizeof(Sample))
+  {
+    return false;
+  }
+  out.channel.assign(data + SOCKET_DATAGRAM_HEADER_SIZE, name_length);
+  out.samples.resize(count);
+  // samples follow the name unaligned
+  std::memcpy(
+    out.samples.data(), data + SOCKET_DATAGRAM_HEADER_SIZE + name_length,
+    count * sizeof(Sample));
+  for (auto & sample : out.samples) {
+    if (std::isnan(sample.x)) {
+      sample.x = receive_time;
+    }
+  }
+  return true;
+}
+
+static bool decode_json(
+  const char * data, size_t size, double receive_time, SocketDatagram & out)
+{
+  // JSON is a subset of YAML flow style, so the config parser reads it
+  try {
+    auto node = YAML::Load(std::string(data, size));
+    if (!node.IsMap() || !node["channel"].IsScalar()) {
+      return false;
+    }
+    out.channel = node["channel"].as<std::string>();
+    out.samples.clear();
+    if (node["samples"].IsSequence()) {
+      for (const auto & sample : node["samples"]) {
+        if (!sample.IsSequence() || sample.size() != 2) {
+          return false;
+        }
+        out.samples.push_back({sample[0].as<double>(), sample[1].as<double>()});
+      }
+    } else if (node["value"].IsScalar()) {
+      auto t = node["t"].IsScalar() ? node["t"].as<double>() : receive_time;
+      out.samples.push_back({t, node["value"].as<double>()});
+    } else {
+      return false;
+    }
+    return !out.channel.empty();
+  } catch (const YAML::Exception &) {
+    return false;
+  }
+}
+
+bool decode_socket_datagram(
+  const char * data, size_t size, double receive_time, SocketDatagram & out)
+{
+  if (size > 0 && data[0] == '{') {
+    return decode_json(data, size, receive_time, out);
+  }
+  if (size < SOCKET_DATAGRAM_HEADER_SIZE) {
+    return false;
+  }
+  return decode_binary(data, size, receive_time, out);
+}
+
+std::string encode_socket_datagram(
+  const std::string & channel, const std::vector<Sample> & samples)
+{
+  if (channel.empty() || channel.size() > std::numeric_limits<uint16_t>::max() ||
+    samples.size() > std::numeric_limits<uint16_t>::max())
+  {
+    throw socket_error("channel name or sample count out of range");
+  }
+  auto name_length = static_cast<uint16_t>(channel.size());
+  auto count = static_cast<uint16_t>(samples.size());
+  std::string datagram(
+    SOCKET_DATAGRAM_HEADER_SIZE + name_length + count * sizeof(Sample), '\0');
+  std::memcpy(&datagram[0], &SOCKET_DATAGRAM_MAGIC, sizeof(SOCKET_DATAGRAM_MAGIC));
+  std::memcpy(&datagram[4], &name_length, sizeof(name_length));
+  std::memcpy(&datagram[6], &count, sizeof(count));
+  std::memcpy(&datagram[SOCKET_DATAGRAM_HEADER_SIZE], channel.data(), name_length);
+  std::memcpy(
+    &datagram[SOCKET_DATAGRAM_HEADER_SIZE + name_length], samples.data(),
+    count * sizeof(Sample));
+  return datagram;
+}
+
+} // namespace quickplot
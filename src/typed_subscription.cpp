@@ -0,0 +1,102 @@
+#include <std_msgs/msg/float32.hpp>
+#include <std_msgs/msg/float64.hpp>
+#include <std_msgs/msg/int32.hpp>
+#include <std_msgs/msg/int64.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include <geometry_msgs/msg/vector3.hpp>
+#include <geometry_msgs/msg/vector3_stamped.hpp>
+#include <sensor_msgs/msg/imu.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "quickplot/typed_subscription.hpp"
+
+namespace quickplot
+{
+
+using geometry_msgs::msg::Quaternion;
+using geometry_msgs::msg::Twist;
+using geometry_msgs::msg::TwistStamped;
+using geometry_msgs::msg::Vector3;
+using geometry_msgs::msg::Vector3Stamped;
+using sensor_msgs::msg::Imu;
+
+// register the x, y and z fields of a Vector3 reached by the Prefix member chain
+template<auto ... Prefix, typename MessageT>
+void add_vector3_fields(TypedMessageSupportBuilder<MessageT> & builder, const std::string & prefix)
+{
+  builder.template field<Prefix..., &Vector3::x>(prefix + ".x");
+  builder.template field<Prefix..., &Vector3::y>(prefix + ".y");
+  builder.template field<Prefix..., &Vector3::z>(prefix + ".z");
+}
+
+template<typename MessageT>
+TypedMessageSupport scalar_support()
+{
+  return TypedMessageSupportBuilder<MessageT>().template field<&MessageT::data>("data").build();
+}
+
+static std::unordered_map<std::string, TypedMessageSupport> create_registry()
+{
+  std::unordered_map<std::string, TypedMessageSupport> registry;
+  registry.emplace("std_msgs/msg/Float32", scalar_support<std_msgs::msg::Float32>());
+  registry.emplace("std_msgs/msg/Float64", scalar_support<std_msgs::msg::Float64>());
+  registry.emplace("std_msgs/msg/Int32", scalar_support<std_msgs::msg::Int32>());
+  registry.emplace("std_msgs/msg/Int64", scalar_support<std_msgs::msg::Int64>());
+
+  TypedMessageSupportBuilder<Vector3> vector3;
+  vector3.field<&Vector3::x>("x").field<&Vector3::y>("y").field<&Vector3::z>("z");
+  registry.emplace("geometry_msgs/msg/Vector3", vector3.build());
+
+  TypedMessageSupportBuilder<Vector3Stamped> vector3_stamped;
+  add_vector3_fields<&Vector3Stamped::vector>(vector3_stamped, "vector");
+  registry.emplace("geometry_msgs/msg/Vector3Stamped", vector3_stamped.build());
+
+  TypedMessageSupportBuilder<Twist> twist;
+  add_vector3_fields<&Twist::linear>(twist, "linear");
+  add_vector3_fields<&Twist::angular>(twist, "angular");
+  registry.emplace("geometry_msgs/msg/Twist", twist.build());
+
+  TypedMessageSupportBuilder<TwistStamped> twist_stamped;
+  add_vector3_fields<&TwistStamped::twist, &Twist::linear>(twist_stamped, "twist.linear");
+  add_vector3_fields<&TwistStamped::twist, &Twist::angular>(twist_stamped, "twist.angular");
+  registry.emplace("geometry_msgs/msg/TwistStamped", twist_stamped.build());
+
+  TypedMessageSupportBuilder<Imu> imu;
+  imu.field<&Imu::orientation, &Quaternion::x>("orientation.x")
+  .field<&Imu::orientation, &Quaternion::y>("orientation.y")
+  .field<&Imu::orientation, &Quaternion::z>("orientation.z")
+  .field<&Imu::orientation, &Quaternion::w>("orientation.w");
+  add_vector3_fields<&Imu::angular_velocity>(imu, "angular_velocity");
+  add_vector3_fields<&Imu::linear_acceleration>(imu, "linear_acceleration");
+  registry.emplace("sensor_msgs/msg/Imu", imu.build());
+  return registry;
+}
+
+const std::unordered_map<std::string, TypedMessageSupport> & typed_message_registry()
+{
+  static const auto registry = create_registry();
+  return registry;
+}
+
+std::vector<std::string> typed_message_types()
+{
+  std::vector<std::string> types;
+  for (const auto & [type, _] : typed_message_registry()) {
+    types.push_back(type);
+  }
+  return types;
+}
+
+const TypedMessageSupport * find_typed_message_support(const std::string & message_type)
+{
+  const auto & registry = typed_message_registry();
+  auto it = registry.find(message_type);
+  if (it == registry.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+} // namespace quickplot
@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "quickplot/application.hpp"
+#include "quickplot/config.hpp"
+
+// load, apply and save of generated configs with many series on few topics
+
+namespace fs = std::filesystem;
+
+// count series over topics with 100 joints each
+static quickplot::ApplicationConfig generate_config(size_t count)
+{
+  quickplot::ApplicationConfig config {
+    .history_length = 10.0,
+    .plots = {},
+  };
+  constexpr size_t SERIES_PER_PLOT = 50;
+  for (size_t i = 0; i < count; i++) {
+    if (i % SERIES_PER_PLOT == 0) {
+      auto & plot = config.plots.emplace_back();
+      plot.axes = {quickplot::AxisConfig {.y_min = -1.0, .y_max = 1.0}};
+    }
+    quickplot::TimeSeriesConfig series;
+    series.source.topic_name = "/robot" + std::to_string(i / 100) + "/joint_states";
+    series.source.member_path = {{"position", i % 100}};
+    series.source.op = quickplot::DataSourceOperator::Identity;
+    series.axis = 0;
+    config.plots.back().series.push_back(series);
+  }
+  return config;
+}
+
+static fs::path config_path(size_t count)
+{
+  return fs::temp_directory_path() / ("quickplot_benchmark_" + std::to_string(count) + ".yaml");
+}
+
+static void load_config(benchmark::State & state)
+{
+  auto count = static_cast<size_t>(state.range(0));
+  auto path = config_path(count);
+  quickplot::save_config(generate_config(count), path);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(quickplot::load_config(path));
+  }
+  fs::remove(path);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(load_config)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+static void save_config(benchmark::State & state)
+{
+  auto count = static_cast<size_t>(state.range(0));
+  auto path = config_path(count);
+  auto config = generate_config(count);
+  for (auto _ : state) {
+    quickplot::save_config(config, path);
+  }
+  fs::remove(path);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(save_config)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// reapply a config with one changed series, without topics available, so that the series stay
+// uninitialized and only the config diff is measured
+static void apply_config(benchmark::State & state)
+{
+  if (!rclcpp::ok()) {
+    rclcpp::init(0, nullptr);
+  }
+  auto count = static_cast<size_t>(state.range(0));
+  auto config = generate_config(count);
+  auto changed = config;
+  changed.plots[0].series[0].source.op = quickplot::DataSourceOperator::Sqrt;
+  quickplot::Application app(std::make_shared<quickplot::QuickPlotNode>());
+  app.apply_config(config);
+  bool toggle = false;
+  for (auto _ : state) {
+    app.apply_config((toggle = !toggle) ? changed : config);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(apply_config)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,171 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include "quickplot/plot_subscription.hpp"
+
+// ingest throughput and allocations without a middleware, from pre-serialized messages on a
+// fake clock
+
+using geometry_msgs::msg::TwistStamped;
+
+static std::atomic<size_t> allocations {0};
+
+void * operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+static std::vector<rclcpp::SerializedMessage> twist_stream(size_t count)
+{
+  rclcpp::Serialization<TwistStamped> serializer;
+  std::vector<rclcpp::SerializedMessage> stream(count);
+  for (size_t i = 0; i < count; i++) {
+    TwistStamped msg;
+    msg.header.stamp = rclcpp::Time(static_cast<int64_t>(i * 1000000), RCL_ROS_TIME);
+    msg.twist.linear.x = static_cast<double>(i);
+    serializer.serialize_message(&msg, &stream[i]);
+  }
+  return stream;
+}
+
+struct IngestFixture
+{
+  std::shared_ptr<quickplot::FakeIngestClock> clock;
+  std::unique_ptr<quickplot::IngestCore> core;
+  std::vector<std::shared_ptr<quickplot::PlotDataBuffer>> buffers;
+
+  // plot the first sources members of the twist of every message
+  explicit IngestFixture(size_t sources)
+  : clock(std::make_shared<quickplot::FakeIngestClock>())
+  {
+    auto introspection = std::make_shared<quickplot::MessageIntrospection>(
+      "geometry_msgs/msg/TwistStamped");
+    core = std::make_unique<quickplot::IngestCore>(
+      std::make_shared<quickplot::IntrospectionMessageDeserializer>(introspection), clock);
+    const char * fields[] = {"x", "y", "z"};
+    for (size_t i = 0; i < sources; i++) {
+      auto member = introspection->get_member_sequence_path(
+        {{"twist", std::nullopt}, {i < 3 ? "linear" : "angular", std::nullopt},
+          {fields[i % 3], std::nullopt}}).value();
+      buffers.push_back(
+        core->add_source(
+          quickplot::MessageAccessor {
+            .member = member,
+            .op = quickplot::DataSourceOperator::Identity,
+          }, nullptr));
+    }
+  }
+};
+
+constexpr size_t STREAM_LENGTH = 1000;
+
+// one message per callback, as received from an executor
+static void ingest_serialized(benchmark::State & state)
+{
+  IngestFixture fixture(static_cast<size_t>(state.range(0)));
+  auto stream = twist_stream(STREAM_LENGTH);
+  size_t messages = 0;
+  auto allocations_before = allocations.load();
+  for (auto _ : state) {
+    for (const auto & message : stream) {
+      fixture.core->receive_serialized(message);
+      fixture.clock->advance(std::chrono::milliseconds(1));
+    }
+    messages += stream.size();
+    state.PauseTiming();
+    for (auto & buffer : fixture.buffers) {
+      buffer->clear();
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(messages));
+  state.counters["allocs_per_msg"] =
+    static_cast<double>(allocations.load() - allocations_before) / messages;
+}
+BENCHMARK(ingest_serialized)->Arg(1)->Arg(6);
+
+// batches of messages taken at once, as in the wait set ingest mode
+static void ingest_batch(benchmark::State & state)
+{
+  IngestFixture fixture(6);
+  auto stream = twist_stream(STREAM_LENGTH);
+  auto batch_size = static_cast<size_t>(state.range(0));
+  size_t messages = 0;
+  auto allocations_before = allocations.load();
+  for (auto _ : state) {
+    size_t next = 0;
+    while (next < stream.size()) {
+      fixture.core->receive_batch(
+        [&](rclcpp::SerializedMessage & message) {
+          if (next == stream.size()) {
+            return false;
+          }
+          // copying models the take from the middleware
+          message = stream[next++];
+          return true;
+        }, batch_size);
+      fixture.clock->advance(std::chrono::milliseconds(1));
+    }
+    messages += stream.size();
+    state.PauseTiming();
+    for (auto & buffer : fixture.buffers) {
+      buffer->clear();
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(messages));
+  state.counters["allocs_per_msg"] =
+    static_cast<double>(allocations.load() - allocations_before) / messages;
+}
+BENCHMARK(ingest_batch)->Arg(10)->Arg(1000);
+
+// messages deserialized by several workers of a pipeline, committed in arrival order
+static void ingest_pipelined(benchmark::State & state)
+{
+  IngestFixture fixture(6);
+  auto stream = twist_stream(STREAM_LENGTH);
+  std::vector<std::shared_ptr<rclcpp::SerializedMessage>> messages;
+  for (const auto & message : stream) {
+    messages.push_back(std::make_shared<rclcpp::SerializedMessage>(message));
+  }
+  auto introspection = std::make_shared<quickplot::MessageIntrospection>(
+    "geometry_msgs/msg/TwistStamped");
+  quickplot::IngestPipeline pipeline(
+    *fixture.core, std::make_shared<quickplot::IntrospectionMessageDeserializer>(introspection),
+    std::make_shared<quickplot::TaskScheduler>(), static_cast<size_t>(state.range(0)));
+  size_t taken = 0;
+  for (auto _ : state) {
+    for (const auto & message : messages) {
+      pipeline.submit(message);
+    }
+    pipeline.flush();
+    taken += messages.size();
+    state.PauseTiming();
+    for (auto & buffer : fixture.buffers) {
+      buffer->clear();
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(taken));
+  state.counters["out_of_order"] = static_cast<double>(pipeline.out_of_order()) / taken;
+}
+BENCHMARK(ingest_pipelined)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
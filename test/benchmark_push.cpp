@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "quickplot/push.hpp"
+
+// all benchmark threads push to one series, which is drained by thread 0 as a plot would
+static std::shared_ptr<quickplot::PushSeries> shared_series()
+{
+  static auto series = [] {
+      auto series = std::make_shared<quickplot::PushSeries>("benchmark", 1 << 24);
+      series->add_reader();
+      return series;
+    }();
+  return series;
+}
+
+static void drain(benchmark::State & state, quickplot::PushSeries & series, size_t iteration)
+{
+  static std::vector<quickplot::Sample> out;
+  if (state.thread_index() == 0 && iteration % 64 == 0) {
+    out.clear();
+    series.drain(out);
+  }
+}
+
+static void push_single(benchmark::State & state)
+{
+  auto series = shared_series();
+  size_t i = 0;
+  for (auto _ : state) {
+    series->push(static_cast<double>(i), 1.0);
+    drain(state, *series, i++);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(push_single)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+static void push_batch(benchmark::State & state)
+{
+  auto series = shared_series();
+  auto batch_size = static_cast<size_t>(state.range(0));
+  std::vector<quickplot::Sample> samples(batch_size, quickplot::Sample {0.0, 1.0});
+  size_t i = 0;
+  for (auto _ : state) {
+    for (size_t j = 0; j < batch_size; j++) {
+      samples[j].x = static_cast<double>(i * batch_size + j);
+    }
+    series->push_batch(samples.data(), samples.size());
+    drain(state, *series, i++);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(push_batch)->Arg(100)->Arg(1000)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+BENCHMARK_MAIN();
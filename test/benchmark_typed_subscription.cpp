@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include "quickplot/introspection.hpp"
+#include "quickplot/message_parser.hpp"
+#include "quickplot/typed_subscription.hpp"
+
+using geometry_msgs::msg::TwistStamped;
+
+static rclcpp::SerializedMessage serialized_twist_stamped()
+{
+  TwistStamped msg;
+  msg.twist.linear.x = 1.0;
+  rclcpp::Serialization<TwistStamped> serializer;
+  rclcpp::SerializedMessage serialized_msg;
+  serializer.serialize_message(&msg, &serialized_msg);
+  return serialized_msg;
+}
+
+// deserialize through the introspection buffer and walk the member path, as done for
+// GenericSubscription
+static void generic_deserialize_and_extract(benchmark::State & state)
+{
+  auto introspection = std::make_shared<quickplot::MessageIntrospection>(
+    "geometry_msgs/msg/TwistStamped");
+  quickplot::IntrospectionMessageDeserializer deserializer(introspection);
+  auto member = introspection->get_member_sequence_path(
+    {{"twist", std::nullopt}, {"linear", std::nullopt}, {"x", std::nullopt}}).value();
+  auto serialized_msg = serialized_twist_stamped();
+  auto buffer = deserializer.init_buffer();
+  for (auto _ : state) {
+    deserializer.deserialize(serialized_msg, buffer.data());
+    benchmark::DoNotOptimize(quickplot::get_numeric(buffer.data(), member));
+  }
+  deserializer.fini_buffer(buffer);
+}
+BENCHMARK(generic_deserialize_and_extract);
+
+// deserialize into the typed message, which is what rmw does for typed subscriptions, and load
+// the field directly
+static void typed_deserialize_and_extract(benchmark::State & state)
+{
+  auto getter = quickplot::find_typed_message_support("geometry_msgs/msg/TwistStamped")
+    ->find_field("twist.linear.x");
+  auto serialized_msg = serialized_twist_stamped();
+  rclcpp::Serialization<TwistStamped> serializer;
+  TwistStamped msg;
+  for (auto _ : state) {
+    serializer.deserialize_message(&serialized_msg, &msg);
+    benchmark::DoNotOptimize(getter(&msg));
+  }
+}
+BENCHMARK(typed_deserialize_and_extract);
+
+static void generic_extract(benchmark::State & state)
+{
+  auto introspection = std::make_shared<quickplot::MessageIntrospection>(
+    "geometry_msgs/msg/TwistStamped");
+  auto member = introspection->get_member_sequence_path(
+    {{"twist", std::nullopt}, {"linear", std::nullopt}, {"x", std::nullopt}}).value();
+  TwistStamped msg;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(quickplot::get_numeric(&msg, member));
+  }
+}
+BENCHMARK(generic_extract);
+
+// with intra-process communication, the typed path skips deserialization entirely
+static void typed_extract(benchmark::State & state)
+{
+  auto getter = quickplot::find_typed_message_support("geometry_msgs/msg/TwistStamped")
+    ->find_field("twist.linear.x");
+  TwistStamped msg;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(getter(&msg));
+  }
+}
+BENCHMARK(typed_extract);
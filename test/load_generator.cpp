@@ -0,0 +1,227 @@
+// Publishes synthetic load on many topics, to measure ingest capacity and loss of quickplot.
+//
+// ros2 run quickplot load_generator --ros-args -p topic_count:=100 -p rate:=1000.0
+//
+// Every message carries a sequence number per topic, so lost messages can be counted from the
+// plotted values as well as from the header stamp gaps quickplot detects. The publish schedule
+// is fixed by the parameters, so runs with equal parameters produce the same load.
+
+#include <rclcpp/rclcpp.hpp>
+#include <std_msgs/msg/float64.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include <sensor_msgs/msg/joint_state.hpp>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+// scalar message; the value is the sequence number
+void fill(std_msgs::msg::Float64 & msg, uint64_t seq, const rclcpp::Time &, size_t)
+{
+  msg.data = static_cast<double>(seq);
+}
+
+// nested message with header; linear.x is the sequence number
+void fill(geometry_msgs::msg::TwistStamped & msg, uint64_t seq, const rclcpp::Time & t, size_t)
+{
+  msg.header.stamp = t;
+  msg.twist.linear.x = static_cast<double>(seq);
+  msg.twist.angular.z = std::sin(t.seconds());
+}
+
+// message with large sequences; position[0] is the sequence number
+void fill(sensor_msgs::msg::JointState & msg, uint64_t seq, const rclcpp::Time & t, size_t length)
+{
+  msg.header.stamp = t;
+  if (msg.name.size() != length) {
+    msg.name.resize(length);
+    for (size_t i = 0; i < length; i++) {
+      msg.name[i] = "joint" + std::to_string(i);
+    }
+    msg.position.resize(length);
+    msg.velocity.resize(length);
+    msg.effort.resize(length);
+  }
+  auto s = std::sin(t.seconds());
+  for (size_t i = 0; i < length; i++) {
+    msg.position[i] = s;
+    msg.velocity[i] = s * i;
+  }
+  msg.position[0] = static_cast<double>(seq);
+}
+
+// publishes the next message of one topic
+using PublishFunction = std::function<void (uint64_t seq, const rclcpp::Time & t)>;
+
+template<typename MessageT>
+PublishFunction make_publisher(
+  rclcpp::Node & node, const std::string & topic, const rclcpp::QoS & qos,
+  size_t sequence_length)
+{
+  auto publisher = node.create_publisher<MessageT>(topic, qos);
+  auto msg = std::make_shared<MessageT>();
+  return [publisher, msg, sequence_length](uint64_t seq, const rclcpp::Time & t) {
+           fill(*msg, seq, t, sequence_length);
+           publisher->publish(*msg);
+         };
+}
+
+}  // namespace
+
+class LoadGenerator : public rclcpp::Node
+{
+private:
+  std::vector<PublishFunction> publishers_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> running_;
+  std::atomic<uint64_t> published_;
+  // publish loops which did not reach the end of the duration yet
+  std::atomic<size_t> active_loops_;
+
+  double rate_;
+  size_t burst_size_;
+  double duration_;
+
+  // publish to the topics i with i % stride == offset, on a fixed schedule
+  void publish_loop(size_t offset, size_t stride)
+  {
+    // each burst publishes burst_size messages on every topic, spaced to keep the average rate
+    auto burst_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(burst_size_ / rate_));
+    auto start = std::chrono::steady_clock::now();
+    auto next_burst = start;
+    uint64_t seq = 0;
+    while (running_ && rclcpp::ok()) {
+      if (duration_ > 0.0 && std::chrono::steady_clock::now() - start >
+        std::chrono::duration<double>(duration_))
+      {
+        break;
+      }
+      for (size_t b = 0; b < burst_size_; b++, seq++) {
+        auto t = now();
+        for (size_t i = offset; i < publishers_.size(); i += stride) {
+          publishers_[i](seq, t);
+        }
+      }
+      published_ += burst_size_ * ((publishers_.size() - offset + stride - 1) / stride);
+      next_burst += burst_period;
+      // if publishing cannot keep up, continue without sleeping rather than skipping messages
+      std::this_thread::sleep_until(next_burst);
+    }
+    active_loops_--;
+  }
+
+public:
+  LoadGenerator()
+  : Node("quickplot_load_generator"), running_(true), published_(0), active_loops_(0)
+  {
+    auto topic_count = declare_parameter<int64_t>("topic_count", 10);
+    // 'scalar' (std_msgs/Float64), 'nested' (geometry_msgs/TwistStamped) or
+    // 'sequence' (sensor_msgs/JointState)
+    auto message_type = declare_parameter<std::string>("message_type", "nested");
+    // number of joints of 'sequence' messages
+    auto sequence_length = declare_parameter<int64_t>("sequence_length", 100);
+    // messages per second per topic
+    rate_ = declare_parameter<double>("rate", 100.0);
+    // messages published back to back per topic, before pausing to keep the average rate
+    burst_size_ = static_cast<size_t>(declare_parameter<int64_t>("burst_size", 1));
+    // seconds to publish, 0 to publish until shutdown
+    duration_ = declare_parameter<double>("duration", 0.0);
+    auto threads = declare_parameter<int64_t>("threads", 1);
+    auto topic_prefix = declare_parameter<std::string>("topic_prefix", "/load");
+    auto depth = declare_parameter<int64_t>("qos_depth", 10);
+    auto reliable = declare_parameter<bool>("reliable", false);
+
+    if (topic_count < 1 || rate_ <= 0.0 || burst_size_ < 1 || threads < 1 || depth < 1 ||
+      sequence_length < 1)
+    {
+      throw std::invalid_argument(
+              "topic_count, rate, burst_size, threads, qos_depth and sequence_length must be "
+              "positive");
+    }
+
+    rclcpp::QoS qos(static_cast<size_t>(depth));
+    if (reliable) {
+      qos.reliable();
+    } else {
+      qos.best_effort();
+    }
+    for (int64_t i = 0; i < topic_count; i++) {
+      auto topic = topic_prefix + "/topic_" + std::to_string(i);
+      auto length = static_cast<size_t>(sequence_length);
+      if (message_type == "scalar") {
+        publishers_.push_back(make_publisher<std_msgs::msg::Float64>(*this, topic, qos, length));
+      } else if (message_type == "nested") {
+        publishers_.push_back(
+          make_publisher<geometry_msgs::msg::TwistStamped>(*this, topic, qos, length));
+      } else if (message_type == "sequence") {
+        publishers_.push_back(
+          make_publisher<sensor_msgs::msg::JointState>(*this, topic, qos, length));
+      } else {
+        throw std::invalid_argument("unknown message_type '" + message_type + "'");
+      }
+    }
+
+    std::cout << "Publishing " << message_type << " messages on " << topic_count <<
+      " topics at " << rate_ << " Hz in bursts of " << burst_size_ << std::endl;
+    auto stride = static_cast<size_t>(std::min(threads, topic_count));
+    active_loops_ = stride;
+    for (size_t offset = 0; offset < stride; offset++) {
+      threads_.emplace_back(&LoadGenerator::publish_loop, this, offset, stride);
+    }
+  }
+
+  ~LoadGenerator()
+  {
+    running_ = false;
+    for (auto & thread : threads_) {
+      thread.join();
+    }
+  }
+
+  uint64_t published() const
+  {
+    return published_;
+  }
+
+  // whether all publish loops stopped at the end of the duration
+  bool finished() const
+  {
+    return active_loops_ == 0;
+  }
+};
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  auto node = std::make_shared<LoadGenerator>();
+  // report the achieved publish rate once per second, and exit once the duration elapsed
+  auto last_published = node->published();
+  auto timer = node->create_wall_timer(
+    1s, [&node, &last_published] {
+      auto finished = node->finished();
+      auto published = node->published();
+      std::cout << published - last_published << " msgs/s" << std::endl;
+      last_published = published;
+      if (finished) {
+        std::cout << "Published " << published << " messages" << std::endl;
+        rclcpp::shutdown();
+      }
+    });
+  rclcpp::spin(node);
+  if (rclcpp::ok()) {
+    rclcpp::shutdown();
+  }
+  return 0;
+}
@@ -0,0 +1,30 @@
+#!/usr/bin/python3
+import math
+import socket
+import struct
+import sys
+import time
+
+# sends a sine on channel 'sine' to a quickplot launched with -p socket:=udp:9870, in binary
+# datagrams of 100 samples, and its amplitude as JSON
+
+
+def binary_datagram(channel, samples):
+    name = channel.encode()
+    header = struct.pack('=IHH', 0x6b737071, len(name), len(samples))
+    return header + name + b''.join(struct.pack('=dd', t, v) for t, v in samples)
+
+
+def main(args=sys.argv):
+    port = int(args[1]) if len(args) > 1 else 9870
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    while True:
+        now = time.time()
+        samples = [(now + i * 1e-4, math.sin(2 * math.pi * (now + i * 1e-4))) for i in range(100)]
+        sock.sendto(binary_datagram('sine', samples), ('127.0.0.1', port))
+        sock.sendto(b'{"channel": "amplitude", "value": 1.0}', ('127.0.0.1', port))
+        time.sleep(0.01)
+
+
+if __name__ == '__main__':
+    main()
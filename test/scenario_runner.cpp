@@ -0,0 +1,300 @@
+// Renders a configuration headless for a number of frames with synthetic data, and reports the
+// CPU frame time, allocations and memory as YAML, to catch rendering regressions without a display.
+//
+// ros2 run quickplot quickplot_scenario test/multi_plot_config.yaml --ros-args -p frames:=1000
+//
+// ImGui is driven without a renderer backend, so the frame time covers the update of quickplot
+// and the tessellation of the draw lists, which is where plotting spends its CPU time.
+
+#include "implot.h" // NOLINT
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <std_msgs/msg/header.hpp>
+#include "quickplot/application.hpp"
+#include "quickplot/config.hpp"
+#include "quickplot/dock_space.hpp"
+#include "quickplot/ingest_loop.hpp"
+
+using namespace std::chrono_literals;
+
+// counted per thread, so allocations of the publish, spin and ingest threads are not attributed
+// to the frames rendered on the main thread
+static thread_local size_t allocations = 0;
+
+void * operator new(size_t size)
+{
+  allocations++;
+  if (auto ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+// publishes a sine on every member of a topic which is plotted by the configuration
+struct SyntheticTopic
+{
+  rclcpp::GenericPublisher::SharedPtr publisher;
+  std::shared_ptr<quickplot::MessageIntrospection> introspection;
+  std::shared_ptr<quickplot::IntrospectionMessageDeserializer> serializer;
+  std::vector<uint8_t> message;
+  std::vector<quickplot::MemberSequencePath> members;
+
+  ~SyntheticTopic()
+  {
+    if (serializer) {
+      serializer->fini_buffer(message);
+    }
+  }
+};
+
+static std::vector<std::unique_ptr<SyntheticTopic>> create_synthetic_topics(
+  rclcpp::Node & node, const quickplot::ApplicationConfig & config,
+  const std::string & message_type)
+{
+  std::map<std::string, std::vector<quickplot::MemberSequencePathDescriptor>> topic_members;
+  for (const auto & plot : config.plots) {
+    for (const auto & series : plot.series) {
+      topic_members[series.source.topic_name].push_back(series.source.member_path);
+      if (series.stddev_source.has_value()) {
+        topic_members[series.stddev_source->topic_name].push_back(
+          series.stddev_source->member_path);
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<SyntheticTopic>> topics;
+  auto introspection = std::make_shared<quickplot::MessageIntrospection>(message_type);
+  for (const auto & [topic_name, descriptors] : topic_members) {
+    auto topic = std::make_unique<SyntheticTopic>();
+    topic->publisher = node.create_generic_publisher(
+      topic_name, message_type, rclcpp::SensorDataQoS());
+    topic->introspection = introspection;
+    topic->serializer =
+      std::make_shared<quickplot::IntrospectionMessageDeserializer>(introspection);
+    topic->message = topic->serializer->init_buffer();
+    for (const auto & descriptor : descriptors) {
+      try {
+        auto member = introspection->get_member_sequence_path(descriptor);
+        if (member.has_value()) {
+          topic->members.push_back(member.value());
+          continue;
+        }
+      } catch (const quickplot::introspection_error &) {
+      }
+      std::cerr << "member " << descriptor << " of " << topic_name << " is not in " <<
+        message_type << ", it stays empty" << std::endl;
+    }
+    topics.push_back(std::move(topic));
+  }
+  return topics;
+}
+
+static void publish_synthetic(SyntheticTopic & topic, const rclcpp::Time & t)
+{
+  auto header_offset = topic.introspection->get_header_offset();
+  if (header_offset.has_value()) {
+    auto header = static_cast<std_msgs::msg::Header *>(
+      static_cast<void *>(topic.message.data() + header_offset.value()));
+    header->stamp = t;
+  }
+  for (size_t i = 0; i < topic.members.size(); i++) {
+    quickplot::set_numeric(topic.message.data(), topic.members[i], std::sin(t.seconds() + i));
+  }
+  rclcpp::SerializedMessage serialized_message;
+  topic.serializer->serialize(topic.message.data(), serialized_message);
+  topic.publisher->publish(serialized_message);
+}
+
+static size_t count_sources(const quickplot::ApplicationConfig & config)
+{
+  size_t count = 0;
+  for (const auto & plot : config.plots) {
+    for (const auto & series : plot.series) {
+      count += series.stddev_source.has_value() ? 2 : 1;
+    }
+  }
+  return count;
+}
+
+// value at quantile q of sorted values
+static double percentile(const std::vector<double> & sorted, double q)
+{
+  auto idx = static_cast<size_t>(std::ceil(q * sorted.size()));
+  return sorted[std::min(std::max(idx, size_t(1)), sorted.size()) - 1];
+}
+
+int main(int argc, char ** argv)
+{
+  auto non_ros_args = rclcpp::init_and_remove_ros_arguments(argc, argv);
+  if (non_ros_args.size() < 2) {
+    std::cerr << "usage: quickplot_scenario CONFIG_FILE [--ros-args ...]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  quickplot::ApplicationConfig config;
+  try {
+    config = quickplot::load_config(non_ros_args[1]);
+  } catch (const quickplot::config_error & e) {
+    std::cerr << "Failed to read configuration from '" << non_ros_args[1] << "': " << e.what() <<
+      std::endl;
+    return EXIT_FAILURE;
+  }
+
+  auto scenario_node = std::make_shared<rclcpp::Node>("quickplot_scenario");
+  auto frames = scenario_node->declare_parameter<int64_t>("frames", 1000);
+  // seconds to wait for all sources to receive data before measuring
+  auto warmup_timeout = scenario_node->declare_parameter<double>("warmup_timeout", 10.0);
+  // type of all topics of the configuration
+  auto message_type = scenario_node->declare_parameter<std::string>(
+    "message_type", "std_msgs/msg/Float64");
+  // messages per second per topic
+  auto rate = scenario_node->declare_parameter<double>("rate", 100.0);
+  auto display_width = scenario_node->declare_parameter<int64_t>("display_width", 1280);
+  auto display_height = scenario_node->declare_parameter<int64_t>("display_height", 960);
+  // fail if the p99 frame time exceeds this, zero to only report
+  auto max_p99_ms = scenario_node->declare_parameter<double>("max_p99_ms", 0.0);
+  if (frames < 1 || rate <= 0.0) {
+    std::cerr << "frames and rate must be positive" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // measurements must neither restore the history of a previous run nor overwrite it
+  auto node = std::make_shared<quickplot::QuickPlotNode>(
+    "quickplot", rclcpp::NodeOptions().append_parameter_override("snapshot", false));
+  std::thread ros_thread([ = ] {
+      rclcpp::spin(node);
+    });
+  std::unique_ptr<quickplot::IngestLoop> ingest_loop;
+  std::thread ingest_thread;
+  if (node->uses_ingest_loop()) {
+    ingest_loop = std::make_unique<quickplot::IngestLoop>(node);
+    ingest_thread = std::thread([&ingest_loop] {ingest_loop->run();});
+  }
+
+  auto topics = create_synthetic_topics(*scenario_node, config, message_type);
+  std::atomic<bool> publishing {true};
+  std::thread publish_thread([&] {
+      auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / rate));
+      auto next = std::chrono::steady_clock::now();
+      while (publishing && rclcpp::ok()) {
+        auto t = node->now();
+        for (auto & topic : topics) {
+          publish_synthetic(*topic, t);
+        }
+        std::this_thread::sleep_until(next += period);
+      }
+    });
+
+  quickplot::Application app(node);
+  app.apply_config(config);
+
+  IMGUI_CHECKVERSION();
+  ImGui::SetAllocatorFunctions(&quickplot::tracked_gui_alloc, &quickplot::tracked_gui_free);
+  ImGui::CreateContext();
+  ImPlot::CreateContext();
+  ImGuiIO & io = ImGui::GetIO();
+  io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+  io.IniFilename = nullptr;
+  io.DisplaySize = ImVec2(static_cast<float>(display_width), static_cast<float>(display_height));
+  io.DeltaTime = 1.0f / 60.0f;
+  // build the font atlas, which a renderer backend would upload
+  unsigned char * pixels;
+  int atlas_width, atlas_height;
+  io.Fonts->GetTexDataAsRGBA32(&pixels, &atlas_width, &atlas_height);
+  ImGui::StyleColorsLight();
+
+  bool first_frame = true;
+  auto render_frame = [&] {
+      ImGui::NewFrame();
+      ImPlot::GetStyle().LineWeight = 2.0;
+      quickplot::ParentDockSpace(config.plots.size(), first_frame);
+      first_frame = false;
+      app.update();
+      ImGui::Render();
+      return static_cast<size_t>(ImGui::GetDrawData()->TotalVtxCount);
+    };
+
+  // render until every source is subscribed
+  auto expected_sources = count_sources(config);
+  auto warmup_start = std::chrono::steady_clock::now();
+  while (app.memory_report().series.size() < expected_sources) {
+    if (std::chrono::steady_clock::now() - warmup_start >
+      std::chrono::duration<double>(warmup_timeout))
+    {
+      std::cerr << "not all sources are active after " << warmup_timeout <<
+        " seconds, measuring anyway" << std::endl;
+      break;
+    }
+    render_frame();
+    std::this_thread::sleep_for(10ms);
+  }
+
+  std::vector<double> frame_times;
+  frame_times.reserve(static_cast<size_t>(frames));
+  size_t vertices = 0;
+  auto allocations_before = allocations;
+  for (int64_t i = 0; i < frames; i++) {
+    auto start = std::chrono::steady_clock::now();
+    vertices += render_frame();
+    frame_times.push_back(
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  }
+  auto frame_allocations = allocations - allocations_before;
+  auto memory = app.memory_report();
+
+  publishing = false;
+  publish_thread.join();
+  ImPlot::DestroyContext();
+  ImGui::DestroyContext();
+  rclcpp::shutdown();
+  ros_thread.join();
+  if (ingest_thread.joinable()) {
+    ingest_loop->stop();
+    ingest_thread.join();
+  }
+
+  std::sort(frame_times.begin(), frame_times.end());
+  auto p99 = percentile(frame_times, 0.99);
+  std::cout << "frames: " << frames << "\n";
+  std::cout << "frame_time_ms: {p50: " << percentile(frame_times, 0.5) << ", p95: " <<
+    percentile(frame_times, 0.95) << ", p99: " << p99 << ", max: " << frame_times.back() <<
+    "}\n";
+  std::cout << "allocations_per_frame: " << static_cast<double>(frame_allocations) / frames <<
+    "\n";
+  std::cout << "vertices_per_frame: " << static_cast<double>(vertices) / frames << "\n";
+  std::stringstream ss;
+  quickplot::write_memory_report(ss, memory);
+  std::cout << "memory:\n";
+  std::string line;
+  while (std::getline(ss, line)) {
+    std::cout << "  " << line << "\n";
+  }
+  std::cout << std::flush;
+
+  if (max_p99_ms > 0.0 && p99 > max_p99_ms) {
+    std::cerr << "p99 frame time " << p99 << " ms exceeds " << max_p99_ms << " ms" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -1,10 +1,18 @@
 #include <gmock/gmock.h>
+#include <chrono>
+#include <fstream>
 #include <limits>
+#include <memory>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <std_msgs/msg/float64.hpp>
+#include "quickplot/application.hpp"
 #include "quickplot/config.hpp"
 #include <filesystem>
 
 namespace fs = std::filesystem;
+using namespace std::chrono_literals;
 using Op = quickplot::DataSourceOperator;
 using ::testing::StrEq;
 
@@ -19,10 +27,20 @@ TEST(test_config, parse_example_config) {
   EXPECT_EQ(plot.axes[0].y_max, 2.0);
   EXPECT_EQ(plot.series.size(), 2lu);
 
-  // TODO(ZeilingerM): order of items in set is not defined
-  // need a way to test set for exactly two specific struct items
+  // series are in the order of the file
   auto it = plot.series.begin();
   auto source = it->source;
+  EXPECT_EQ(source.topic_name, "/flat");
+  ASSERT_EQ(source.member_path.size(), 2lu);
+  EXPECT_THAT(source.member_path[0].member_name, StrEq("inner"));
+  EXPECT_FALSE(source.member_path[0].sequence_idx.has_value());
+  EXPECT_THAT(source.member_path[1].member_name, StrEq("value"));
+  EXPECT_FALSE(source.member_path[1].sequence_idx.has_value());
+  EXPECT_EQ(source.op, Op::Identity);
+  EXPECT_FALSE(it->stddev_source.has_value());
+
+  ++it;
+  source = it->source;
   EXPECT_EQ(source.topic_name, "sequence");
   ASSERT_EQ(source.member_path.size(), 2lu);
   EXPECT_THAT(source.member_path[0].member_name, StrEq("inner"));
@@ -38,16 +56,320 @@ TEST(test_config, parse_example_config) {
   EXPECT_THAT(source.member_path[0].member_name, StrEq("field"));
   EXPECT_FALSE(source.member_path[0].sequence_idx.has_value());
   EXPECT_EQ(source.op, Op::Sqrt);
+}
 
-  ++it;
-  source = it->source;
-  EXPECT_EQ(source.topic_name, "/flat");
-  ASSERT_EQ(source.member_path.size(), 2lu);
-  EXPECT_THAT(source.member_path[0].member_name, StrEq("inner"));
-  EXPECT_FALSE(source.member_path[0].sequence_idx.has_value());
-  EXPECT_THAT(source.member_path[1].member_name, StrEq("value"));
-  EXPECT_FALSE(source.member_path[1].sequence_idx.has_value());
-  EXPECT_EQ(source.op, Op::Identity);
+TEST(test_config, parse_qos) {
+  auto config = quickplot::load_config("test/qos_config.yaml");
+  ASSERT_EQ(config.plots.size(), 1lu);
+  ASSERT_EQ(config.plots[0].series.size(), 1lu);
+  const auto & qos = config.plots[0].series.begin()->source.qos;
+  ASSERT_TRUE(qos.has_value());
+  EXPECT_EQ(qos->history, quickplot::QosHistory::KeepLast);
+  EXPECT_EQ(qos->depth, 1000lu);
+  EXPECT_EQ(qos->reliability, quickplot::QosReliability::Reliable);
+}
 
-  EXPECT_FALSE(it->stddev_source.has_value());
+TEST(test_config, source_without_qos) {
+  auto config = quickplot::load_config("test/example_config.yaml");
+  for (const auto & series : config.plots[0].series) {
+    EXPECT_FALSE(series.source.qos.has_value());
+  }
+}
+
+TEST(test_config, qos_roundtrip) {
+  auto config = quickplot::load_config("test/qos_config.yaml");
+  auto path = fs::temp_directory_path() / "quickplot_test_qos_roundtrip.yaml";
+  quickplot::save_config(config, path);
+  auto loaded = quickplot::load_config(path);
+  fs::remove(path);
+  ASSERT_EQ(loaded.plots.size(), 1lu);
+  EXPECT_EQ(loaded.plots[0].series, config.plots[0].series);
+}
+
+TEST(test_config, watcher_reloads_written_config) {
+  auto path = fs::temp_directory_path() / "quickplot_test_watcher.yaml";
+  fs::copy_file("test/example_config.yaml", path, fs::copy_options::overwrite_existing);
+  quickplot::ConfigWatcher watcher(path, std::chrono::seconds(0));
+  EXPECT_FALSE(watcher.poll().has_value());
+
+  auto config = quickplot::load_config(path);
+  config.history_length = 7.0;
+  quickplot::save_config(config, path);
+  // file times may be coarser than the time between writes
+  fs::last_write_time(path, fs::last_write_time(path) + std::chrono::seconds(1));
+  auto reloaded = watcher.poll();
+  ASSERT_TRUE(reloaded.has_value());
+  EXPECT_EQ(reloaded->history_length, 7.0);
+  EXPECT_FALSE(watcher.poll().has_value());
+
+  {
+    std::ofstream fout(path);
+    fout << "plots: [";
+  }
+  fs::last_write_time(path, fs::last_write_time(path) + std::chrono::seconds(2));
+  EXPECT_FALSE(watcher.poll().has_value());
+  fs::remove(path);
+}
+
+// many fields of one topic, which all hashed to the same bucket before
+static quickplot::ApplicationConfig many_series_config(size_t count)
+{
+  quickplot::ApplicationConfig config {
+    .history_length = 10.0,
+    .plots = {quickplot::PlotConfig{}},
+  };
+  config.plots[0].axes = {quickplot::AxisConfig {.y_min = -1.0, .y_max = 1.0}};
+  for (size_t i = 0; i < count; i++) {
+    quickplot::TimeSeriesConfig series;
+    series.source.topic_name = "/joint_states";
+    series.source.member_path = {{"position", i}};
+    series.source.op = Op::Identity;
+    series.axis = 0;
+    config.plots[0].series.push_back(series);
+  }
+  return config;
+}
+
+TEST(test_config, series_keep_order_and_drop_duplicates) {
+  auto config = many_series_config(100);
+  config.plots[0].series.push_back(config.plots[0].series[10]);
+  auto path = fs::temp_directory_path() / "quickplot_test_many_series.yaml";
+  quickplot::save_config(config, path);
+  auto loaded = quickplot::load_config(path);
+  fs::remove(path);
+  ASSERT_EQ(loaded.plots.size(), 1lu);
+  const auto & series = loaded.plots[0].series;
+  ASSERT_EQ(series.size(), 100lu);
+  for (size_t i = 0; i < series.size(); i++) {
+    EXPECT_EQ(series[i].source.member_path[0].sequence_idx, i);
+  }
+}
+
+TEST(test_config, series_hash_covers_member_path) {
+  auto config = many_series_config(2);
+  std::hash<quickplot::TimeSeriesConfig> hash;
+  EXPECT_NE(hash(config.plots[0].series[0]), hash(config.plots[0].series[1]));
+}
+
+TEST(test_config, topic_pattern_roundtrip) {
+  auto config = quickplot::load_config("test/pattern_config.yaml");
+  ASSERT_EQ(config.plots.size(), 1lu);
+  EXPECT_TRUE(config.plots[0].series.empty());
+  ASSERT_EQ(config.plots[0].patterns.size(), 2lu);
+  const auto & pattern = config.plots[0].patterns[0];
+  EXPECT_EQ(pattern.topic_pattern, "/robot_[0-9]+/battery");
+  ASSERT_EQ(pattern.member_path.size(), 1lu);
+  EXPECT_EQ(pattern.member_path[0].member_name, "percentage");
+  EXPECT_EQ(pattern.op, Op::Identity);
+  EXPECT_EQ(pattern.axis, 0);
+  ASSERT_TRUE(pattern.qos.has_value());
+  EXPECT_FALSE(pattern.aggregate.has_value());
+  const auto & aggregate = config.plots[0].patterns[1].aggregate;
+  ASSERT_TRUE(aggregate.has_value());
+  EXPECT_EQ(aggregate->op, quickplot::AggregateOperator::Min);
+  EXPECT_EQ(aggregate->bucket, 0.5);
+
+  auto path = fs::temp_directory_path() / "quickplot_test_pattern_roundtrip.yaml";
+  quickplot::save_config(config, path);
+  auto loaded = quickplot::load_config(path);
+  ASSERT_EQ(loaded.plots.size(), 1lu);
+  EXPECT_EQ(loaded.plots[0].patterns, config.plots[0].patterns);
+
+  // patterns which are not valid regular expressions are rejected
+  {
+    std::ofstream fout(path);
+    fout << "history_length: 10\nplots:\n  - axes: []\n    series: []\n    patterns:\n" <<
+      "      - {topic_pattern: '/robot_(', member_path: [percentage]}\n";
+  }
+  EXPECT_THROW(quickplot::load_config(path), quickplot::config_error);
+  fs::remove(path);
+}
+
+TEST(test_config, domain_roundtrip) {
+  auto path = fs::temp_directory_path() / "quickplot_test_domain_roundtrip.yaml";
+  {
+    std::ofstream fout(path);
+    fout << "history_length: 10\nplots:\n  - axes: []\n    series:\n" <<
+      "      - source: {topic_name: /odom, member_path: [x], domain_id: 3}\n" <<
+      "      - source: {topic_name: /odom, member_path: [x]}\n    patterns:\n" <<
+      "      - {topic_pattern: '/robot_.*', member_path: [x], domain_id: 7}\n";
+  }
+  auto config = quickplot::load_config(path);
+  ASSERT_EQ(config.plots.size(), 1lu);
+  // the same topic in another domain is a different series
+  ASSERT_EQ(config.plots[0].series.size(), 2lu);
+  EXPECT_EQ(config.plots[0].series[0].source.domain_id, 3lu);
+  EXPECT_FALSE(config.plots[0].series[1].source.domain_id.has_value());
+  ASSERT_EQ(config.plots[0].patterns.size(), 1lu);
+  EXPECT_EQ(config.plots[0].patterns[0].domain_id, 7lu);
+
+  quickplot::save_config(config, path);
+  auto loaded = quickplot::load_config(path);
+  fs::remove(path);
+  ASSERT_EQ(loaded.plots.size(), 1lu);
+  EXPECT_EQ(loaded.plots[0].series, config.plots[0].series);
+  EXPECT_EQ(loaded.plots[0].patterns, config.plots[0].patterns);
+}
+
+TEST(test_config, qualified_topic_name) {
+  EXPECT_EQ(quickplot::qualified_topic_name(std::nullopt, "/odom"), "/odom");
+  EXPECT_EQ(quickplot::qualified_topic_name(12, "/odom"), "[12]/odom");
+
+  auto [domain_id, topic] = quickplot::split_qualified_topic_name("[12]/odom");
+  EXPECT_EQ(domain_id, 12lu);
+  EXPECT_EQ(topic, "/odom");
+  std::tie(domain_id, topic) = quickplot::split_qualified_topic_name("/odom");
+  EXPECT_FALSE(domain_id.has_value());
+  EXPECT_EQ(topic, "/odom");
+  // malformed prefixes are kept as part of the name
+  std::tie(domain_id, topic) = quickplot::split_qualified_topic_name("[x]/odom");
+  EXPECT_FALSE(domain_id.has_value());
+  EXPECT_EQ(topic, "[x]/odom");
+}
+
+TEST(test_config, channel_roundtrip) {
+  auto path = fs::temp_directory_path() / "quickplot_test_socket_roundtrip.yaml";
+  {
+    std::ofstream fout(path);
+    fout << "history_length: 10\nplots:\n  - axes: []\n    series:\n" <<
+      "      - source: {socket_channel: motor/current}\n" <<
+      "      - source: {topic_name: motor/current, member_path: [data]}\n" <<
+      "      - source: {push_series: motor/current}\n";
+  }
+  auto config = quickplot::load_config(path);
+  ASSERT_EQ(config.plots.size(), 1lu);
+  // a channel, topic and pushed series of the same name are different series
+  ASSERT_EQ(config.plots[0].series.size(), 3lu);
+  const auto & source = config.plots[0].series[0].source;
+  EXPECT_EQ(source.kind, quickplot::DataSourceKind::Socket);
+  EXPECT_EQ(source.topic_name, "motor/current");
+  EXPECT_TRUE(source.member_path.empty());
+  EXPECT_EQ(config.plots[0].series[1].source.kind, quickplot::DataSourceKind::Topic);
+  EXPECT_EQ(config.plots[0].series[2].source.kind, quickplot::DataSourceKind::Push);
+
+  quickplot::save_config(config, path);
+  auto loaded = quickplot::load_config(path);
+  fs::remove(path);
+  ASSERT_EQ(loaded.plots.size(), 1lu);
+  EXPECT_EQ(loaded.plots[0].series, config.plots[0].series);
+}
+
+TEST(test_config, sequence_key_roundtrip) {
+  auto path = fs::temp_directory_path() / "quickplot_test_sequence_key_roundtrip.yaml";
+  {
+    std::ofstream fout(path);
+    fout << "history_length: 10\nplots:\n  - axes: []\n    series:\n" <<
+      "      - source:\n          topic_name: joint_states\n" <<
+      "          member_path:\n            - position[name=elbow]\n" <<
+      "      - source:\n          topic_name: joint_states\n" <<
+      "          member_path:\n            - position[name=wrist]\n";
+  }
+  auto config = quickplot::load_config(path);
+  ASSERT_EQ(config.plots.size(), 1lu);
+  // series of different keys are not duplicates
+  ASSERT_EQ(config.plots[0].series.size(), 2lu);
+  const auto & item = config.plots[0].series[0].source.member_path.at(0);
+  EXPECT_THAT(item.member_name, StrEq("position"));
+  EXPECT_FALSE(item.sequence_idx.has_value());
+  ASSERT_TRUE(item.sequence_key.has_value());
+  EXPECT_THAT(item.sequence_key->member_name, StrEq("name"));
+  EXPECT_THAT(item.sequence_key->value, StrEq("elbow"));
+
+  quickplot::save_config(config, path);
+  auto loaded = quickplot::load_config(path);
+  fs::remove(path);
+  ASSERT_EQ(loaded.plots.size(), 1lu);
+  EXPECT_EQ(loaded.plots[0].series, config.plots[0].series);
+}
+
+TEST(test_config, priority_roundtrip) {
+  auto path = fs::temp_directory_path() / "quickplot_test_priority_roundtrip.yaml";
+  {
+    std::ofstream fout(path);
+    fout << "history_length: 10\nplots:\n  - axes: []\n    series:\n" <<
+      "      - {source: {topic_name: /odom, member_path: [x]}, priority: high}\n" <<
+      "      - source: {topic_name: /odom, member_path: [y]}\n    patterns:\n" <<
+      "      - {topic_pattern: '/camera_.*', member_path: [x], priority: low}\n";
+  }
+  auto config = quickplot::load_config(path);
+  ASSERT_EQ(config.plots.size(), 1lu);
+  ASSERT_EQ(config.plots[0].series.size(), 2lu);
+  EXPECT_EQ(config.plots[0].series[0].priority, quickplot::SeriesPriority::High);
+  EXPECT_EQ(config.plots[0].series[1].priority, quickplot::SeriesPriority::Normal);
+  ASSERT_EQ(config.plots[0].patterns.size(), 1lu);
+  EXPECT_EQ(config.plots[0].patterns[0].priority, quickplot::SeriesPriority::Low);
+
+  quickplot::save_config(config, path);
+  auto loaded = quickplot::load_config(path);
+  ASSERT_EQ(loaded.plots.size(), 1lu);
+  EXPECT_EQ(loaded.plots[0].series, config.plots[0].series);
+  EXPECT_EQ(loaded.plots[0].patterns, config.plots[0].patterns);
+
+  // unknown priorities are rejected
+  {
+    std::ofstream fout(path);
+    fout << "history_length: 10\nplots:\n  - axes: []\n    series:\n" <<
+      "      - {source: {topic_name: /odom, member_path: [x]}, priority: urgent}\n";
+  }
+  EXPECT_THROW(quickplot::load_config(path), quickplot::config_error);
+  fs::remove(path);
+}
+
+static quickplot::TimeSeriesConfig float_series(const std::string & topic)
+{
+  quickplot::TimeSeriesConfig series;
+  series.source.topic_name = topic;
+  series.source.member_path = {{"data", std::nullopt}};
+  series.source.op = Op::Identity;
+  series.axis = 0;
+  return series;
+}
+
+TEST(test_config, apply_config_keeps_unchanged_series) {
+  rclcpp::init(0, nullptr);
+  {
+    auto publisher_node = std::make_shared<rclcpp::Node>("test_config_publisher");
+    auto kept_publisher = publisher_node->create_publisher<std_msgs::msg::Float64>(
+      "/test_config/kept", 1);
+    auto removed_publisher = publisher_node->create_publisher<std_msgs::msg::Float64>(
+      "/test_config/removed", 1);
+    // without a snapshot, buffers are not restored from previous runs
+    quickplot::Application app(
+      std::make_shared<quickplot::QuickPlotNode>(
+        "quickplot", rclcpp::NodeOptions().parameter_overrides({{"snapshot", false}})));
+    quickplot::ApplicationConfig config {
+      .history_length = 10.0,
+      .plots = {quickplot::PlotConfig{}},
+    };
+    config.plots[0].axes = {quickplot::AxisConfig {.y_min = -1.0, .y_max = 1.0}};
+    config.plots[0].series = {float_series("/test_config/kept"),
+      float_series("/test_config/removed")};
+    app.apply_config(config);
+
+    auto active = [&app](size_t i) {
+        return std::get_if<quickplot::ActiveDataSource>(&app.plots()[0].series[i].first.source);
+      };
+    // series initialize once their topics are discovered
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while ((!active(0) || !active(1)) && std::chrono::steady_clock::now() < deadline) {
+      app.update_headless();
+      std::this_thread::sleep_for(10ms);
+    }
+    ASSERT_NE(active(0), nullptr);
+    ASSERT_NE(active(1), nullptr);
+    auto kept_data = active(0)->data;
+    auto kept_subscription = active(0)->subscription;
+    std::weak_ptr<quickplot::PlotDataBuffer> removed_data = active(1)->data;
+    std::weak_ptr<quickplot::PlotSubscription> removed_subscription = active(1)->subscription;
+
+    config.plots[0].series.pop_back();
+    app.apply_config(config);
+    ASSERT_EQ(app.plots()[0].series.size(), 1lu);
+    ASSERT_NE(active(0), nullptr);
+    EXPECT_EQ(active(0)->data, kept_data);
+    EXPECT_EQ(active(0)->subscription, kept_subscription);
+    EXPECT_TRUE(removed_data.expired());
+    EXPECT_TRUE(removed_subscription.expired());
+  }
+  rclcpp::shutdown();
 }
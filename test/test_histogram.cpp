@@ -0,0 +1,102 @@
+#include <gmock/gmock.h>
+#include <chrono>
+#include <sstream>
+#include "quickplot/histogram.hpp"
+
+using quickplot::WindowedHistogram;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using ::testing::HasSubstr;
+
+TEST(test_histogram, bucket_bounds_contain_value)
+{
+  for (uint64_t value : {0ul, 1ul, 15ul, 16ul, 17ul, 100ul, 1000ul, 123456789ul}) {
+    auto index = WindowedHistogram::bucket_index(value);
+    EXPECT_GE(WindowedHistogram::bucket_upper_bound(index), value);
+    if (index > 0) {
+      EXPECT_LT(WindowedHistogram::bucket_upper_bound(index - 1), value);
+    }
+  }
+  EXPECT_EQ(WindowedHistogram::bucket_index(uint64_t(1) << 50), WindowedHistogram::BUCKETS - 1);
+}
+
+TEST(test_histogram, bucket_relative_error)
+{
+  for (uint64_t value = 1000; value < 1000000; value += 997) {
+    auto bound = WindowedHistogram::bucket_upper_bound(WindowedHistogram::bucket_index(value));
+    EXPECT_LE(bound - value, value / WindowedHistogram::SUB_BUCKETS);
+  }
+}
+
+TEST(test_histogram, empty_summary)
+{
+  WindowedHistogram histogram;
+  auto summary = histogram.summary(seconds(100));
+  EXPECT_EQ(summary.count, 0ul);
+  EXPECT_EQ(summary.rate(), 0.0);
+}
+
+TEST(test_histogram, percentiles)
+{
+  WindowedHistogram histogram;
+  auto t = seconds(100);
+  for (uint64_t i = 1; i <= 1000; i++) {
+    histogram.record(i, t + std::chrono::microseconds(i));
+  }
+  auto summary = histogram.summary(t + milliseconds(500));
+  EXPECT_EQ(summary.count, 1000ul);
+  EXPECT_EQ(summary.max, 1000ul);
+  EXPECT_EQ(summary.sum, 500500ul);
+  EXPECT_NEAR(summary.p50, 500.0, 500.0 / WindowedHistogram::SUB_BUCKETS);
+  EXPECT_NEAR(summary.p99, 990.0, 990.0 / WindowedHistogram::SUB_BUCKETS);
+  EXPECT_NEAR(summary.window, 0.5, 1e-3);
+  EXPECT_NEAR(summary.rate(), 2000.0, 10.0);
+}
+
+TEST(test_histogram, old_values_leave_window)
+{
+  WindowedHistogram histogram(seconds(1), 3);
+  histogram.record(1000, seconds(10));
+  histogram.record(1, seconds(11));
+  histogram.record(1, seconds(12));
+  EXPECT_EQ(histogram.summary(seconds(12)).max, 1000ul);
+  EXPECT_EQ(histogram.summary(seconds(13)).max, 1ul);
+  EXPECT_EQ(histogram.summary(seconds(13)).count, 2ul);
+  // recording into a slot of an expired epoch drops its values
+  histogram.record(1, seconds(13));
+  EXPECT_EQ(histogram.summary(seconds(13)).count, 3ul);
+  EXPECT_EQ(histogram.summary(seconds(20)).count, 0ul);
+}
+
+TEST(test_histogram, clear)
+{
+  WindowedHistogram histogram;
+  histogram.record(1, seconds(1));
+  histogram.clear();
+  EXPECT_EQ(histogram.summary(seconds(1)).count, 0ul);
+}
+
+TEST(test_histogram, slots_are_allocated_on_first_record)
+{
+  WindowedHistogram histogram(seconds(1), 10);
+  auto empty = histogram.memory_size();
+  EXPECT_LT(empty, 1000ul);
+  histogram.record(1, seconds(1));
+  auto one_slot = histogram.memory_size();
+  EXPECT_GT(one_slot, empty);
+  histogram.record(2, milliseconds(1500));
+  EXPECT_EQ(histogram.memory_size(), one_slot);
+  histogram.record(3, seconds(2));
+  EXPECT_EQ(histogram.memory_size() - one_slot, one_slot - empty);
+  EXPECT_EQ(histogram.summary(seconds(2)).count, 3ul);
+}
+
+TEST(test_histogram, summary_output)
+{
+  WindowedHistogram histogram;
+  histogram.record(5, seconds(1));
+  std::stringstream ss;
+  ss << histogram.summary(seconds(2));
+  EXPECT_THAT(ss.str(), HasSubstr("count: 1"));
+  EXPECT_THAT(ss.str(), HasSubstr("max: 5"));
+}
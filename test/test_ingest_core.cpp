@@ -0,0 +1,233 @@
+#include <gmock/gmock.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <geometry_msgs/msg/twist.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include "quickplot/plot_subscription.hpp"
+
+using namespace std::chrono_literals;
+using geometry_msgs::msg::Twist;
+using geometry_msgs::msg::TwistStamped;
+using quickplot::FakeIngestClock;
+using quickplot::IngestCore;
+
+template<typename MessageT>
+static rclcpp::SerializedMessage serialize(const MessageT & msg)
+{
+  rclcpp::Serialization<MessageT> serializer;
+  rclcpp::SerializedMessage serialized_msg;
+  serializer.serialize_message(&msg, &serialized_msg);
+  return serialized_msg;
+}
+
+// serialized TwistStamped messages with twist.linear.x = i, stamped every 10 ms
+static std::vector<rclcpp::SerializedMessage> twist_stream(size_t count)
+{
+  std::vector<rclcpp::SerializedMessage> stream;
+  for (size_t i = 0; i < count; i++) {
+    TwistStamped msg;
+    msg.header.stamp = rclcpp::Time(static_cast<int64_t>(i * 10000000), RCL_ROS_TIME);
+    msg.twist.linear.x = static_cast<double>(i);
+    stream.push_back(serialize(msg));
+  }
+  return stream;
+}
+
+class IngestCoreTest : public ::testing::Test
+{
+protected:
+  std::shared_ptr<FakeIngestClock> clock;
+  std::shared_ptr<quickplot::MessageIntrospection> introspection;
+  std::unique_ptr<IngestCore> core;
+
+  void SetUp() override
+  {
+    clock = std::make_shared<FakeIngestClock>();
+    introspection = std::make_shared<quickplot::MessageIntrospection>(
+      "geometry_msgs/msg/TwistStamped");
+    core = std::make_unique<IngestCore>(
+      std::make_shared<quickplot::IntrospectionMessageDeserializer>(introspection), clock);
+  }
+
+  std::shared_ptr<quickplot::PlotDataBuffer> add_linear_x()
+  {
+    auto member = introspection->get_member_sequence_path(
+      {{"twist", std::nullopt}, {"linear", std::nullopt}, {"x", std::nullopt}}).value();
+    return core->add_source(
+      quickplot::MessageAccessor {
+        .member = member,
+        .op = quickplot::DataSourceOperator::Identity,
+      }, nullptr);
+  }
+};
+
+TEST_F(IngestCoreTest, receives_stamped_messages_on_fake_clock)
+{
+  auto buffer = add_linear_x();
+  // each message arrives 2 ms after its stamp
+  clock->advance(2ms);
+  for (const auto & message : twist_stream(10)) {
+    core->receive_serialized(message);
+    clock->advance(10ms);
+  }
+
+  {
+    auto data = buffer->data();
+    ASSERT_EQ(data->size(), 10ul);
+    size_t i = 0;
+    for (const auto & point : *data) {
+      EXPECT_DOUBLE_EQ(point.x, 0.01 * i);
+      EXPECT_DOUBLE_EQ(point.y, static_cast<double>(i));
+      i++;
+    }
+  }
+
+  auto stats = core->receive_stats();
+  EXPECT_EQ(stats.period.count, 9ul);
+  EXPECT_NEAR(stats.period.max, 10e6, 10e6 / 16);
+  EXPECT_EQ(stats.latency.count, 10ul);
+  EXPECT_NEAR(stats.latency.max, 2e6, 2e6 / 16);
+  EXPECT_EQ(stats.message_size.count, 10ul);
+  EXPECT_EQ(core->stamp_gaps(), 0ul);
+}
+
+TEST_F(IngestCoreTest, batch_counts_stamp_gaps)
+{
+  auto buffer = add_linear_x();
+  auto stream = twist_stream(20);
+  // drop messages 10 to 12
+  stream.erase(stream.begin() + 10, stream.begin() + 13);
+  size_t next = 0;
+  auto taken = core->receive_batch(
+    [&](rclcpp::SerializedMessage & message) {
+      if (next == stream.size()) {
+        return false;
+      }
+      message = stream[next++];
+      return true;
+    }, 100);
+
+  EXPECT_EQ(taken, 17ul);
+  EXPECT_EQ(buffer->data()->size(), 17ul);
+  EXPECT_EQ(core->stamp_gaps(), 1ul);
+  EXPECT_EQ(core->stamp_gap_missing(), 3ul);
+}
+
+TEST_F(IngestCoreTest, batch_stops_at_max_messages)
+{
+  auto buffer = add_linear_x();
+  auto stream = twist_stream(10);
+  size_t next = 0;
+  auto take = [&](rclcpp::SerializedMessage & message) {
+      if (next == stream.size()) {
+        return false;
+      }
+      message = stream[next++];
+      return true;
+    };
+  EXPECT_EQ(core->receive_batch(take, 4), 4ul);
+  EXPECT_EQ(buffer->data()->size(), 4ul);
+  EXPECT_EQ(core->receive_batch(take, 100), 6ul);
+  EXPECT_EQ(buffer->data()->size(), 10ul);
+}
+
+TEST_F(IngestCoreTest, decimation_sheds_messages_before_deserialization)
+{
+  auto buffer = add_linear_x();
+  core->set_decimation(4);
+  for (const auto & message : twist_stream(20)) {
+    core->receive_serialized(message);
+    clock->advance(10ms);
+  }
+  {
+    auto data = buffer->data();
+    ASSERT_EQ(data->size(), 5ul);
+    size_t i = 0;
+    for (const auto & point : *data) {
+      EXPECT_DOUBLE_EQ(point.y, static_cast<double>(4 * i));
+      i++;
+    }
+  }
+  EXPECT_EQ(core->shed_messages(), 15ul);
+  // shed messages still count for the receive rate
+  EXPECT_EQ(core->receive_stats().message_size.count, 20ul);
+  // the thinned stamps have a regular period, so they are no gaps
+  EXPECT_EQ(core->stamp_gaps(), 0ul);
+
+  core->set_decimation(1);
+  for (const auto & message : twist_stream(4)) {
+    core->receive_serialized(message);
+  }
+  EXPECT_EQ(core->shed_messages(), 15ul);
+}
+
+TEST_F(IngestCoreTest, clear_releases_expired_sources)
+{
+  auto buffer = add_linear_x();
+  auto removed = add_linear_x();
+  for (const auto & message : twist_stream(3)) {
+    core->receive_serialized(message);
+  }
+  EXPECT_EQ(core->pipeline_sources()->size(), 2ul);
+  removed.reset();
+  core->clear();
+  EXPECT_TRUE(buffer->empty());
+  EXPECT_EQ(core->pipeline_sources()->size(), 1ul);
+}
+
+TEST(test_ingest_core, messages_without_stamp_use_clock_time)
+{
+  auto clock = std::make_shared<FakeIngestClock>(rclcpp::Time(5, 0, RCL_ROS_TIME));
+  auto introspection = std::make_shared<quickplot::MessageIntrospection>(
+    "geometry_msgs/msg/Twist");
+  IngestCore core(
+    std::make_shared<quickplot::IntrospectionMessageDeserializer>(introspection), clock);
+  auto member = introspection->get_member_sequence_path(
+    {{"angular", std::nullopt}, {"z", std::nullopt}}).value();
+  auto buffer = core.add_source(
+    quickplot::MessageAccessor {
+      .member = member,
+      .op = quickplot::DataSourceOperator::Identity,
+    }, nullptr);
+
+  Twist msg;
+  msg.angular.z = 3.0;
+  core.receive_serialized(serialize(msg));
+  clock->advance(500ms);
+  core.receive_serialized(serialize(msg));
+
+  auto data = buffer->data();
+  ASSERT_EQ(data->size(), 2ul);
+  EXPECT_DOUBLE_EQ(data->begin()->x, 5.0);
+  EXPECT_DOUBLE_EQ((data->begin() + 1)->x, 5.5);
+  EXPECT_DOUBLE_EQ((data->begin() + 1)->y, 3.0);
+  EXPECT_EQ(core.receive_stats().latency.count, 0ul);
+}
+
+TEST_F(IngestCoreTest, pipeline_commits_in_arrival_order)
+{
+  auto buffer = add_linear_x();
+  auto deserializer = std::make_shared<quickplot::IntrospectionMessageDeserializer>(introspection);
+  {
+    // a small ring makes workers wait for the commit of earlier messages
+    quickplot::IngestPipeline pipeline(
+      *core, deserializer, std::make_shared<quickplot::TaskScheduler>(4), 4, 16);
+    EXPECT_EQ(pipeline.workers(), 4ul);
+    for (const auto & message : twist_stream(1000)) {
+      pipeline.submit(std::make_shared<rclcpp::SerializedMessage>(message));
+    }
+    pipeline.flush();
+  }
+
+  auto data = buffer->data();
+  ASSERT_EQ(data->size(), 1000ul);
+  size_t i = 0;
+  for (const auto & point : *data) {
+    EXPECT_DOUBLE_EQ(point.x, 0.01 * i);
+    EXPECT_DOUBLE_EQ(point.y, static_cast<double>(i));
+    i++;
+  }
+  EXPECT_EQ(core->receive_stats().message_size.count, 1000ul);
+  EXPECT_EQ(core->stamp_gaps(), 0ul);
+}
@@ -5,6 +5,7 @@
 #include <string>
 #include <rosidl_typesupport_cpp/identifier.hpp>
 #include <rosidl_typesupport_introspection_cpp/identifier.hpp>
+#include <sensor_msgs/msg/joint_state.hpp>
 
 using ::testing::StrEq;
 
@@ -120,3 +121,67 @@ TEST(test_introspection, stream_insert_members)
   ss << quickplot::to_descriptor(member_path.value());
   EXPECT_THAT(ss.str(), StrEq("twist.linear.z"));
 }
+
+TEST(test_introspection, sequence_key_follows_reordered_names)
+{
+  auto introspection = std::make_shared<quickplot::MessageIntrospection>(
+    "sensor_msgs/msg/JointState");
+  quickplot::MemberSequencePathDescriptor descriptor {
+    {"position", std::nullopt, quickplot::SequenceKeyDescriptor {"name", "elbow"}}};
+  auto member_path = introspection->get_member_sequence_path(descriptor);
+  ASSERT_TRUE(member_path.has_value());
+  quickplot::MessageAccessor accessor {
+    .member = member_path.value(),
+    .op = quickplot::DataSourceOperator::Identity,
+    .key = introspection->get_sequence_key(descriptor, member_path.value()),
+  };
+  ASSERT_TRUE(accessor.key.has_value());
+
+  sensor_msgs::msg::JointState msg;
+  msg.name = {"shoulder", "elbow", "wrist"};
+  msg.position = {1.0, 2.0, 3.0};
+  ASSERT_TRUE(quickplot::resolve_sequence_key(&msg, accessor));
+  EXPECT_EQ(accessor.member[0].second, 1ul);
+  EXPECT_EQ(quickplot::get_numeric(&msg, accessor.member), 2.0);
+
+  // the cached index is revalidated when joints are reordered
+  msg.name = {"elbow", "wrist"};
+  msg.position = {4.0, 5.0};
+  ASSERT_TRUE(quickplot::resolve_sequence_key(&msg, accessor));
+  EXPECT_EQ(accessor.member[0].second, 0ul);
+  EXPECT_EQ(quickplot::get_numeric(&msg, accessor.member), 4.0);
+
+  // messages without the key, or without its position, have no value
+  msg.name = {"wrist"};
+  msg.position = {5.0};
+  EXPECT_FALSE(quickplot::resolve_sequence_key(&msg, accessor));
+  msg.name = {"wrist", "elbow"};
+  EXPECT_FALSE(quickplot::resolve_sequence_key(&msg, accessor));
+
+  std::stringstream ss;
+  ss << quickplot::to_descriptor(accessor);
+  EXPECT_THAT(ss.str(), StrEq("position[name=elbow]"));
+}
+
+TEST(test_introspection, sequence_key_must_be_string_sequence)
+{
+  auto introspection = std::make_shared<quickplot::MessageIntrospection>(
+    "sensor_msgs/msg/JointState");
+  for (const auto & key_member : {"effort", "missing"}) {
+    quickplot::MemberSequencePathDescriptor descriptor {
+      {"position", std::nullopt, quickplot::SequenceKeyDescriptor {key_member, "elbow"}}};
+    auto member_path = introspection->get_member_sequence_path(descriptor);
+    ASSERT_TRUE(member_path.has_value());
+    EXPECT_THROW(
+      introspection->get_sequence_key(descriptor, member_path.value()),
+      quickplot::introspection_error) << key_member;
+  }
+}
+
+TEST(test_introspection, empty_member_path_fails)
+{
+  sensor_msgs::msg::JointState msg;
+  quickplot::MemberSequencePath path;
+  EXPECT_THROW(quickplot::get_numeric(&msg, path), quickplot::introspection_error);
+  EXPECT_THROW(quickplot::set_numeric(&msg, path, 1.0), quickplot::introspection_error);
+}
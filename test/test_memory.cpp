@@ -0,0 +1,66 @@
+#include <gmock/gmock.h>
+#include <yaml-cpp/yaml.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "quickplot/memory.hpp"
+
+using quickplot::MemoryReport;
+using quickplot::MemoryUsage;
+
+TEST(test_memory, tracked_allocator_counts_bytes)
+{
+  auto before = quickplot::tracked_gui_bytes();
+  void * ptr = quickplot::tracked_gui_alloc(100, nullptr);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(quickplot::tracked_gui_bytes(), before + 100);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignof(std::max_align_t), 0u);
+  quickplot::tracked_gui_free(ptr, nullptr);
+  EXPECT_EQ(quickplot::tracked_gui_bytes(), before);
+  quickplot::tracked_gui_free(nullptr, nullptr);
+}
+
+TEST(test_memory, resident_set_size)
+{
+  EXPECT_GT(quickplot::resident_set_size(), 0u);
+}
+
+TEST(test_memory, mapped_library_size)
+{
+  // find any shared library mapped into the test process
+  std::ifstream maps("/proc/self/maps");
+  std::string line, library;
+  while (library.empty() && std::getline(maps, line)) {
+    auto pos = line.find('/');
+    if (pos != std::string::npos && line.find(".so", pos) != std::string::npos) {
+      library = line.substr(pos);
+    }
+  }
+  ASSERT_FALSE(library.empty());
+  EXPECT_GT(quickplot::mapped_library_size(library), 0u);
+  EXPECT_EQ(quickplot::mapped_library_size("/nonexistent/libmissing.so"), 0u);
+}
+
+TEST(test_memory, report_is_yaml)
+{
+  MemoryReport report {
+    .series = {{"/imu/angular_velocity/z", MemoryUsage {.used = 16, .reserved = 32}}},
+    .subscriptions = {},
+    .libraries = {},
+    .gui = MemoryUsage {.used = 8, .reserved = 8},
+    .resident = 100,
+    .budget = 50,
+  };
+  EXPECT_TRUE(report.over_budget());
+  EXPECT_EQ(report.accounted().reserved, 40u);
+
+  std::stringstream ss;
+  quickplot::write_memory_report(ss, report);
+  auto node = YAML::Load(ss.str());
+  EXPECT_EQ(node["resident"].as<size_t>(), 100u);
+  EXPECT_TRUE(node["over_budget"].as<bool>());
+  ASSERT_EQ(node["series"].size(), 1u);
+  EXPECT_EQ(node["series"][0]["name"].as<std::string>(), "/imu/angular_velocity/z");
+  EXPECT_EQ(node["series"][0]["reserved"].as<size_t>(), 32u);
+  EXPECT_EQ(node["subscriptions"].size(), 0u);
+}
@@ -161,3 +161,35 @@ TEST(test_message_parser, detection_parses_nested_array)
 
   deserializer.fini_buffer(buffer);
 }
+
+TEST(test_message_parser, set_numeric_resizes_sequences_and_serializes)
+{
+  using vision_msgs::msg::Detection3DArray;
+  auto introspection = std::make_shared<quickplot::MessageIntrospection>(
+    "vision_msgs/Detection3DArray");
+  quickplot::IntrospectionMessageDeserializer deserializer(introspection);
+
+  auto x_member = introspection->get_member_sequence_path(
+    {mbi("detections", 1), mb("bbox"), mb("center"), mb("position"), mb("x")});
+  auto cov_member = introspection->get_member_sequence_path(
+    {mbi("detections", 0), mbi("results", 0), mb("pose"), mbi("covariance", 35)});
+  ASSERT_TRUE(x_member.has_value());
+  ASSERT_TRUE(cov_member.has_value());
+
+  auto buffer = deserializer.init_buffer();
+  quickplot::set_numeric(buffer.data(), x_member.value(), 1.0);
+  quickplot::set_numeric(buffer.data(), cov_member.value(), 3.0);
+  EXPECT_FLOAT_EQ(quickplot::get_numeric(buffer.data(), x_member.value()), 1.0);
+
+  rclcpp::SerializedMessage serialized_msg;
+  deserializer.serialize(buffer.data(), serialized_msg);
+  deserializer.fini_buffer(buffer);
+
+  Detection3DArray msg;
+  rclcpp::Serialization<Detection3DArray> serializer;
+  serializer.deserialize_message(&serialized_msg, static_cast<void *>(&msg));
+  ASSERT_EQ(msg.detections.size(), 2ul);
+  EXPECT_FLOAT_EQ(msg.detections[1].bbox.center.position.x, 1.0);
+  ASSERT_EQ(msg.detections[0].results.size(), 1ul);
+  EXPECT_FLOAT_EQ(msg.detections[0].results[0].pose.covariance[35], 3.0);
+}
@@ -0,0 +1,80 @@
+#include <gmock/gmock.h>
+#include <vector>
+#include "quickplot/overload.hpp"
+
+using quickplot::IngestLoad;
+using quickplot::OverloadController;
+using quickplot::SeriesPriority;
+
+TEST(test_overload, thins_lowest_priority_first) {
+  OverloadController controller(1.0, 100);
+  std::vector<IngestLoad> loads {
+    {SeriesPriority::Low, 0.8, 0},
+    {SeriesPriority::Normal, 0.4, 0},
+    {SeriesPriority::High, 0.4, 0},
+  };
+  controller.update(loads, 1.0);
+  EXPECT_TRUE(controller.overloaded());
+  EXPECT_DOUBLE_EQ(controller.load(), 1.6);
+  EXPECT_EQ(controller.decimation(SeriesPriority::Low), 2ul);
+  EXPECT_EQ(controller.decimation(SeriesPriority::Normal), 1ul);
+
+  // normal priority is only thinned once low priority is fully decimated
+  for (int i = 0; i < 10; i++) {
+    controller.update(loads, 1.0);
+  }
+  EXPECT_EQ(controller.decimation(SeriesPriority::Low), OverloadController::MAX_DECIMATION);
+  EXPECT_GT(controller.decimation(SeriesPriority::Normal), 1ul);
+  EXPECT_EQ(controller.decimation(SeriesPriority::High), 1ul);
+}
+
+TEST(test_overload, skips_priorities_without_subscriptions) {
+  OverloadController controller(1.0, 100);
+  controller.update({{SeriesPriority::Normal, 2.0, 0}}, 1.0);
+  EXPECT_EQ(controller.decimation(SeriesPriority::Low), 1ul);
+  EXPECT_EQ(controller.decimation(SeriesPriority::Normal), 2ul);
+}
+
+TEST(test_overload, backlog_is_overload) {
+  OverloadController controller(1.0, 100);
+  controller.update({{SeriesPriority::Low, 0.1, 500}}, 1.0);
+  EXPECT_TRUE(controller.overloaded());
+  EXPECT_EQ(controller.decimation(SeriesPriority::Low), 2ul);
+}
+
+TEST(test_overload, recovers_most_important_first) {
+  OverloadController controller(1.0, 100);
+  std::vector<IngestLoad> overloaded {
+    {SeriesPriority::Low, 5.0, 0},
+    {SeriesPriority::Normal, 5.0, 0},
+  };
+  for (int i = 0; i < 8; i++) {
+    controller.update(overloaded, 1.0);
+  }
+  ASSERT_EQ(controller.decimation(SeriesPriority::Low), OverloadController::MAX_DECIMATION);
+  ASSERT_EQ(controller.decimation(SeriesPriority::Normal), 4ul);
+  EXPECT_TRUE(controller.shedding());
+
+  // between the recovery threshold and the budget, the decimation is kept
+  std::vector<IngestLoad> within_budget {
+    {SeriesPriority::Low, 0.3, 0},
+    {SeriesPriority::Normal, 0.4, 0},
+  };
+  controller.update(within_budget, 1.0);
+  EXPECT_FALSE(controller.overloaded());
+  EXPECT_EQ(controller.decimation(SeriesPriority::Normal), 4ul);
+
+  std::vector<IngestLoad> idle {
+    {SeriesPriority::Low, 0.1, 0},
+    {SeriesPriority::Normal, 0.1, 0},
+  };
+  controller.update(idle, 1.0);
+  EXPECT_EQ(controller.decimation(SeriesPriority::Normal), 2ul);
+  EXPECT_EQ(controller.decimation(SeriesPriority::Low), OverloadController::MAX_DECIMATION);
+  for (int i = 0; i < 7; i++) {
+    controller.update(idle, 1.0);
+  }
+  EXPECT_EQ(controller.decimation(SeriesPriority::Normal), 1ul);
+  EXPECT_EQ(controller.decimation(SeriesPriority::Low), 1ul);
+  EXPECT_FALSE(controller.shedding());
+}
@@ -94,3 +94,227 @@ TEST(test_plot, sync_right_dropped_entry_filled)
   EXPECT_EQ(synced[2], 2.0);
   EXPECT_EQ(synced[3], 3.0);
 }
+
+TEST(test_plot, stamp_gap_detector_regular_stamps)
+{
+  quickplot::StampGapDetector detector;
+  for (size_t i = 0; i < 100; i++) {
+    EXPECT_FALSE(detector.update(0.001 * i));
+  }
+  EXPECT_EQ(detector.gaps(), 0ul);
+}
+
+TEST(test_plot, stamp_gap_detector_counts_missing)
+{
+  quickplot::StampGapDetector detector;
+  for (size_t i = 0; i < 10; i++) {
+    detector.update(0.01 * i);
+  }
+  // skip 3 messages
+  EXPECT_TRUE(detector.update(0.13));
+  EXPECT_FALSE(detector.update(0.14));
+  EXPECT_EQ(detector.gaps(), 1ul);
+  EXPECT_EQ(detector.missing(), 3ul);
+}
+
+TEST(test_plot, stamp_gap_detector_restarts_after_jump_back)
+{
+  quickplot::StampGapDetector detector;
+  for (size_t i = 0; i < 10; i++) {
+    detector.update(10.0 + 0.1 * i);
+  }
+  EXPECT_FALSE(detector.update(0.0));
+  // new period is estimated from the following steps
+  EXPECT_FALSE(detector.update(1.0));
+  EXPECT_FALSE(detector.update(2.0));
+  EXPECT_EQ(detector.gaps(), 0ul);
+}
+
+TEST(test_plot, stamp_gap_detector_adapts_to_rate_change)
+{
+  quickplot::StampGapDetector detector;
+  double t = 0.0;
+  for (size_t i = 0; i < 10; i++) {
+    detector.update(t += 0.01);
+  }
+  for (size_t i = 0; i < 10; i++) {
+    detector.update(t += 0.1);
+  }
+  auto gaps = detector.gaps();
+  EXPECT_FALSE(detector.update(t += 0.1));
+  EXPECT_EQ(detector.gaps(), gaps);
+}
+
+TEST(test_plot, buffer_records_latency_of_first_draw)
+{
+  using std::chrono::milliseconds;
+  quickplot::PlotDataBuffer buffer(4);
+  auto received = std::chrono::steady_clock::now().time_since_epoch();
+  quickplot::SampleTiming timing {
+    .received = received,
+    .stamp_latency = milliseconds(2).count() * 1000000,
+  };
+  buffer.push(1.0, 1.0, timing, std::chrono::steady_clock::now().time_since_epoch());
+  buffer.push(2.0, 2.0, timing, std::chrono::steady_clock::now().time_since_epoch());
+  buffer.push(3.0, 3.0);
+
+  auto drawn = std::chrono::steady_clock::now().time_since_epoch() + milliseconds(10);
+  buffer.mark_drawn(3.0, drawn);
+  // no new samples since the last frame
+  buffer.mark_drawn(4.0, drawn + milliseconds(10));
+
+  const auto * latency = buffer.latency();
+  ASSERT_NE(latency, nullptr);
+  EXPECT_EQ(latency->stamp_to_receive.summary(drawn).count, 2ul);
+  EXPECT_EQ(latency->receive_to_commit.summary(drawn).count, 2ul);
+  EXPECT_EQ(latency->commit_to_draw.summary(drawn).count, 1ul);
+  auto stamp_to_draw = latency->stamp_to_draw.summary(drawn);
+  ASSERT_EQ(stamp_to_draw.count, 1ul);
+  EXPECT_GE(stamp_to_draw.max, 12000000ul);
+
+  auto series = buffer.latency_series();
+  ASSERT_EQ(series.size(), 1ul);
+  EXPECT_EQ(series[0].x, 3.0);
+  EXPECT_GE(series[0].y, 12.0);
+}
+
+TEST(test_plot, buffer_without_received_samples_has_no_latency)
+{
+  quickplot::PlotDataBuffer buffer(4);
+  buffer.push(1.0, 1.0);
+  buffer.mark_drawn(1.0, std::chrono::steady_clock::now().time_since_epoch());
+  EXPECT_EQ(buffer.latency(), nullptr);
+  EXPECT_TRUE(buffer.latency_series().empty());
+  EXPECT_EQ(buffer.memory_usage().reserved, 4 * sizeof(ImPlotPoint));
+}
+
+TEST(test_plot, buffer_restores_history_older_than_received)
+{
+  quickplot::PlotDataBuffer buffer(2);
+  buffer.push(3.0, 30.0);
+  buffer.push(4.0, 40.0);
+  // the sample at 3.0 overlaps with the received data and is skipped
+  std::vector<quickplot::Sample> history {{1.0, 10.0}, {2.0, 20.0}, {3.0, 99.0}};
+  buffer.restore(history.data(), history.size());
+
+  auto restored = buffer.snapshot(2.0);
+  ASSERT_EQ(restored.size(), 3ul);
+  EXPECT_EQ(restored[0].y, 20.0);
+  EXPECT_EQ(restored[1].y, 30.0);
+  EXPECT_EQ(restored[2].y, 40.0);
+  EXPECT_EQ(buffer.snapshot(0.0).size(), 4ul);
+}
+
+TEST(test_plot, buffer_inserts_late_samples_in_order)
+{
+  quickplot::PlotDataBuffer buffer(2);
+  buffer.set_reorder_window(1.0);
+  buffer.push(1.0, 1.0);
+  buffer.push(3.0, 3.0);
+  buffer.push(2.0, 2.0);
+  buffer.push(2.5, 2.5);
+  // older than the reorder window
+  buffer.push(1.5, 1.5);
+  buffer.push_batch({ImPlotPoint(4.0, 4.0), ImPlotPoint(3.5, 3.5)});
+
+  auto data = buffer.snapshot(0.0);
+  std::vector<double> x;
+  for (const auto & sample : data) {
+    x.push_back(sample.x);
+  }
+  EXPECT_THAT(x, testing::ElementsAre(1.0, 2.0, 2.5, 3.0, 3.5, 4.0));
+  EXPECT_EQ(buffer.late_samples(), 1ul);
+}
+
+TEST(test_plot, run_length_buffer_stores_transitions)
+{
+  quickplot::PlotDataBuffer buffer(1);
+  buffer.set_run_length(true);
+  for (int i = 0; i < 100; i++) {
+    buffer.push(i * 0.01, i < 50 ? 0.0 : 1.0);
+  }
+  {
+    auto data = buffer.data();
+    ASSERT_EQ(data->size(), 2ul);
+    EXPECT_EQ(data->begin()[1].x, 0.5);
+    EXPECT_EQ(data->run_end(), 0.99);
+  }
+  // samples older than the newest sample cannot be inserted into past runs
+  buffer.push(0.2, 1.0);
+  EXPECT_EQ(buffer.late_samples(), 1ul);
+
+  // the state at the start of the window is kept
+  buffer.clear_data_up_to(rclcpp::Time(0, 700000000));
+  auto samples = buffer.snapshot(0.7);
+  ASSERT_EQ(samples.size(), 2ul);
+  EXPECT_EQ(samples[0].x, 0.5);
+  EXPECT_EQ(samples[1].x, 0.99);
+
+  quickplot::PlotDataBuffer restored(1);
+  restored.set_run_length(true);
+  restored.restore(samples.data(), samples.size());
+  restored.push(1.5, 1.0);
+  restored.push(2.0, 0.0);
+  auto data = restored.data();
+  ASSERT_EQ(data->size(), 2ul);
+  EXPECT_EQ(data->begin()[0].x, 0.5);
+  EXPECT_EQ(data->begin()[1].x, 2.0);
+}
+
+TEST(test_plot, aggregate_reduces_buckets_of_all_members)
+{
+  quickplot::AggregateSeries aggregate(
+    "min", quickplot::AggregateConfig {
+    .op = quickplot::AggregateOperator::Min,
+    .bucket = 1.0,
+  });
+  auto a = std::make_shared<quickplot::PlotDataBuffer>(1);
+  auto b = std::make_shared<quickplot::PlotDataBuffer>(1);
+  aggregate.add_member("/robot_01/battery", nullptr, a);
+  aggregate.add_member("/robot_02/battery", nullptr, b);
+  EXPECT_EQ(aggregate.member_count(), 2ul);
+
+  for (int t = 0; t < 5; t++) {
+    a->push(t + 0.1, 50.0 - t);
+    b->push(t + 0.2, 60.0 - 2 * t);
+  }
+  // members only forward their samples
+  EXPECT_TRUE(a->empty());
+
+  // the newest two buckets are still open
+  auto data = aggregate.data()->snapshot(0.0);
+  ASSERT_EQ(data.size(), 3ul);
+  EXPECT_EQ(data[0].x, 0.5);
+  EXPECT_EQ(data[0].y, 50.0);
+  EXPECT_EQ(data[2].y, 48.0);
+
+  // bucket 0 is already written
+  b->push(0.9, 0.0);
+  EXPECT_EQ(aggregate.late_samples(), 1ul);
+}
+
+TEST(test_plot, aggregate_continues_after_restored_output)
+{
+  quickplot::AggregateSeries aggregate(
+    "max", quickplot::AggregateConfig {
+    .op = quickplot::AggregateOperator::Max,
+    .bucket = 1.0,
+  });
+  std::vector<quickplot::Sample> history {{0.5, 1.0}, {1.5, 2.0}};
+  aggregate.restore(history.data(), history.size());
+  auto member = std::make_shared<quickplot::PlotDataBuffer>(1);
+  aggregate.add_member("/robot_01/battery", nullptr, member);
+  // imported members have no subscription
+  EXPECT_TRUE(aggregate.member_subscriptions().empty());
+
+  // bucket 1 was written by the previous run
+  member->push(1.9, 5.0);
+  EXPECT_EQ(aggregate.late_samples(), 1ul);
+  for (int t = 2; t < 5; t++) {
+    member->push(t + 0.1, t);
+  }
+  auto data = aggregate.data()->snapshot(0.0);
+  ASSERT_EQ(data.size(), 3ul);
+  EXPECT_EQ(data[1].y, 2.0);
+  EXPECT_EQ(data[2].x, 2.5);
+}
@@ -0,0 +1,90 @@
+#include <gmock/gmock.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "quickplot/push.hpp"
+
+using quickplot::Sample;
+
+TEST(test_push, registers_series_by_name) {
+  auto series = quickplot::register_push_series("test_push/registers");
+  EXPECT_EQ(series, quickplot::register_push_series("test_push/registers"));
+  EXPECT_EQ(series->name(), "test_push/registers");
+  EXPECT_THAT(
+    quickplot::push_series_names(), ::testing::Contains("test_push/registers"));
+}
+
+TEST(test_push, keeps_samples_while_read) {
+  quickplot::PushSeries series("keeps", 1024);
+  std::vector<Sample> out;
+  // nothing plots the series yet
+  series.push(0.0, 1.0);
+  EXPECT_EQ(series.drain(out), 0lu);
+  EXPECT_EQ(series.pushed(), 1u);
+
+  series.add_reader();
+  series.push(1.0, 2.0);
+  double t[] = {2.0, 3.0};
+  double values[] = {4.0, 6.0};
+  series.push_batch(t, values, 2);
+  ASSERT_EQ(series.drain(out), 3lu);
+  EXPECT_EQ(out[0].x, 1.0);
+  EXPECT_EQ(out[2].y, 6.0);
+  EXPECT_EQ(series.drain(out), 0lu);
+
+  // samples pending when the last reader goes away are dropped
+  series.push(4.0, 8.0);
+  series.remove_reader();
+  series.push(5.0, 10.0);
+  EXPECT_EQ(series.drain(out), 0lu);
+  EXPECT_EQ(series.pushed(), 6u);
+}
+
+TEST(test_push, reader_handle_releases_series) {
+  auto reader = quickplot::read_push_series("test_push/reader");
+  auto second = quickplot::read_push_series("test_push/reader");
+  std::vector<Sample> out;
+  reader->push(1.0, 1.0);
+  reader.reset();
+  // the second reader still reads the series
+  EXPECT_EQ(second->drain(out), 1lu);
+  second->push(2.0, 2.0);
+  second.reset();
+  EXPECT_EQ(quickplot::register_push_series("test_push/reader")->drain(out), 0lu);
+}
+
+TEST(test_push, drops_samples_beyond_capacity) {
+  // capacity is split across the shards of the producing threads
+  quickplot::PushSeries series("drops", 16 * 4);
+  std::vector<Sample> out;
+  series.add_reader();
+  std::vector<Sample> samples(10, Sample {1.0, 1.0});
+  series.push_batch(samples.data(), samples.size());
+  EXPECT_EQ(series.dropped(), 6u);
+  EXPECT_EQ(series.drain(out), 4lu);
+}
+
+TEST(test_push, merges_threads_in_time_order) {
+  quickplot::PushSeries series("merges", 1 << 20);
+  std::vector<Sample> out;
+  series.add_reader();
+  const size_t thread_count = 4;
+  const size_t per_thread = 10000;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; i++) {
+    threads.emplace_back(
+      [&series, i] {
+        for (size_t j = 0; j < per_thread; j++) {
+          series.push(static_cast<double>(j * thread_count + i), static_cast<double>(i));
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(series.drain(out), thread_count * per_thread);
+  EXPECT_EQ(series.dropped(), 0u);
+  for (size_t i = 0; i < out.size(); i++) {
+    ASSERT_EQ(out[i].x, static_cast<double>(i));
+  }
+}
@@ -0,0 +1,129 @@
+#include <gmock/gmock.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "quickplot/scheduler.hpp"
+
+using namespace std::chrono_literals;
+using quickplot::TaskPriority;
+using quickplot::TaskScheduler;
+
+TEST(test_scheduler, runs_all_tasks_before_destruction) {
+  std::atomic<int> executed {0};
+  {
+    TaskScheduler scheduler(4);
+    EXPECT_EQ(scheduler.workers(), 4ul);
+    for (int i = 0; i < 1000; i++) {
+      scheduler.submit(
+        i % 2 ? TaskPriority::Ingest : TaskPriority::Analysis, [&executed] {++executed;});
+    }
+  }
+  EXPECT_EQ(executed, 1000);
+}
+
+TEST(test_scheduler, runs_queued_background_tasks_after_shutdown) {
+  std::atomic<int> executed {0};
+  {
+    // three workers share two background slots, so one waits for a slot during shutdown
+    TaskScheduler scheduler(3);
+    for (int i = 0; i < 8; i++) {
+      scheduler.submit(
+        TaskPriority::Analysis, [&executed] {
+          std::this_thread::sleep_for(5ms);
+          ++executed;
+        });
+    }
+  }
+  EXPECT_EQ(executed, 8);
+}
+
+TEST(test_scheduler, ingest_runs_before_queued_background_tasks) {
+  TaskScheduler scheduler(1);
+  std::mutex mutex;
+  std::condition_variable released;
+  bool release = false;
+  std::atomic<bool> blocked {false};
+  std::vector<TaskPriority> order;
+  // block the only worker, so the following tasks are queued
+  scheduler.submit(
+    TaskPriority::Ingest, [&] {
+      blocked = true;
+      std::unique_lock<std::mutex> lock(mutex);
+      released.wait(lock, [&] {return release;});
+    });
+  while (!blocked) {
+    std::this_thread::sleep_for(1ms);
+  }
+  for (auto priority : {TaskPriority::Export, TaskPriority::Analysis, TaskPriority::Ingest}) {
+    scheduler.submit(
+      priority, [&mutex, &order, priority] {
+        std::unique_lock<std::mutex> lock(mutex);
+        order.push_back(priority);
+      });
+  }
+  EXPECT_EQ(scheduler.stats().queued[0], 1ul);
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    release = true;
+  }
+  released.notify_all();
+  while (scheduler.stats().executed[3] == 0) {
+    std::this_thread::sleep_for(1ms);
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  EXPECT_THAT(
+    order, ::testing::ElementsAre(
+      TaskPriority::Ingest, TaskPriority::Analysis, TaskPriority::Export));
+}
+
+TEST(test_scheduler, background_tasks_leave_a_worker_for_ingest) {
+  TaskScheduler scheduler(2);
+  std::atomic<bool> release {false};
+  std::atomic<int> background_started {0};
+  // background tasks which would occupy both workers
+  for (int i = 0; i < 2; i++) {
+    scheduler.submit(
+      TaskPriority::Export, [&] {
+        ++background_started;
+        while (!release) {
+          std::this_thread::sleep_for(1ms);
+        }
+      });
+  }
+  std::this_thread::sleep_for(20ms);
+  EXPECT_EQ(background_started, 1);
+
+  std::atomic<bool> ingested {false};
+  scheduler.submit(TaskPriority::Ingest, [&] {ingested = true;});
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!ingested && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_TRUE(ingested);
+  release = true;
+}
+
+TEST(test_scheduler, idle_workers_steal_tasks) {
+  TaskScheduler scheduler(4);
+  std::atomic<int> executed {0};
+  // tasks spawned by a task are queued on its worker, others have to steal them
+  scheduler.submit(
+    TaskPriority::Ingest, [&] {
+      for (int i = 0; i < 100; i++) {
+        scheduler.submit(
+          TaskPriority::Ingest, [&executed] {
+            std::this_thread::sleep_for(100us);
+            ++executed;
+          });
+      }
+    });
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (executed < 100 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_EQ(executed, 100);
+  EXPECT_GT(scheduler.stats().steals, 0ul);
+}
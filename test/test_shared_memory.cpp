@@ -0,0 +1,155 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <gmock/gmock.h>
+#include <string>
+#include <vector>
+#include "quickplot/shared_memory.hpp"
+
+using quickplot::Sample;
+using quickplot::SharedSeriesReader;
+using quickplot::SharedSeriesWriter;
+using ::testing::StartsWith;
+using ::testing::StrEq;
+
+TEST(test_shared_memory, segment_name_is_escaped)
+{
+  auto name = quickplot::shared_segment_name("/cmd_vel/twist.linear.x");
+  EXPECT_THAT(name, StartsWith("/quickplot_cmd_vel_twist_linear_x_"));
+  EXPECT_EQ(name.find('/', 1), std::string::npos);
+  EXPECT_NE(name, quickplot::shared_segment_name("/cmd_vel/twist.linear_x"));
+}
+
+TEST(test_shared_memory, open_without_writer_fails)
+{
+  EXPECT_EQ(SharedSeriesReader::open("/test_shared_memory/missing"), nullptr);
+}
+
+TEST(test_shared_memory, reader_receives_new_samples)
+{
+  SharedSeriesWriter writer("/test_shared_memory/attach", "/test_shared_memory", 8);
+  writer.push(0.0, 0.0);
+  auto reader = SharedSeriesReader::open("/test_shared_memory/attach");
+  ASSERT_NE(reader, nullptr);
+  EXPECT_THAT(reader->topic_name(), StrEq("/test_shared_memory"));
+
+  std::vector<Sample> samples;
+  EXPECT_EQ(reader->read(samples), 1ul);
+  writer.push(1.0, 2.0);
+  writer.push(2.0, 4.0);
+  EXPECT_EQ(reader->read(samples), 2ul);
+  ASSERT_EQ(samples.size(), 3ul);
+  EXPECT_EQ(samples[2].x, 2.0);
+  EXPECT_EQ(samples[2].y, 4.0);
+  EXPECT_EQ(reader->read(samples), 0ul);
+}
+
+TEST(test_shared_memory, slow_reader_skips_overwritten_samples)
+{
+  SharedSeriesWriter writer("/test_shared_memory/overrun", "/test_shared_memory", 4);
+  auto reader = SharedSeriesReader::open("/test_shared_memory/overrun");
+  ASSERT_NE(reader, nullptr);
+  for (int i = 0; i < 10; i++) {
+    writer.push(i, i);
+  }
+  std::vector<Sample> samples;
+  reader->read(samples);
+  // the slot of the oldest sample in the ring is the next one to be overwritten
+  ASSERT_EQ(samples.size(), 3ul);
+  EXPECT_EQ(samples.front().x, 7.0);
+  EXPECT_EQ(samples.back().x, 9.0);
+  EXPECT_EQ(reader->overrun(), 7ul);
+}
+
+TEST(test_shared_memory, clear_is_visible_to_reader)
+{
+  SharedSeriesWriter writer("/test_shared_memory/clear", "/test_shared_memory", 4);
+  auto reader = SharedSeriesReader::open("/test_shared_memory/clear");
+  ASSERT_NE(reader, nullptr);
+  writer.push(0.0, 0.0);
+  writer.clear();
+  writer.push(1.0, 1.0);
+  EXPECT_TRUE(reader->cleared());
+  EXPECT_FALSE(reader->cleared());
+  std::vector<Sample> samples;
+  reader->read(samples);
+  ASSERT_EQ(samples.size(), 1ul);
+  EXPECT_EQ(samples[0].x, 1.0);
+}
+
+TEST(test_shared_memory, store_allows_single_writer_per_series)
+{
+  quickplot::SharedSeriesStore store(4);
+  auto writer = store.export_series("/test_shared_memory/store", "/test_shared_memory");
+  ASSERT_NE(writer, nullptr);
+  EXPECT_EQ(store.export_series("/test_shared_memory/store", "/test_shared_memory"), nullptr);
+  writer.reset();
+  EXPECT_NE(store.export_series("/test_shared_memory/store", "/test_shared_memory"), nullptr);
+}
+
+TEST(test_shared_memory, live_writer_is_not_replaced)
+{
+  SharedSeriesWriter writer("/test_shared_memory/live", "/test_shared_memory", 4);
+  EXPECT_THROW(
+    SharedSeriesWriter("/test_shared_memory/live", "/test_shared_memory", 4),
+    quickplot::shared_memory_error);
+  // the first writer keeps exporting
+  auto reader = SharedSeriesReader::open("/test_shared_memory/live");
+  ASSERT_NE(reader, nullptr);
+  writer.push(1.0, 2.0);
+  std::vector<Sample> samples;
+  EXPECT_EQ(reader->read(samples), 1ul);
+}
+
+TEST(test_shared_memory, stale_segment_is_replaced)
+{
+  // segment of a writer which exited before initializing its header
+  auto name = quickplot::shared_segment_name("/test_shared_memory/stale");
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(ftruncate(fd, sizeof(quickplot::SharedSeriesHeader)), 0);
+  close(fd);
+  SharedSeriesWriter writer("/test_shared_memory/stale", "/test_shared_memory", 4);
+  EXPECT_NE(SharedSeriesReader::open("/test_shared_memory/stale"), nullptr);
+}
+
+TEST(test_shared_memory, reader_follows_restarted_writer_after_crash)
+{
+  int ready[2];
+  ASSERT_EQ(pipe(ready), 0);
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    // killed below, so the writer never closes and unlinks its segment
+    SharedSeriesWriter writer("/test_shared_memory/crash", "/test_shared_memory", 4);
+    writer.push(1.0, 1.0);
+    char c = 0;
+    if (write(ready[1], &c, 1) != 1) {
+      _exit(1);
+    }
+    pause();
+    _exit(0);
+  }
+  char c;
+  ASSERT_EQ(read(ready[0], &c, 1), 1);
+  close(ready[0]);
+  close(ready[1]);
+  auto reader = SharedSeriesReader::open("/test_shared_memory/crash");
+  ASSERT_NE(reader, nullptr);
+  std::vector<Sample> samples;
+  EXPECT_EQ(reader->read(samples), 1ul);
+
+  ASSERT_EQ(kill(child, SIGKILL), 0);
+  ASSERT_EQ(waitpid(child, nullptr, 0), child);
+  SharedSeriesWriter writer("/test_shared_memory/crash", "/test_shared_memory", 4);
+  writer.push(2.0, 2.0);
+  samples.clear();
+  // the writer process is checked every few reads
+  for (int i = 0; i < 1000 && samples.empty(); i++) {
+    reader->read(samples);
+  }
+  ASSERT_EQ(samples.size(), 1ul);
+  EXPECT_EQ(samples[0].x, 2.0);
+}
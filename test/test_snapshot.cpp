@@ -0,0 +1,71 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "quickplot/snapshot.hpp"
+
+using quickplot::Snapshot;
+using quickplot::Sample;
+using quickplot::SnapshotSeries;
+
+namespace fs = std::filesystem;
+
+static fs::path temp_snapshot_path(const std::string & name)
+{
+  return fs::temp_directory_path() / ("quickplot_test_" + std::to_string(getpid()) + "_" + name);
+}
+
+TEST(test_snapshot, round_trip)
+{
+  auto path = temp_snapshot_path("round_trip");
+  std::vector<SnapshotSeries> series {
+    {"/a.data", {{1.0, 10.0}, {2.0, 20.0}, {3.0, 30.0}}},
+    {"/b.pose.position.x", {}},
+    {"/c.data", {{5.0, -1.0}}},
+  };
+  quickplot::write_snapshot(path, series);
+
+  auto snapshot = Snapshot::open(path);
+  ASSERT_NE(snapshot, nullptr);
+  EXPECT_EQ(snapshot->series_count(), 3u);
+
+  auto [a, a_count] = snapshot->find("/a.data");
+  ASSERT_EQ(a_count, 3u);
+  EXPECT_EQ(a[0].x, 1.0);
+  EXPECT_EQ(a[2].y, 30.0);
+
+  auto [b, b_count] = snapshot->find("/b.pose.position.x");
+  EXPECT_EQ(b_count, 0u);
+
+  auto [c, c_count] = snapshot->find("/c.data");
+  ASSERT_EQ(c_count, 1u);
+  EXPECT_EQ(c[0].y, -1.0);
+
+  auto [missing, missing_count] = snapshot->find("/missing");
+  EXPECT_EQ(missing, nullptr);
+  EXPECT_EQ(missing_count, 0u);
+
+  snapshot.reset();
+  fs::remove(path);
+}
+
+TEST(test_snapshot, invalid_file_is_ignored)
+{
+  EXPECT_EQ(Snapshot::open(temp_snapshot_path("does_not_exist")), nullptr);
+
+  auto path = temp_snapshot_path("invalid");
+  {
+    std::ofstream fout(path);
+    fout << "not a snapshot, but long enough for a header";
+  }
+  EXPECT_EQ(Snapshot::open(path), nullptr);
+
+  // truncating a valid snapshot leaves sample offsets out of bounds
+  quickplot::write_snapshot(path, {{"/a.data", {{1.0, 1.0}, {2.0, 2.0}}}});
+  fs::resize_file(path, fs::file_size(path) - sizeof(Sample));
+  EXPECT_EQ(Snapshot::open(path), nullptr);
+  fs::remove(path);
+}
@@ -0,0 +1,190 @@
+#include <gmock/gmock.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+#include "quickplot/socket_source.hpp"
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+using quickplot::SocketDatagram;
+using quickplot::Sample;
+
+TEST(test_socket_source, parse_endpoint) {
+  auto udp = quickplot::parse_socket_endpoint("udp:9870");
+  EXPECT_EQ(udp.type, quickplot::SocketType::Udp);
+  EXPECT_EQ(udp.port, 9870);
+  auto unix_socket = quickplot::parse_socket_endpoint("unix:/tmp/quickplot.sock");
+  EXPECT_EQ(unix_socket.type, quickplot::SocketType::Unix);
+  EXPECT_EQ(unix_socket.path, "/tmp/quickplot.sock");
+
+  for (const auto & endpoint : {"", "udp:", "udp:0", "udp:70000", "udp:12ab", "unix:", "tcp:80"}) {
+    EXPECT_THROW(quickplot::parse_socket_endpoint(endpoint), quickplot::socket_error) <<
+      endpoint;
+  }
+}
+
+TEST(test_socket_source, binary_roundtrip) {
+  auto nan = std::numeric_limits<double>::quiet_NaN();
+  auto datagram = quickplot::encode_socket_datagram(
+    "motor/current", {{1.0, 0.5}, {2.0, -0.5}, {nan, 3.0}});
+  SocketDatagram decoded;
+  ASSERT_TRUE(
+    quickplot::decode_socket_datagram(datagram.data(), datagram.size(), 10.0, decoded));
+  EXPECT_EQ(decoded.channel, "motor/current");
+  ASSERT_EQ(decoded.samples.size(), 3lu);
+  EXPECT_EQ(decoded.samples[1].x, 2.0);
+  EXPECT_EQ(decoded.samples[1].y, -0.5);
+  // samples without time are stamped on receive
+  EXPECT_EQ(decoded.samples[2].x, 10.0);
+
+  // truncated datagrams are rejected
+  EXPECT_FALSE(
+    quickplot::decode_socket_datagram(datagram.data(), datagram.size() - 1, 10.0, decoded));
+  EXPECT_FALSE(quickplot::decode_socket_datagram(datagram.data(), 4, 10.0, decoded));
+}
+
+TEST(test_socket_source, json) {
+  SocketDatagram decoded;
+  std::string single = R"({"channel": "battery", "t": 1.5, "value": 12.25})";
+  ASSERT_TRUE(quickplot::decode_socket_datagram(single.data(), single.size(), 10.0, decoded));
+  EXPECT_EQ(decoded.channel, "battery");
+  ASSERT_EQ(decoded.samples.size(), 1lu);
+  EXPECT_EQ(decoded.samples[0].x, 1.5);
+  EXPECT_EQ(decoded.samples[0].y, 12.25);
+
+  std::string untimed = R"({"channel": "battery", "value": 12})";
+  ASSERT_TRUE(quickplot::decode_socket_datagram(untimed.data(), untimed.size(), 10.0, decoded));
+  EXPECT_EQ(decoded.samples[0].x, 10.0);
+
+  std::string batch = R"({"channel": "battery", "samples": [[1, 2], [3, 4]]})";
+  ASSERT_TRUE(quickplot::decode_socket_datagram(batch.data(), batch.size(), 10.0, decoded));
+  ASSERT_EQ(decoded.samples.size(), 2lu);
+  EXPECT_EQ(decoded.samples[1].x, 3.0);
+  EXPECT_EQ(decoded.samples[1].y, 4.0);
+
+  for (std::string invalid : {R"({"channel": "battery"})", R"({"value": 1})", "{not json"}) {
+    EXPECT_FALSE(
+      quickplot::decode_socket_datagram(invalid.data(), invalid.size(), 10.0, decoded)) <<
+      invalid;
+  }
+}
+
+TEST(test_socket_source, receives_plotted_channels) {
+  auto path = (fs::temp_directory_path() / "quickplot_test_socket.sock").string();
+  quickplot::SocketSource source(
+    "unix:" + path, 16, std::make_shared<quickplot::FakeIngestClock>());
+  auto buffer = source.channel("plotted");
+
+  int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  ASSERT_GE(fd, 0);
+  sockaddr_un address {};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  auto send = [&](const std::string & datagram) {
+      sendto(
+        fd, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr *>(&address),
+        sizeof(address));
+    };
+  for (int i = 0; i < 100; i++) {
+    send(
+      quickplot::encode_socket_datagram(
+        "plotted", {{i * 1.0, i * 10.0}, {i + 0.5, i * 10.0 + 5.0}}));
+    send(quickplot::encode_socket_datagram("unplotted", {{i * 1.0, 0.0}}));
+  }
+  send("garbage");
+  close(fd);
+
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (source.datagrams() < 201 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_EQ(source.datagrams(), 201u);
+  EXPECT_EQ(source.samples(), 300u);
+  EXPECT_EQ(source.malformed(), 1u);
+  EXPECT_THAT(source.channel_names(), ::testing::ElementsAre("plotted", "unplotted"));
+
+  auto data = buffer->data();
+  ASSERT_EQ(data->size(), 200lu);
+  EXPECT_EQ(data->begin()[1].x, 0.5);
+  EXPECT_EQ(data->begin()[199].y, 995.0);
+}
+
+TEST(test_socket_source, caps_unplotted_channels) {
+  auto path = (fs::temp_directory_path() / "quickplot_test_socket_cap.sock").string();
+  quickplot::SocketSource source(
+    "unix:" + path, 64, std::make_shared<quickplot::FakeIngestClock>());
+
+  int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  ASSERT_GE(fd, 0);
+  sockaddr_un address {};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  auto count = quickplot::SOCKET_MAX_CHANNELS + 10;
+  for (size_t i = 0; i < count; i++) {
+    auto datagram = quickplot::encode_socket_datagram("channel" + std::to_string(i), {{0.0, 0.0}});
+    sendto(
+      fd, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr *>(&address),
+      sizeof(address));
+  }
+  close(fd);
+
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (source.datagrams() < count && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  ASSERT_EQ(source.datagrams(), count);
+  EXPECT_EQ(source.channel_names().size(), quickplot::SOCKET_MAX_CHANNELS);
+  EXPECT_EQ(source.untracked(), 10u);
+  // plotted channels are tracked regardless
+  source.channel("plotted");
+  EXPECT_EQ(source.channel_names().size(), quickplot::SOCKET_MAX_CHANNELS + 1);
+}
+
+TEST(test_socket_source, stamps_untimed_samples_with_node_clock) {
+  auto path = (fs::temp_directory_path() / "quickplot_test_socket_clock.sock").string();
+  // the node clock runs on simulation time, far from the wall time
+  quickplot::SocketSource source(
+    "unix:" + path, 16, std::make_shared<quickplot::FakeIngestClock>(
+      rclcpp::Time(5, 0, RCL_ROS_TIME)));
+  auto buffer = source.channel("untimed");
+
+  int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  ASSERT_GE(fd, 0);
+  sockaddr_un address {};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  auto datagram = quickplot::encode_socket_datagram(
+    "untimed", {{std::numeric_limits<double>::quiet_NaN(), 1.0}});
+  sendto(
+    fd, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr *>(&address),
+    sizeof(address));
+  close(fd);
+
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (source.samples() < 1 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  auto data = buffer->data();
+  ASSERT_EQ(data->size(), 1lu);
+  EXPECT_EQ(data->begin()[0].x, 5.0);
+}
+
+TEST(test_socket_source, keeps_files_which_are_not_sockets) {
+  auto path = fs::temp_directory_path() / "quickplot_test_socket_file";
+  { std::ofstream(path) << "data"; }
+  EXPECT_THROW(
+    quickplot::SocketSource(
+      "unix:" + path.string(), 16, std::make_shared<quickplot::FakeIngestClock>()),
+    quickplot::socket_error);
+  EXPECT_TRUE(fs::exists(path));
+  fs::remove(path);
+}
@@ -0,0 +1,94 @@
+#include <gmock/gmock.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include <rosidl_typesupport_introspection_cpp/field_types.hpp>
+#include "quickplot/introspection.hpp"
+#include "quickplot/message_parser.hpp"
+#include "quickplot/typed_subscription.hpp"
+
+namespace ts = rosidl_typesupport_introspection_cpp;
+
+static void set_numeric(void * n, uint8_t type_id, double value)
+{
+  switch (type_id) {
+    case ts::ROS_TYPE_FLOAT:
+      *static_cast<float *>(n) = static_cast<float>(value);
+      break;
+    case ts::ROS_TYPE_DOUBLE:
+      *static_cast<double *>(n) = value;
+      break;
+    case ts::ROS_TYPE_INT64:
+      *static_cast<int64_t *>(n) = static_cast<int64_t>(value);
+      break;
+    case ts::ROS_TYPE_INT32:
+      *static_cast<int32_t *>(n) = static_cast<int32_t>(value);
+      break;
+    default:
+      FAIL() << "unexpected type id " << static_cast<int>(type_id);
+  }
+}
+
+static quickplot::MemberSequencePathDescriptor parse_path(const std::string & path)
+{
+  std::vector<std::string> names;
+  boost::split(names, path, boost::is_any_of("."));
+  quickplot::MemberSequencePathDescriptor descriptor;
+  for (const auto & name : names) {
+    descriptor.push_back({name, std::nullopt});
+  }
+  return descriptor;
+}
+
+TEST(test_typed_subscription, field_getters_match_introspection)
+{
+  for (const auto & [type, support] : quickplot::typed_message_registry()) {
+    auto introspection = std::make_shared<quickplot::MessageIntrospection>(type);
+    quickplot::IntrospectionMessageDeserializer deserializer(introspection);
+    auto buffer = deserializer.init_buffer();
+
+    // write a distinct value to every registered field
+    double value = 1.0;
+    for (const auto & [path, _] : support.fields) {
+      auto member_path = introspection->get_member_sequence_path(parse_path(path));
+      ASSERT_TRUE(member_path.has_value()) << type << " has no member " << path;
+      auto memory = buffer.data();
+      for (const auto & [member, __] : member_path.value()) {
+        memory += member->offset_;
+      }
+      set_numeric(memory, member_path->back().first->type_id_, value);
+      value += 1.0;
+    }
+
+    for (const auto & [path, getter] : support.fields) {
+      auto member_path = introspection->get_member_sequence_path(parse_path(path));
+      EXPECT_EQ(
+        getter(buffer.data()),
+        quickplot::get_numeric(buffer.data(), member_path.value())) << type << " " << path;
+    }
+    deserializer.fini_buffer(buffer);
+  }
+}
+
+TEST(test_typed_subscription, unregistered_type_has_no_support)
+{
+  EXPECT_EQ(quickplot::find_typed_message_support("geometry_msgs/msg/PoseStamped"), nullptr);
+  auto support = quickplot::find_typed_message_support("geometry_msgs/msg/TwistStamped");
+  ASSERT_NE(support, nullptr);
+  EXPECT_EQ(support->find_field("twist.linear.w"), nullptr);
+  EXPECT_NE(support->find_field("twist.angular.z"), nullptr);
+}
+
+TEST(test_typed_subscription, member_chain_loads_nested_field)
+{
+  using geometry_msgs::msg::Twist;
+  using geometry_msgs::msg::TwistStamped;
+  using geometry_msgs::msg::Vector3;
+  TwistStamped msg;
+  msg.twist.angular.y = 3.0;
+  auto getter = &quickplot::load_field<TwistStamped, &TwistStamped::twist, &Twist::angular,
+      &Vector3::y>;
+  EXPECT_EQ(getter(&msg), 3.0);
+}